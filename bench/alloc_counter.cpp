@@ -0,0 +1,46 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.hpp"
+
+namespace {
+std::atomic<uint64_t> alloc_count{0};
+std::atomic<uint64_t> alloc_bytes{0};
+
+void *counted(const size_t size) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  if(void *p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc{};
+}
+
+void *counted_aligned(const size_t size, const std::align_val_t align) {
+  alloc_count.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  const auto alignment = static_cast<size_t>(align);
+  if(void *p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) return p;
+  throw std::bad_alloc{};
+}
+}
+
+jaydk::bench::alloc_stats jaydk::bench::allocations() {
+  return { alloc_count.load(std::memory_order_relaxed), alloc_bytes.load(std::memory_order_relaxed) };
+}
+
+void *operator new(const size_t size) { return counted(size); }
+void *operator new[](const size_t size) { return counted(size); }
+void *operator new(const size_t size, const std::align_val_t align) { return counted_aligned(size, align); }
+void *operator new[](const size_t size, const std::align_val_t align) { return counted_aligned(size, align); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { std::free(p); }
@@ -0,0 +1,22 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <cstdint>
+
+namespace jaydk::bench {
+struct alloc_stats {
+  uint64_t count = 0; //!< Number of calls to operator new
+  uint64_t bytes = 0; //!< Total number of bytes requested
+
+  constexpr alloc_stats operator-(const alloc_stats &other) const { return { count - other.count, bytes - other.bytes }; }
+};
+
+// totals since program start; the bench binary replaces the global operator new to keep track
+alloc_stats allocations();
+}
+
+#endif //ALLOC_COUNTER_HPP
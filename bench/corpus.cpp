@@ -0,0 +1,165 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include "corpus.hpp"
+
+using namespace jaydk::bench;
+
+namespace {
+// splitmix64: unlike the standard distributions, its output is the same on every platform
+class rng {
+public:
+  explicit rng(const uint64_t seed) : state{seed} {}
+
+  uint64_t next() {
+    uint64_t z = state += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  size_t below(const size_t n) { return static_cast<size_t>(next() % n); }
+  bool chance(const double p) { return static_cast<double>(next() >> 11) * 0x1.0p-53 < p; }
+
+private:
+  uint64_t state;
+};
+
+class generator {
+public:
+  explicit generator(const corpus_options &opts) : opts{opts}, random{opts.seed} {}
+
+  void comment(const size_t indent) {
+    if(!random.chance(opts.comment_density)) return;
+    pad(indent);
+    if(random.chance(0.5)) out += "// line comment " + std::to_string(random.next() % 1000) + "\n";
+    else out += "/* block comment\n   spanning /* nested */ lines */\n";
+  }
+
+  void operand() {
+    if(random.chance(opts.string_density)) {
+      out += "\"str" + std::to_string(random.below(100)) + (random.chance(0.2) ? "\\n\"" : "\"");
+      return;
+    }
+
+    switch(random.below(9)) {
+      case 0: out += std::to_string(random.below(100000)); break;
+      case 1: out += std::to_string(random.below(1000)) + "." + std::to_string(random.below(100)); break;
+      case 2: out += "0x" + std::to_string(random.below(0xffff)) + "u"; break;
+      case 3: out += "'" + std::string(1, static_cast<char>('a' + random.below(26))) + "'"; break;
+      case 4: out += random.chance(0.5) ? "true" : "false"; break;
+      case 5: out += "f" + std::to_string(random.below(50)) + "(x, " + std::to_string(random.below(10)) + ")"; break;
+      case 6: out += "obj.field" + std::to_string(random.below(10)); break;
+      case 7: out += "arr[" + std::to_string(random.below(10)) + "]"; break;
+      default: out += "v" + std::to_string(random.below(100)); break;
+    }
+  }
+
+  void expression() {
+    constexpr static const char *ops[] = { " + ", " - ", " * ", " / ", " % ", " << ", " & ", " | ", " && ", " == " };
+    const size_t parens = opts.expr_chain > 2 ? random.below(opts.expr_chain / 2) : 0;
+    for(size_t i = 0; i < opts.expr_chain; i++) {
+      if(i != 0) out += ops[random.below(std::size(ops))];
+      if(i < parens) out += "(";
+      operand();
+    }
+    for(size_t i = 0; i < parens; i++) out += ")";
+  }
+
+  void statement(const size_t indent, const size_t counter) {
+    pad(indent);
+    switch(random.below(4)) {
+      case 0: out += "var x" + std::to_string(counter) + " = "; expression(); out += ";\n"; break;
+      case 1:
+        out += "if(x > " + std::to_string(counter) + ") { x += "; expression(); out += "; } else { x = ";
+        expression(); out += "; }\n";
+        break;
+      case 2: out += "while(x < " + std::to_string(counter) + ") x++;\n"; break;
+      default: out += "x = "; expression(); out += ";\n"; break;
+    }
+    comment(indent);
+  }
+
+  void declaration(const size_t indent, const size_t counter) {
+    pad(indent);
+    const auto n = std::to_string(counter);
+    if(random.chance(0.5)) {
+      out += (random.chance(0.5) ? "val g" : "var g") + n + " = ";
+      expression();
+      out += ";\n";
+    }
+    else {
+      out += "fun f" + n + "(x: int, y: float): int {\n";
+      const size_t count = 2 + random.below(4);
+      for(size_t i = 0; i < count; i++) statement(indent + 1, i);
+      pad(indent + 1);
+      out += "return x;\n";
+      pad(indent);
+      out += "}\n";
+    }
+    comment(indent);
+  }
+
+  std::string program() {
+    size_t counter = 0;
+    while(out.size() < opts.size) {
+      for(size_t d = 0; d < opts.namespace_depth; d++) {
+        pad(d);
+        out += "namespace n" + std::to_string(counter) + "_" + std::to_string(d) + " {\n";
+      }
+      for(size_t i = 0; i < 8; i++) declaration(opts.namespace_depth, counter++);
+      for(size_t d = opts.namespace_depth; d > 0; d--) {
+        pad(d - 1);
+        out += "}\n";
+      }
+    }
+    return std::move(out);
+  }
+
+  std::string expressions() {
+    while(out.size() < opts.size) {
+      expression();
+      out += ";\n";
+    }
+    return std::move(out);
+  }
+
+private:
+  void pad(const size_t indent) { out.append(2 * indent, ' '); }
+
+  const corpus_options &opts;
+  rng random;
+  std::string out{};
+};
+}
+
+std::string jaydk::bench::generate_program(const corpus_options &opts) {
+  return generator{opts}.program();
+}
+
+std::string jaydk::bench::generate_expressions(const corpus_options &opts) {
+  return generator{opts}.expressions();
+}
+
+std::string jaydk::bench::generate_chain(const chain_kind kind, const size_t length) {
+  std::string out;
+  switch(kind) {
+    case chain_kind::BINARY: {
+      out = "a0";
+      for(size_t i = 1; i < length; i++) out += " + a" + std::to_string(i % 100);
+      break;
+    }
+    case chain_kind::CALL: {
+      out = "x";
+      for(size_t i = 1; i < length; i++) out += ".f" + std::to_string(i % 100) + "()";
+      break;
+    }
+    case chain_kind::SHIFT: {
+      out = "stdout";
+      for(size_t i = 1; i < length; i++) out += " << \"s" + std::to_string(i % 100) + "\"";
+      break;
+    }
+  }
+  return out + ";";
+}
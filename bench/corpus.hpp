@@ -0,0 +1,31 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace jaydk::bench {
+struct corpus_options {
+  size_t size = 1 << 20; //!< Approximate size of the program, in bytes
+  size_t namespace_depth = 3; //!< Nesting depth of the namespaces wrapping each group of declarations
+  size_t expr_chain = 8; //!< Number of operands in each generated expression
+  double comment_density = 0.2; //!< Chance of a comment after each declaration or statement
+  double string_density = 0.1; //!< Chance of an operand being a string literal
+  uint64_t seed = 42;
+};
+
+enum struct chain_kind { BINARY, CALL, SHIFT };
+
+// deterministic (for a given set of options) synthetic .jay programs that the parser accepts
+std::string generate_program(const corpus_options &opts);
+// a sequence of `;`-terminated expressions, for parse_expr micro benchmarks
+std::string generate_expressions(const corpus_options &opts);
+// a single left-associative chain of length operands (`a + a + ...`, `x.f().f()...` or `stdout << "s" << ...`)
+std::string generate_chain(chain_kind kind, size_t length);
+}
+
+#endif //CORPUS_HPP
@@ -0,0 +1,396 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "alloc_counter.hpp"
+#include "corpus.hpp"
+#include "node_count.hpp"
+
+#include "lexer/lexer.hpp"
+#include "lexer/parallel_lexer.hpp"
+#include "lexer/token_pipe.hpp"
+#include "parser/ast_cache.hpp"
+#include "parser/flat_ast.hpp"
+#include "parser/parallel_parser.hpp"
+#include "parser/parser.hpp"
+#include "semantic_checker/semantic_checker.hpp"
+#include "util/cow.hpp"
+#include "util/managed.hpp"
+
+// micro and macro benchmarks for the jayc front-end on a synthetic corpus; results are printed and written as JSON
+// usage: jaydk_bench [--size bytes] [--depth n] [--chain n] [--comments p] [--strings p] [--seed n] [--runs n]
+//                    [--label text] [--json file]
+
+using namespace jayc;
+using namespace jaydk::bench;
+using clk = std::chrono::steady_clock;
+
+struct work {
+  size_t bytes = 0; //!< Input bytes processed per run
+  size_t tokens = 0; //!< Tokens produced or consumed per run
+  size_t nodes = 0; //!< AST nodes produced or consumed per run
+};
+
+struct result {
+  std::string name;
+  std::string kind; //!< micro or macro
+  double best_ns;
+  double mean_ns;
+  work done;
+  alloc_stats allocs; //!< Per run
+};
+
+struct settings {
+  corpus_options corpus{};
+  size_t runs = 5;
+  std::string label{};
+  std::string json = "jaydk_bench.json";
+};
+
+// f runs the measured work once and reports how much it did
+result measure(const std::string &name, const std::string &kind, const size_t runs, const std::function<work()> &f) {
+  result res{ name, kind, std::numeric_limits<double>::max(), 0, {}, {} };
+  for(size_t i = 0; i < runs; i++) {
+    logger.next_phase(true);
+    const auto before = allocations();
+    const auto start = clk::now();
+    res.done = f();
+    const double ns = std::chrono::duration<double, std::nano>(clk::now() - start).count();
+    res.allocs = allocations() - before;
+    res.best_ns = std::min(res.best_ns, ns);
+    res.mean_ns += ns / static_cast<double>(runs);
+  }
+  return res;
+}
+
+volatile size_t sink; //!< Keeps results of otherwise unused work alive
+
+double per_second(const size_t amount, const double ns) { return static_cast<double>(amount) * 1e9 / ns; }
+
+std::string escape(const std::string &s) {
+  std::string res;
+  for(const char c : s) {
+    if(c == '"' || c == '\\') res += '\\';
+    res += c;
+  }
+  return res;
+}
+
+void write_json(std::ostream &out, const settings &cfg, const std::vector<result> &results) {
+  out << "{\n  \"label\": \"" << escape(cfg.label) << "\",\n  \"corpus\": { \"size\": " << cfg.corpus.size
+      << ", \"namespace_depth\": " << cfg.corpus.namespace_depth << ", \"expr_chain\": " << cfg.corpus.expr_chain
+      << ", \"comment_density\": " << cfg.corpus.comment_density << ", \"string_density\": " << cfg.corpus.string_density
+      << ", \"seed\": " << cfg.corpus.seed << " },\n  \"runs\": " << cfg.runs << ",\n  \"results\": [\n";
+  for(size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    out << "    { \"name\": \"" << r.name << "\", \"kind\": \"" << r.kind << "\", \"best_ns\": " << r.best_ns
+        << ", \"mean_ns\": " << r.mean_ns << ", \"bytes\": " << r.done.bytes << ", \"tokens\": " << r.done.tokens
+        << ", \"nodes\": " << r.done.nodes << ", \"bytes_per_s\": " << per_second(r.done.bytes, r.best_ns)
+        << ", \"tokens_per_s\": " << per_second(r.done.tokens, r.best_ns)
+        << ", \"nodes_per_s\": " << per_second(r.done.nodes, r.best_ns) << ", \"allocations\": " << r.allocs.count
+        << ", \"allocated_bytes\": " << r.allocs.bytes << " }" << (i + 1 == results.size() ? "\n" : ",\n");
+  }
+  out << "  ]\n}\n";
+}
+
+void print(const result &r) {
+  std::cout << "  " << r.kind << "/" << r.name << ": " << r.best_ns / 1e6 << " ms (mean " << r.mean_ns / 1e6 << " ms)";
+  if(r.done.bytes != 0) std::cout << ", " << per_second(r.done.bytes, r.best_ns) / (1 << 20) << " MiB/s";
+  if(r.done.tokens != 0) std::cout << ", " << per_second(r.done.tokens, r.best_ns) / 1e6 << " Mtok/s";
+  if(r.done.nodes != 0) std::cout << ", " << per_second(r.done.nodes, r.best_ns) / 1e6 << " Mnodes/s";
+  std::cout << ", " << r.allocs.count << " allocations (" << r.allocs.bytes << " bytes)\n";
+}
+
+// a complete binary tree behind either kind of owning pointer (sem trees are built from both)
+template <template <typename> typename P>
+struct tree_node {
+  uint64_t value;
+  P<tree_node> left;
+  P<tree_node> right;
+};
+
+template <typename T> using managed_ptr = jaydk::managed<T>;
+template <typename T> using cow_ptr = jaydk::cow<T>;
+
+template <template <typename> typename P>
+P<tree_node<P>> make_tree(const size_t depth, uint64_t &next) {
+  if(depth == 0) return P<tree_node<P>>{};
+  auto left = make_tree<P>(depth - 1, next);
+  auto right = make_tree<P>(depth - 1, next);
+  return P<tree_node<P>>{ tree_node<P>{ next++, std::move(left), std::move(right) } };
+}
+
+// (managed's operator bool isn't const)
+template <typename T> bool is_empty(const jaydk::managed<T> &p) { return p.operator->() == nullptr; }
+template <typename T> bool is_empty(const jaydk::cow<T> &p) { return !p.has_value(); }
+
+template <template <typename> typename P>
+uint64_t sum_tree(const P<tree_node<P>> &t) {
+  if(is_empty(t)) return 0;
+  const tree_node<P> &n = *t;
+  return n.value + sum_tree<P>(n.left) + sum_tree<P>(n.right);
+}
+
+// argument lists the way the parser builds them: each inside a node in the arena, with 0-4 arguments (2 on average)
+template <typename List>
+work build_arg_lists(const size_t lists, size_t &arena_bytes) {
+  jaydk::arena nodes;
+  const jaydk::arena::scope in{nodes};
+  std::vector<List *> built;
+  built.reserve(lists);
+  for(size_t i = 0; i < lists; i++) {
+    auto *list = nodes.make<List>();
+    for(uint32_t j = 0; j < i % 5; j++)
+      list->push_back(parser::function_decl::arg{ .type = {}, .arg_name = {}, .pos = { 0, j } });
+    built.push_back(list);
+  }
+
+  size_t args = 0;
+  size_t offsets = 0;
+  for(const auto *list : built) {
+    for(const auto &a : *list) {
+      args++;
+      offsets += a.pos.offset;
+    }
+  }
+  sink = offsets;
+  arena_bytes = nodes.bytes_used();
+  return work{ 0, 0, args };
+}
+
+settings parse_args(const int argc, const char **argv) {
+  settings cfg;
+  for(int i = 1; i + 1 < argc; i += 2) {
+    const std::string flag = argv[i];
+    const std::string value = argv[i + 1];
+    if(flag == "--size") cfg.corpus.size = std::stoull(value);
+    else if(flag == "--depth") cfg.corpus.namespace_depth = std::stoull(value);
+    else if(flag == "--chain") cfg.corpus.expr_chain = std::max<size_t>(1, std::stoull(value));
+    else if(flag == "--comments") cfg.corpus.comment_density = std::stod(value);
+    else if(flag == "--strings") cfg.corpus.string_density = std::stod(value);
+    else if(flag == "--seed") cfg.corpus.seed = std::stoull(value);
+    else if(flag == "--runs") cfg.runs = std::max<size_t>(1, std::stoull(value));
+    else if(flag == "--label") cfg.label = value;
+    else if(flag == "--json") cfg.json = value;
+    else std::cerr << "Ignoring unknown option " << flag << "\n";
+  }
+  return cfg;
+}
+
+int main(const int argc, const char **argv) {
+  const auto cfg = parse_args(argc, argv);
+  logger.mute_info();
+
+  const auto program = generate_program(cfg.corpus);
+  const auto expressions = generate_expressions(cfg.corpus);
+  const auto program_tokens = lexer::lex_source(program).drain();
+  const auto expression_tokens = lexer::lex_source(expressions).drain();
+  auto program_it = parser::token_it(program_tokens);
+  const auto program_ast = parser::build_ast(program_it);
+  const size_t program_nodes = node_count{}.all(program_ast.declarations);
+  if(logger.phase_error() != 0) std::cerr << "warning: the generated program does not parse cleanly\n";
+
+  std::cout << "corpus: " << program.size() << " bytes, " << program_tokens.size() << " tokens, "
+            << program_nodes << " nodes\n";
+
+  std::vector<result> results;
+  const auto run = [&results, &cfg](const std::string &name, const std::string &kind, const std::function<work()> &f) {
+    results.push_back(measure(name, kind, cfg.runs, f));
+    print(results.back());
+  };
+
+  run("read_token", "micro", [&program] {
+    const auto buffer = lexer::source_buffer::from_string(program);
+    const auto file = sources.add_file("<bench>", buffer);
+    lexer::cursor cur{buffer.get(), file, &sources.payloads(file), buffer->begin(), buffer->begin(), buffer->end()};
+    size_t tokens = 0;
+    while(read_token(cur).kind != lexer::token_kind::EOF_TOKEN) tokens++;
+    return work{ program.size(), tokens + 1, 0 };
+  });
+
+  run("token_stream", "micro", [&program] {
+    const auto tokens = lexer::lex_source(program).drain();
+    return work{ program.size(), tokens.size(), 0 };
+  });
+
+  run("parse_expr", "micro", [&expressions, &expression_tokens] {
+    auto it = parser::token_it(expression_tokens);
+    size_t nodes = 0;
+    while(!it.eof()) {
+      const auto expr = parser::parse_expr(it);
+      if(!expr.has_value()) break;
+      nodes += node_count{}(*expr);
+      it.consume(); // consume ;
+    }
+    return work{ expressions.size(), expression_tokens.size(), nodes };
+  });
+
+  // a single long left-associative chain; with linear parsing, the time per operand stays flat as the chain grows
+  const std::pair<chain_kind, std::string> chains[] = {
+    { chain_kind::BINARY, "binary" }, { chain_kind::CALL, "call" }, { chain_kind::SHIFT, "shift" }
+  };
+  for(const auto &[kind, kind_name] : chains) {
+    double short_per_operand = 0;
+    for(const size_t length : { size_t{1000}, size_t{10000} }) {
+      const auto source = generate_chain(kind, length);
+      const auto tokens = lexer::lex_source(source).drain();
+      run("parse_chain_" + kind_name + "_" + std::to_string(length), "micro", [&source, &tokens] {
+        auto it = parser::token_it(tokens);
+        const auto expr = parser::parse_expr(it);
+        return work{ source.size(), tokens.size(), expr.has_value() ? node_count{}(*expr) : 0 };
+      });
+
+      const double per_operand = results.back().best_ns / static_cast<double>(length);
+      if(short_per_operand == 0) short_per_operand = per_operand;
+      else std::cout << "    " << kind_name << " chain scaling (10x operands): " << per_operand / short_per_operand
+                     << "x time per operand\n";
+    }
+  }
+
+  run("build_ast", "macro", [&program, &program_tokens] {
+    auto it = parser::token_it(program_tokens);
+    const auto ast = parser::build_ast(it);
+    return work{ program.size(), program_tokens.size(), node_count{}.all(ast.declarations) };
+  });
+
+  // what hoisting needs: every declaration, but no function bodies
+  run("build_ast_lazy_bodies", "macro", [&program, &program_tokens] {
+    auto it = parser::token_it(program_tokens);
+    it.defer_bodies();
+    const auto ast = parser::build_ast(it);
+    sink = ast.nodes->bytes_used();
+    return work{ program.size(), program_tokens.size(), ast.declarations.size() };
+  });
+
+  run("flatten", "macro", [&program, &program_ast, program_nodes] {
+    const auto flat = parser::flat::flatten(program_ast);
+    return work{ program.size(), 0, program_nodes };
+  });
+
+  // whole-program traversals: pointer-chasing over the tree vs a pre-order scan over the flat arrays
+  run("walk_tree", "micro", [&program, &program_ast] {
+    return work{ program.size(), 0, node_count{}.all(program_ast.declarations) };
+  });
+
+  const auto flat_ast = parser::flat::flatten(program_ast);
+  run("walk_flat", "micro", [&program, &flat_ast] {
+    // reads every node's kind, so the walk can't be folded into `subtree_end[0]`
+    struct counter {
+      size_t nodes = 0;
+      size_t expressions = 0;
+      bool enter(const parser::flat::flat_ast &tree, const parser::flat::node_id id) {
+        nodes++;
+        expressions += parser::flat::is_expression(tree.kind[id]);
+        return true;
+      }
+    } count;
+    parser::flat::visit(flat_ast, count);
+    sink = count.expressions;
+    return work{ program.size(), 0, count.nodes - 1 }; // minus the root namespace
+  });
+  std::cout << "    memory: tree " << program_ast.nodes->bytes_used() << " bytes (arena), flat "
+            << flat_ast.memory() << " bytes\n";
+
+  // passing a subtree by value: deep copy (managed) vs a shared reference (cow)
+  constexpr size_t tree_depth = 14;
+  uint64_t next_value = 0;
+  const auto managed_tree = make_tree<managed_ptr>(tree_depth, next_value);
+  const auto cow_tree = make_tree<cow_ptr>(tree_depth, next_value = 0);
+  run("copy_tree_managed", "micro", [&managed_tree, next_value] {
+    const auto copy = managed_tree;
+    sink = sum_tree<managed_ptr>(copy);
+    return work{ 0, 0, next_value };
+  });
+  run("copy_tree_cow", "micro", [&cow_tree, next_value] {
+    const auto copy = cow_tree;
+    sink = sum_tree<cow_ptr>(copy);
+    return work{ 0, 0, next_value };
+  });
+
+  // short lists: arguments in an arena vector vs inline in the node, for a few inline capacities
+  constexpr size_t arg_lists = 100000;
+  size_t list_bytes = 0;
+  const auto bytes_per_list = [&list_bytes] {
+    std::cout << "    memory: " << list_bytes / arg_lists << " bytes per argument list (arena)\n";
+  };
+  using arg = parser::function_decl::arg;
+  run("arg_lists_arena_vector", "micro", [&list_bytes] {
+    return build_arg_lists<jaydk::arena_vector<arg>>(arg_lists, list_bytes);
+  });
+  bytes_per_list();
+  run("arg_lists_inline_1", "micro", [&list_bytes] {
+    return build_arg_lists<jaydk::arena_small_vector<arg, 1>>(arg_lists, list_bytes);
+  });
+  bytes_per_list();
+  run("arg_lists_inline_2", "micro", [&list_bytes] {
+    return build_arg_lists<jaydk::arena_small_vector<arg, 2>>(arg_lists, list_bytes);
+  });
+  bytes_per_list();
+  run("arg_lists_inline_3", "micro", [&list_bytes] {
+    return build_arg_lists<jaydk::arena_small_vector<arg, 3>>(arg_lists, list_bytes);
+  });
+  bytes_per_list();
+
+  run("check_semantics", "macro", [&program, &program_tokens, &program_ast, program_nodes] {
+    (void)sem::check_semantics(program_ast);
+    return work{ program.size(), program_tokens.size(), program_nodes };
+  });
+
+  run("lex_and_parse", "macro", [&program] {
+    auto ast = parser::parser(lexer::lex_source(program)).parse();
+    return work{ program.size(), 0, node_count{}.all(ast.declarations) };
+  });
+
+  // binary AST (--parser-out): load (hash the source, map, intern names) vs lexing and parsing from scratch
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto program_file = (dir / "jaydk_bench_program.jay").string();
+  const auto ast_file = (dir / "jaydk_bench_program.jast").string();
+  std::ofstream{program_file} << program;
+  run("ast_cache_write", "macro", [&program, &program_file, &ast_file, &flat_ast, program_nodes] {
+    sink = parser::flat::write_ast_cache(ast_file, program_file, flat_ast);
+    return work{ program.size(), 0, program_nodes };
+  });
+  run("ast_cache_load", "macro", [&program, &program_file, &ast_file, program_nodes] {
+    const auto loaded = parser::flat::mapped_ast::load(ast_file, program_file);
+    sink = loaded.has_value() ? loaded->mapped_size() : 0;
+    return work{ program.size(), 0, program_nodes };
+  });
+  std::filesystem::remove(program_file);
+  std::filesystem::remove(ast_file);
+
+  run("lex_and_parse_pipelined", "macro", [&program] {
+    auto ast = parser::parser(lexer::lex_source(program)).parse_pipelined();
+    return work{ program.size(), 0, node_count{}.all(ast.declarations) };
+  });
+
+  for(size_t threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()); threads *= 2) {
+    run("lex_parallel_" + std::to_string(threads), "macro", [&program, threads] {
+      const auto tokens = lexer::lex_source_parallel(program, threads);
+      return work{ program.size(), tokens.size(), 0 };
+    });
+  }
+
+  for(size_t threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()); threads *= 2) {
+    run("build_ast_parallel_" + std::to_string(threads), "macro", [&program, &program_tokens, threads] {
+      const auto ast = parser::build_ast_parallel(program_tokens, threads);
+      return work{ program.size(), program_tokens.size(), node_count{}.all(ast.declarations) };
+    });
+  }
+
+  std::ofstream out(cfg.json);
+  write_json(out, cfg, results);
+  std::cout << "results written to " << cfg.json << "\n";
+  return 0;
+}
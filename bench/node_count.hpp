@@ -0,0 +1,69 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef NODE_COUNT_HPP
+#define NODE_COUNT_HPP
+
+#include "parser/ast.hpp"
+
+namespace jaydk::bench {
+namespace internal_ {
+template <typename ... Fs> struct overload : Fs... { using Fs::operator()...; };
+}
+
+// number of expression, statement and declaration nodes in a (sub)tree
+struct node_count {
+  size_t operator()(const jayc::parser::expression &e) const {
+    using namespace jayc::parser;
+    return 1 + std::visit(internal_::overload{
+      [this](const unary_expr &u) { return (*this)(*u.expr); },
+      [this](const binary_expr &b) { return (*this)(*b.left) + (*this)(*b.right); },
+      [this](const ternary_expr &t) { return (*this)(*t.cond) + (*this)(*t.true_expr) + (*this)(*t.false_expr); },
+      [this](const call_expr &c) { return (*this)(*c.call) + all(c.args); },
+      [this](const index_expr &i) { return (*this)(*i.base) + (*this)(*i.index); },
+      [this](const member_expr &m) { return (*this)(*m.base); },
+      [](const auto &) { return size_t{0}; }
+    }, e.content);
+  }
+
+  size_t operator()(const jayc::parser::statement &s) const {
+    using namespace jayc::parser;
+    return 1 + std::visit(internal_::overload{
+      [this](const block &b) { return all(b.statements); },
+      [this](const expr_stmt &e) { return (*this)(e.expr); },
+      [this](const var_decl_stmt &v) { return (*this)(v.value); },
+      [this](const if_stmt &i) {
+        return (*this)(i.condition) + (*this)(*i.true_block) + (i.false_block ? (*this)(**i.false_block) : 0);
+      },
+      [this](const for_stmt &f) { return (*this)(*f.init) + (*this)(f.condition) + (*this)(f.update) + (*this)(*f.block); },
+      [this](const for_each_stmt &f) { return (*this)(f.collection) + (*this)(*f.block); },
+      [this](const while_stmt &w) { return (*this)(w.condition) + (*this)(*w.block); },
+      [this](const return_stmt &r) { return r.value ? (*this)(*r.value) : 0; },
+      [](const auto &) { return size_t{0}; }
+    }, s.content);
+  }
+
+  size_t operator()(const jayc::parser::declaration &d) const {
+    using namespace jayc::parser;
+    return 1 + std::visit(internal_::overload{
+      [this](const namespace_decl &n) { return all(n.declarations); },
+      [this](const function_decl &f) { return all(f.body.statements()); },
+      [this](const template_function_decl &f) { return all(f.base.body.statements()); },
+      [this](const ext_function_decl &f) { return all(f.body.statements()); },
+      [this](const template_ext_function_decl &f) { return all(f.base.body.statements()); },
+      [this](const global_decl &g) { return (*this)(g.value); },
+      [](const auto &) { return size_t{0}; }
+    }, d.content);
+  }
+
+  template <typename T, typename A>
+  size_t all(const std::vector<T, A> &nodes) const {
+    size_t res = 0;
+    for(const auto &n : nodes) res += (*this)(n);
+    return res;
+  }
+};
+}
+
+#endif //NODE_COUNT_HPP
@@ -0,0 +1,81 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef APPEND_ONLY_HPP
+#define APPEND_ONLY_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace jaydk {
+// an append-only table with lock-free reads: elements live in segments of doubling size that are never relocated,
+// so a reader only needs the index (and the element count, to reject indices that haven't been published yet)
+// appends serialize on a mutex; an index handed to another thread publishes the element along with it
+template <typename T> requires(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>)
+class append_only {
+public:
+  append_only() = default;
+  append_only(const append_only &) = delete;
+  append_only(append_only &&) = delete;
+  append_only &operator=(const append_only &) = delete;
+  append_only &operator=(append_only &&) = delete;
+
+  uint32_t push_back(const T &value) {
+    std::lock_guard guard{lock};
+    const uint32_t idx = count.load(std::memory_order_relaxed);
+    const auto [seg, off] = locate(idx);
+    T *data = segments[seg].load(std::memory_order_relaxed);
+    if(data == nullptr) {
+      data = new T[segment_size(seg)]{};
+      segments[seg].store(data, std::memory_order_relaxed);
+    }
+    data[off] = value;
+    count.store(idx + 1, std::memory_order_release);
+    return idx;
+  }
+
+  // T{} for indices that are out of range
+  [[nodiscard]] T operator[](const uint32_t idx) const {
+    if(idx >= count.load(std::memory_order_acquire)) return T{};
+    const auto [seg, off] = locate(idx);
+    return segments[seg].load(std::memory_order_relaxed)[off];
+  }
+
+  [[nodiscard]] uint32_t size() const { return count.load(std::memory_order_acquire); }
+
+  ~append_only() {
+    for(auto &seg : segments) delete[] seg.load(std::memory_order_relaxed);
+  }
+
+private:
+  constexpr static uint32_t first_bits = 8; //!< Segment 0 holds 2^first_bits elements, segment k > 0 2^(first_bits+k-1)
+  constexpr static size_t segment_count = 32 - first_bits + 1;
+
+  struct position {
+    size_t segment;
+    uint32_t offset;
+  };
+
+  constexpr static size_t segment_size(const size_t seg) {
+    return seg == 0 ? size_t{1} << first_bits : size_t{1} << (first_bits + seg - 1);
+  }
+
+  constexpr static position locate(const uint32_t idx) {
+    if(idx < (1u << first_bits)) return { 0, idx };
+    const auto width = static_cast<uint32_t>(std::bit_width(idx));
+    return { width - first_bits, idx - (1u << (width - 1)) };
+  }
+
+  std::mutex lock;
+  std::atomic<uint32_t> count = 0;
+  std::array<std::atomic<T *>, segment_count> segments{};
+};
+}
+
+#endif //APPEND_ONLY_HPP
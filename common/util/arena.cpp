@@ -0,0 +1,57 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "arena.hpp"
+
+using namespace jaydk;
+
+namespace {
+thread_local arena *innermost = nullptr;
+}
+
+void *arena::allocate(const size_t bytes, const size_t align) {
+  auto addr = reinterpret_cast<uintptr_t>(head);
+  auto aligned = (addr + align - 1) & ~(uintptr_t{align} - 1);
+  if(head == nullptr || aligned + bytes > reinterpret_cast<uintptr_t>(end)) {
+    // blocks double up to max_block; anything larger than that gets a block of its own
+    const size_t size = std::max(next_block, bytes + align);
+    blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+    head = blocks.back().get();
+    end = head + size;
+    reserved += size;
+    next_block = std::min(next_block * 2, max_block);
+
+    addr = reinterpret_cast<uintptr_t>(head);
+    aligned = (addr + align - 1) & ~(uintptr_t{align} - 1);
+  }
+
+  head = reinterpret_cast<std::byte *>(aligned + bytes);
+  used += bytes;
+  return reinterpret_cast<void *>(aligned);
+}
+
+std::string_view arena::copy(const std::string_view text) {
+  if(text.empty()) return {};
+  auto *data = static_cast<char *>(allocate(text.size(), 1));
+  std::memcpy(data, text.data(), text.size());
+  return { data, text.size() };
+}
+
+size_t arena::bytes_used() const { return used; }
+size_t arena::bytes_reserved() const { return reserved; }
+
+arena *arena::current() { return innermost; }
+
+arena &arena::current_or_fallback() {
+  if(innermost != nullptr) return *innermost;
+  thread_local arena fallback;
+  return fallback;
+}
+
+arena::scope::scope(arena &a) : previous{innermost} { innermost = &a; }
+arena::scope::~scope() { innermost = previous; }
@@ -0,0 +1,178 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "small_vector.hpp"
+
+namespace jaydk {
+// bump allocator; objects in it are never destroyed or freed one by one, the whole arena is released at once
+class arena {
+public:
+  constexpr static size_t first_block = 64 * 1024;
+  constexpr static size_t max_block = 16 * 1024 * 1024;
+
+  arena() = default;
+  arena(const arena &) = delete;
+  arena(arena &&) = delete;
+  arena &operator=(const arena &) = delete;
+  arena &operator=(arena &&) = delete;
+
+  void *allocate(size_t bytes, size_t align);
+
+  template <typename T, typename ... Args>
+  inline T *make(Args &&... args) {
+    return ::new(allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+  }
+
+  // copies the characters into the arena
+  std::string_view copy(std::string_view text);
+
+  [[nodiscard]] size_t bytes_used() const;
+  [[nodiscard]] size_t bytes_reserved() const;
+
+  // an arena isn't thread-safe; threads that keep adding to one arena (e.g. materialising the deferred function bodies
+  // of one module) serialize on this
+  [[nodiscard]] std::mutex &writers() { return writer_lock; }
+
+  // the arena of the innermost scope on this thread (or nullptr)
+  static arena *current();
+  // the arena of the innermost scope, or a per-thread arena that lives until the thread exits
+  static arena &current_or_fallback();
+
+  // makes an arena the current one for this thread, until the scope ends
+  class scope {
+  public:
+    explicit scope(arena &a);
+    scope(const scope &) = delete;
+    scope(scope &&) = delete;
+    scope &operator=(const scope &) = delete;
+    scope &operator=(scope &&) = delete;
+    ~scope();
+  private:
+    arena *previous;
+  };
+
+  ~arena() = default;
+private:
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  std::byte *head = nullptr;
+  std::byte *end = nullptr;
+  size_t next_block = first_block;
+  size_t used = 0;
+  size_t reserved = 0;
+  std::mutex writer_lock;
+};
+
+// allocator for containers inside arena nodes; default-constructed, it uses the current arena (or the heap if there is none)
+template <typename T>
+class arena_allocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  arena_allocator() : owner{arena::current()} {}
+  constexpr explicit arena_allocator(arena *owner) : owner{owner} {}
+  template <typename U>
+  constexpr arena_allocator(const arena_allocator<U> &other) : owner{other.source()} {} // NOLINT(*-explicit-constructor)
+
+  inline T *allocate(const size_t n) {
+    if(owner == nullptr) return std::allocator<T>{}.allocate(n);
+    return static_cast<T *>(owner->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  inline void deallocate(T *ptr, const size_t n) {
+    if(owner == nullptr) std::allocator<T>{}.deallocate(ptr, n);
+  }
+
+  [[nodiscard]] constexpr arena *source() const { return owner; }
+
+  template <typename U>
+  constexpr bool operator==(const arena_allocator<U> &other) const { return owner == other.source(); }
+
+private:
+  arena *owner;
+};
+
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+// for lists that are usually short: the first N elements live in the node itself
+template <typename T, size_t N>
+using arena_small_vector = small_vector<T, N, arena_allocator<T>>;
+
+// non-owning reference to a node in an arena; copies are shallow
+template <typename T>
+class arena_ptr {
+public:
+  constexpr arena_ptr() = default;
+  constexpr explicit arena_ptr(T *ptr) : ptr{ptr} {}
+
+  // ReSharper disable once CppNonExplicitConversionOperator
+  constexpr operator bool() const { return ptr != nullptr; } // NOLINT(*-explicit-constructor)
+  constexpr T &operator*() { return *ptr; }
+  constexpr const T &operator*() const { return *ptr; }
+  constexpr T *operator->() { return ptr; }
+  constexpr const T *operator->() const { return ptr; }
+
+private:
+  T *ptr = nullptr;
+};
+
+// places a value in the current arena (see arena::current_or_fallback)
+template <typename T>
+arena_ptr<std::remove_cvref_t<T>> arena_alloc(T &&t) {
+  using actual = std::remove_cvref_t<T>;
+  return arena_ptr<actual>{arena::current_or_fallback().make<actual>(std::forward<T>(t))};
+}
+
+// optional value, stored in the current arena when set; copies are shallow
+template <typename T>
+class arena_opt {
+public:
+  constexpr arena_opt() = default;
+  inline arena_opt(const T &t) : ptr{arena_alloc(t)} {} // NOLINT(*-explicit-constructor)
+  inline arena_opt(T &&t) : ptr{arena_alloc(std::move(t))} {} // NOLINT(*-explicit-constructor)
+  constexpr arena_opt(std::nullopt_t) {} // NOLINT(*-explicit-constructor)
+
+  inline arena_opt &operator=(const T &other) { ptr = arena_alloc(other); return *this; }
+  inline arena_opt &operator=(T &&other) { ptr = arena_alloc(std::move(other)); return *this; }
+  constexpr arena_opt &operator=(std::nullopt_t) { ptr = arena_ptr<T>{}; return *this; }
+
+  [[nodiscard]] constexpr bool has_value() const { return ptr; }
+  constexpr T &value() { return *ptr; }
+  constexpr const T &value() const { return *ptr; }
+
+  constexpr operator bool() const { return ptr; } // NOLINT(*-explicit-constructor)
+  constexpr T &operator*() { return *ptr; }
+  constexpr const T &operator*() const { return *ptr; }
+  constexpr T *operator->() { return &*ptr; }
+  constexpr const T *operator->() const { return &*ptr; }
+
+  constexpr bool operator==(std::nullopt_t) const { return !ptr; }
+  constexpr bool operator==(const arena_opt &other) const {
+    if(!ptr) return !other.ptr;
+    if(!other.ptr) return false;
+    return *ptr == *other.ptr;
+  }
+
+private:
+  arena_ptr<T> ptr{};
+};
+}
+
+#endif //ARENA_HPP
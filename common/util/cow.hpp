@@ -0,0 +1,127 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef COW_HPP
+#define COW_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// JAYDK_ATOMIC_COW=1 makes every cow's reference count atomic, for builds that share trees between threads
+#ifndef JAYDK_ATOMIC_COW
+#define JAYDK_ATOMIC_COW 0
+#endif
+
+namespace jaydk {
+// a nullable, copy-on-write owning pointer: copies share the pointee (and bump a reference count) instead of
+// deep-copying it, and the first mutable access through a shared copy clones the pointee for that copy only
+// reads should go through a const cow (or deref()), since non-const operator*/-> unshares; unlike std::shared_ptr, the
+// count is non-atomic unless Atomic (one thread per tree), and a cow is one pointer wide
+// covers both managed (always engaged once allocated) and heap_opt (has_value, value, nullopt)
+template <typename T, bool Atomic = JAYDK_ATOMIC_COW>
+class cow {
+public:
+  constexpr cow() = default;
+  constexpr cow(std::nullopt_t) {} // NOLINT(*-explicit-constructor)
+  inline cow(const T &t) : box{new shared{1, t}} {} // NOLINT(*-explicit-constructor)
+  inline cow(T &&t) : box{new shared{1, std::move(t)}} {} // NOLINT(*-explicit-constructor)
+  inline cow(const cow &other) : box{other.box} { retain(); }
+  inline cow(cow &&other) noexcept : box{std::exchange(other.box, nullptr)} {}
+
+  inline cow &operator=(const cow &other) {
+    if(box == other.box) return *this;
+    release();
+    box = other.box;
+    retain();
+    return *this;
+  }
+
+  inline cow &operator=(cow &&other) noexcept {
+    std::swap(box, other.box);
+    return *this;
+  }
+
+  inline cow &operator=(const T &other) { return *this = cow{other}; }
+  inline cow &operator=(T &&other) { return *this = cow{std::move(other)}; }
+
+  inline cow &operator=(std::nullopt_t) {
+    release();
+    box = nullptr;
+    return *this;
+  }
+
+  [[nodiscard]] constexpr bool has_value() const { return box != nullptr; }
+  constexpr operator bool() const { return box != nullptr; } // NOLINT(*-explicit-constructor)
+
+  // shared access; never copies
+  [[nodiscard]] constexpr const T &deref() const { return box->value; }
+  constexpr const T &operator*() const { return box->value; }
+  constexpr const T *operator->() const { return &box->value; }
+  [[nodiscard]] constexpr const T &value() const { return box->value; }
+
+  // mutable access; clones the pointee first if it's shared
+  inline T &operator*() { return unshare(); }
+  inline T *operator->() { return &unshare(); }
+  inline T &value() { return unshare(); }
+
+  [[nodiscard]] inline uint32_t use_count() const { return box == nullptr ? 0 : load(box->count); }
+  // whether this is the only reference to its pointee (or empty)
+  [[nodiscard]] inline bool unique() const { return use_count() <= 1; }
+  [[nodiscard]] constexpr bool shares_with(const cow &other) const { return box == other.box; }
+
+  constexpr bool operator==(std::nullopt_t) const { return box == nullptr; }
+  constexpr bool operator==(const cow &other) const {
+    if(box == other.box) return true;
+    if(box == nullptr || other.box == nullptr) return false;
+    return box->value == other.box->value;
+  }
+
+  inline ~cow() { release(); }
+
+private:
+  using count_t = std::conditional_t<Atomic, std::atomic<uint32_t>, uint32_t>;
+  struct shared {
+    count_t count;
+    T value;
+  };
+
+  static uint32_t load(const count_t &c) {
+    if constexpr(Atomic) return c.load(std::memory_order_acquire);
+    else return c;
+  }
+
+  inline void retain() const {
+    if(box == nullptr) return;
+    if constexpr(Atomic) box->count.fetch_add(1, std::memory_order_relaxed);
+    else box->count++;
+  }
+
+  inline void release() {
+    if(box == nullptr) return;
+    if constexpr(Atomic) {
+      if(box->count.fetch_sub(1, std::memory_order_acq_rel) == 1) delete box;
+    }
+    else if(--box->count == 0) delete box;
+  }
+
+  inline T &unshare() {
+    if(load(box->count) != 1) {
+      auto *copy = new shared{1, box->value};
+      release();
+      box = copy;
+    }
+    return box->value;
+  }
+
+  shared *box = nullptr;
+};
+
+template <typename T, typename ... Args>
+cow<T> make_cow(Args &&... args) { return cow<T>{T{std::forward<Args>(args)...}}; }
+}
+
+#endif //COW_HPP
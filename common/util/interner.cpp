@@ -0,0 +1,46 @@
+//
+// Created by jay on 9/17/24.
+//
+
+#include <mutex>
+
+#include "interner.hpp"
+
+using namespace jaydk;
+
+interner &interner::get() {
+  static interner instance;
+  return instance;
+}
+
+interner::interner() {
+  intern("");
+}
+
+uint32_t interner::intern(const std::string_view spelling) {
+  {
+    std::shared_lock guard{lock};
+    if(const auto it = by_spelling.find(spelling); it != by_spelling.end()) return it->second;
+  }
+
+  std::unique_lock guard{lock};
+  // someone else may have interned it while we weren't holding the lock
+  if(const auto it = by_spelling.find(spelling); it != by_spelling.end()) return it->second;
+
+  const std::string_view stored = storage.emplace_back(spelling);
+  const auto id = static_cast<uint32_t>(by_id.size());
+  by_id.push_back(stored);
+  by_spelling.emplace(stored, id);
+  return id;
+}
+
+std::string_view interner::lookup(const uint32_t id) const {
+  std::shared_lock guard{lock};
+  if(id >= by_id.size()) return by_id[0];
+  return by_id[id];
+}
+
+size_t interner::size() const {
+  std::shared_lock guard{lock};
+  return by_id.size();
+}
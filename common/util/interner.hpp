@@ -0,0 +1,82 @@
+//
+// Created by jay on 9/17/24.
+//
+
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jaydk {
+// maps each distinct spelling to a stable 32-bit ID; spellings are never freed, so views into them remain valid
+class interner {
+public:
+  interner(const interner&) = delete;
+  interner(interner&&) = delete;
+  interner& operator=(const interner&) = delete;
+  interner& operator=(interner&&) = delete;
+
+  static interner& get();
+
+  uint32_t intern(std::string_view spelling);
+  [[nodiscard]] std::string_view lookup(uint32_t id) const;
+  [[nodiscard]] size_t size() const;
+
+  ~interner() = default;
+private:
+  interner();
+
+  mutable std::shared_mutex lock;
+  std::deque<std::string> storage; //!< Deque: elements are never relocated, so the views below stay valid
+  std::vector<std::string_view> by_id;
+  std::unordered_map<std::string_view, uint32_t> by_spelling;
+};
+
+inline static interner &strings = interner::get();
+
+// an interned string; comparing and hashing only touch the ID
+class interned {
+public:
+  constexpr interned() = default;
+  interned(const std::string_view spelling) : id_{strings.intern(spelling)} {} // NOLINT(*-explicit-constructor)
+  interned(const std::string &spelling) : interned{std::string_view{spelling}} {} // NOLINT(*-explicit-constructor)
+  interned(const char *spelling) : interned{std::string_view{spelling}} {} // NOLINT(*-explicit-constructor)
+
+  static constexpr interned from_id(const uint32_t id) { interned res; res.id_ = id; return res; }
+
+  [[nodiscard]] constexpr uint32_t id() const { return id_; }
+  [[nodiscard]] constexpr bool empty() const { return id_ == 0; }
+  [[nodiscard]] std::string_view view() const { return strings.lookup(id_); }
+  [[nodiscard]] std::string str() const { return std::string{view()}; }
+
+  constexpr bool operator==(const interned &) const = default;
+  constexpr auto operator<=>(const interned &) const = default;
+
+private:
+  uint32_t id_ = 0; //!< 0 is always the empty string
+};
+
+inline std::ostream &operator<<(std::ostream &strm, const interned &i) {
+  return strm << i.view();
+}
+
+inline std::string operator+(const std::string &lhs, const interned &rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const interned &lhs, const std::string &rhs) { return lhs.str() + rhs; }
+inline std::string operator+(const char *lhs, const interned &rhs) { return lhs + rhs.str(); }
+inline std::string operator+(const interned &lhs, const char *rhs) { return lhs.str() + rhs; }
+}
+
+template <>
+struct std::hash<jaydk::interned> {
+  constexpr size_t operator()(const jaydk::interned &i) const noexcept { return i.id(); }
+};
+
+#endif //INTERNER_HPP
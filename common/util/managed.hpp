@@ -6,6 +6,8 @@
 #define MANAGED_HPP
 
 #include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace jaydk {
 template <typename T>
@@ -48,6 +50,9 @@ private:
 
 template <typename T>
 managed<T> alloc(const T &t) { return managed(t); }
+// rvalues are moved onto the heap instead of deep-copied
+template <typename T> requires(!std::is_reference_v<T>)
+managed<T> alloc(T &&t) { return managed<T>(std::move(t)); }
 template <typename T, typename ... Args>
 managed<T> alloc(Args &&... args) { return managed<T>{std::forward<Args>(args)...}; }
 }
@@ -0,0 +1,174 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef SMALL_VECTOR_HPP
+#define SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace jaydk {
+// a vector that keeps up to N elements inline, and only allocates (from Alloc) once it grows beyond that
+// T has to be complete where the small_vector is declared, so it can't hold its own enclosing type (as in a tree node's
+// children); iterators are plain pointers, invalidated by growth like std::vector's
+template <typename T, size_t N, typename Alloc = std::allocator<T>>
+class small_vector {
+  static_assert(N > 0, "use a std::vector without inline storage");
+  using traits = std::allocator_traits<Alloc>;
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+  using allocator_type = Alloc;
+  using iterator = T *;
+  using const_iterator = const T *;
+
+  small_vector() = default;
+  explicit small_vector(const Alloc &alloc) : alloc{alloc} {}
+  small_vector(const std::initializer_list<T> values) {
+    reserve(values.size());
+    for(const auto &v : values) push_back(v);
+  }
+
+  small_vector(const small_vector &other) : alloc{traits::select_on_container_copy_construction(other.alloc)} {
+    reserve(other.size());
+    std::uninitialized_copy(other.begin(), other.end(), ptr);
+    count = other.count;
+  }
+
+  small_vector(small_vector &&other) noexcept : alloc{other.alloc} { take(std::move(other)); }
+
+  // like std::vector, the allocator follows the propagate_on_container_*_assignment traits; with a propagating
+  // allocator (e.g. arena_allocator), the target's elements move to the source's arena
+  small_vector &operator=(const small_vector &other) {
+    if(this == &other) return *this;
+    clear();
+    if constexpr(traits::propagate_on_container_copy_assignment::value) {
+      if(alloc != other.alloc) release(); // the spilled buffer (if any) belongs to the old allocator
+      alloc = other.alloc;
+    }
+    reserve(other.size());
+    std::uninitialized_copy(other.begin(), other.end(), ptr);
+    count = other.count;
+    return *this;
+  }
+
+  small_vector &operator=(small_vector &&other) noexcept(
+    traits::propagate_on_container_move_assignment::value || traits::is_always_equal::value
+  ) {
+    if(this == &other) return *this;
+    clear();
+    if constexpr(!traits::propagate_on_container_move_assignment::value) {
+      if(alloc != other.alloc) { // can't steal a buffer from another allocator
+        reserve(other.size());
+        std::uninitialized_move(other.begin(), other.end(), ptr);
+        count = other.count;
+        other.clear();
+        return *this;
+      }
+    }
+    release();
+    alloc = other.alloc;
+    take(std::move(other));
+    return *this;
+  }
+
+  ~small_vector() {
+    clear();
+    release();
+  }
+
+  [[nodiscard]] constexpr size_t size() const { return count; }
+  [[nodiscard]] constexpr size_t capacity() const { return cap; }
+  [[nodiscard]] constexpr bool empty() const { return count == 0; }
+  [[nodiscard]] bool is_inline() const { return ptr == inline_data(); }
+  [[nodiscard]] constexpr Alloc get_allocator() const { return alloc; }
+
+  constexpr T *data() { return ptr; }
+  constexpr const T *data() const { return ptr; }
+  constexpr T *begin() { return ptr; }
+  constexpr const T *begin() const { return ptr; }
+  constexpr T *end() { return ptr + count; }
+  constexpr const T *end() const { return ptr + count; }
+
+  constexpr T &operator[](const size_t i) { return ptr[i]; }
+  constexpr const T &operator[](const size_t i) const { return ptr[i]; }
+  constexpr T &front() { return ptr[0]; }
+  constexpr const T &front() const { return ptr[0]; }
+  constexpr T &back() { return ptr[count - 1]; }
+  constexpr const T &back() const { return ptr[count - 1]; }
+
+  void reserve(const size_t n) {
+    if(n <= cap) return;
+    T *grown = traits::allocate(alloc, n);
+    std::uninitialized_move(begin(), end(), grown);
+    std::destroy(begin(), end());
+    release();
+    ptr = grown;
+    cap = static_cast<uint32_t>(n);
+  }
+
+  template <typename ... Args>
+  T &emplace_back(Args &&... args) {
+    if(count == cap) {
+      T value{std::forward<Args>(args)...}; // args may refer to an element, so build it before the buffer moves
+      reserve(cap * 2);
+      return *::new(static_cast<void *>(ptr + count++)) T{std::move(value)};
+    }
+    return *::new(static_cast<void *>(ptr + count++)) T{std::forward<Args>(args)...};
+  }
+
+  void push_back(const T &t) { emplace_back(t); }
+  void push_back(T &&t) { emplace_back(std::move(t)); }
+
+  void pop_back() {
+    std::destroy_at(ptr + count - 1);
+    count--;
+  }
+
+  void clear() {
+    std::destroy(begin(), end());
+    count = 0;
+  }
+
+  bool operator==(const small_vector &other) const { return std::ranges::equal(*this, other); }
+
+private:
+  T *inline_data() { return std::launder(reinterpret_cast<T *>(storage)); }
+  const T *inline_data() const { return std::launder(reinterpret_cast<const T *>(storage)); }
+
+  // frees the spilled buffer, if any, and goes back to inline storage (elements must be destroyed already)
+  void release() {
+    if(!is_inline()) traits::deallocate(alloc, ptr, cap);
+    ptr = inline_data();
+    cap = N;
+  }
+
+  // other's elements, by stealing its buffer if it spilled, by moving them one by one otherwise
+  void take(small_vector &&other) {
+    if(other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), ptr);
+      count = other.count;
+      other.clear();
+      return;
+    }
+    ptr = std::exchange(other.ptr, other.inline_data());
+    cap = std::exchange(other.cap, static_cast<uint32_t>(N));
+    count = std::exchange(other.count, 0);
+  }
+
+  [[no_unique_address]] Alloc alloc{};
+  T *ptr = inline_data();
+  uint32_t count = 0;
+  uint32_t cap = N;
+  alignas(T) std::byte storage[N * sizeof(T)];
+};
+}
+
+#endif //SMALL_VECTOR_HPP
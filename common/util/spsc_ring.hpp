@@ -0,0 +1,62 @@
+//
+// Created by jay on 9/19/24.
+//
+
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <utility>
+
+namespace jaydk {
+// lock-free single-producer/single-consumer ring buffer; exactly one thread may push and one other thread may pop
+template <typename T, size_t capacity> requires(std::has_single_bit(capacity))
+class spsc_ring {
+public:
+  constexpr spsc_ring() = default;
+  spsc_ring(const spsc_ring &) = delete;
+  spsc_ring(spsc_ring &&) = delete;
+  spsc_ring &operator=(const spsc_ring &) = delete;
+  spsc_ring &operator=(spsc_ring &&) = delete;
+
+  // producer side; moves from value only on success
+  inline bool try_push(T &value) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if(t - head_cache == capacity) {
+      head_cache = head.load(std::memory_order_acquire);
+      if(t - head_cache == capacity) return false;
+    }
+    slots[t & (capacity - 1)] = std::move(value);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side
+  inline bool try_pop(T &out) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if(h == tail_cache) {
+      tail_cache = tail.load(std::memory_order_acquire);
+      if(h == tail_cache) return false;
+    }
+    out = std::move(slots[h & (capacity - 1)]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  ~spsc_ring() = default;
+private:
+  constexpr static size_t line = 64;
+
+  // head/tail live on their own cache lines, each next to the copy of the other index its owner caches
+  alignas(line) std::atomic<size_t> head{0}; //!< Next slot to pop (written by the consumer)
+  size_t tail_cache = 0;
+  alignas(line) std::atomic<size_t> tail{0}; //!< Next slot to push (written by the producer)
+  size_t head_cache = 0;
+  alignas(line) std::array<T, capacity> slots{};
+};
+}
+
+#endif //SPSC_RING_HPP
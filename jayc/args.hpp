@@ -14,9 +14,13 @@ struct args {
   std::string input; //!< Input file
   std::string output = "./out.jbc"; //!< Bytecode output file
 
-  std::optional<std::string> lexer_out = std::nullopt; //!< Output file for the lexer token stream
+  std::optional<std::string> lexer_out = std::nullopt; //!< Output file for the lexer token stream (binary cache, reused if up-to-date)
+  bool lexer_out_text = false; //!< Whether to write the lexer token stream as human-readable text instead
+  bool pipelined_lexer = false; //!< Whether to lex on a separate thread, overlapping with parsing
+  bool parallel_parser = false; //!< Whether to parse top-level declarations on several threads
   bool perform_parser = true; //!< Whether to perform parsing
-  std::optional<std::string> parser_out = std::nullopt; //!< Output file for the unchecked AST
+  std::optional<std::string> parser_out = std::nullopt; //!< Output file for the unchecked AST (binary; if up-to-date, lexing and parsing are skipped)
+  bool parser_out_text = false; //!< Whether to write the unchecked AST as human-readable text instead (stdout without parser_out)
   bool perform_type_check = true; //!< Whether to perform type-checking
   std::optional<std::string> type_checked_ast_out = std::nullopt; //!< Output file for type-checked AST
   bool perform_codegen = true; //!< Whether to perform code-generation
@@ -27,6 +31,8 @@ struct args {
   std::optional<std::string> bytecode_out = std::nullopt; //!< Output file for human-readable bytecode
   std::vector<std::string> link_targets{}; //!< Library names to link against
   std::vector<std::string> link_sources{}; //!< Directories to search for libraries
+  std::optional<std::string> trace = std::nullopt; //!< Comma-separated trace categories to record (lexer, parser, sema, all)
+  std::optional<std::string> trace_out = std::nullopt; //!< Output file for recorded trace events (default: stderr)
 };
 }
 
@@ -10,6 +10,10 @@
 
 using namespace jayc;
 
+namespace {
+thread_local std::vector<error_queue::message> *captured = nullptr;
+}
+
 error_queue &error_queue::get() {
   static error_queue queue;
   return queue;
@@ -30,6 +34,12 @@ void perform_log(
 }
 
 error_queue &error_queue::operator<<(const error &e) {
+  if(captured != nullptr) {
+    captured->emplace_back(e);
+    return *this;
+  }
+
+  std::lock_guard guard{lock};
   perform_log<'E'>(muted[2], std::cerr, termcolor::red, e, queue);
 
   if(throw_on_error) {
@@ -40,11 +50,37 @@ error_queue &error_queue::operator<<(const error &e) {
 }
 
 error_queue &error_queue::operator<<(const warning &w) {
+  if(captured != nullptr) {
+    captured->emplace_back(w);
+    return *this;
+  }
+
+  std::lock_guard guard{lock};
   perform_log<'W'>(muted[1], std::cerr, termcolor::yellow, w, queue);
   return *this;
 }
 
 error_queue &error_queue::operator<<(const info &i) {
+  if(captured != nullptr) {
+    captured->emplace_back(i);
+    return *this;
+  }
+
+  std::lock_guard guard{lock};
   perform_log<'I'>(muted[0], std::cout, termcolor::blue, i, queue);
   return *this;
 }
+
+error_queue::capture::capture(std::vector<message> &into) : previous{captured} {
+  captured = &into;
+}
+
+error_queue::capture::~capture() {
+  captured = previous;
+}
+
+void error_queue::replay(const std::vector<message> &messages) {
+  for(const auto &m : messages) {
+    std::visit([this](const auto &x) { *this << x; }, m);
+  }
+}
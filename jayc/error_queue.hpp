@@ -6,26 +6,24 @@
 #define ERROR_QUEUE_HPP
 
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <variant>
 #include <vector>
 #include <ranges>
 
 #include "util/variant_helpers.hpp"
+#include "source_manager.hpp"
 
 namespace jayc {
-struct location {
-  std::string file;
-  int line;
-  int col;
-};
-
 inline std::ostream &operator<<(std::ostream &strm, const location &loc) {
-  return strm << loc.file << " (" << loc.line << ":" << loc.col << ")";
+  const auto [file, line, col] = resolve(loc);
+  return strm << file << " (" << line << ":" << col << ")";
 }
 
 inline std::string to_string(const location &loc) {
-  return loc.file + " (" + std::to_string(loc.line) + ":" + std::to_string(loc.col) + ")";
+  const auto [file, line, col] = resolve(loc);
+  return std::string{file} + " (" + std::to_string(line) + ":" + std::to_string(col) + ")";
 }
 
 struct info {
@@ -59,6 +57,20 @@ private:
         std::views::transform([](const msg &x) -> T { return jaydk::as<T>(x); });
   }
 public:
+  using message = msg;
+
+  // while a capture is alive, messages logged on its thread are collected into it instead of being reported
+  // (used to hold back diagnostics from speculative work, see lexer::lex_parallel)
+  class capture {
+  public:
+    explicit capture(std::vector<message> &into);
+    capture(const capture &) = delete;
+    capture &operator=(const capture &) = delete;
+    ~capture();
+  private:
+    std::vector<message> *previous;
+  };
+
   error_queue(const error_queue&) = delete;
   error_queue(error_queue&&) = delete;
   error_queue& operator=(const error_queue&) = delete;
@@ -70,6 +82,9 @@ public:
   error_queue &operator<<(const warning &w);
   error_queue &operator<<(const error &e);
 
+  // reports previously captured messages, in order
+  void replay(const std::vector<message> &messages);
+
   inline void mute_info() { muted[0] = true; }
   inline void mute_warning() { muted[1] = true; }
   inline void mute_error() { muted[2] = true; }
@@ -107,6 +122,7 @@ private:
 
   bool muted[3] = { false, false, false };
   bool throw_on_error = false;
+  std::mutex lock; //!< Messages may be logged from the lexer thread (see lexer::token_pipe)
   std::vector<std::vector<msg>> queue;
 };
 
@@ -2,170 +2,298 @@
 // Created by jay on 9/4/24.
 //
 
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <iostream>
-#include <unordered_map>
 #include <utility>
 
 #include "token_stream.hpp"
 #include "lexer.hpp"
 #include "lex_error.hpp"
+#include "scan.hpp"
 
 using namespace jayc;
 using namespace jayc::lexer;
 
 namespace {
-const std::unordered_map<std::string, keyword> keywords = {
-  {"fun", keyword::FUN}, {"var", keyword::VAR}, {"if", keyword::IF},
-  {"else", keyword::ELSE}, {"for", keyword::FOR}, {"while", keyword::WHILE},
-  {"do", keyword::DO}, {"return", keyword::RETURN}, {"break", keyword::BREAK},
-  {"continue", keyword::CONTINUE}, {"namespace", keyword::NAMESPACE},
-  {"struct", keyword::STRUCT}, {"auto", keyword::AUTO}, {"val", keyword::VAL}
+// keywords and boolean literals, recognized through a perfect hash over (first char, last char, length)
+struct reserved_word {
+  enum kind_t { NONE, KEYWORD, TRUE_LIT, FALSE_LIT };
+
+  std::string_view spelling;
+  kind_t kind = NONE;
+  keyword kw = keyword::FUN;
 };
 
-inline char peek(std::istream &strm) {
-  return static_cast<char>(strm.peek());
-}
+constexpr reserved_word reserved_words[] = {
+  {"fun", reserved_word::KEYWORD, keyword::FUN}, {"var", reserved_word::KEYWORD, keyword::VAR},
+  {"if", reserved_word::KEYWORD, keyword::IF}, {"else", reserved_word::KEYWORD, keyword::ELSE},
+  {"for", reserved_word::KEYWORD, keyword::FOR}, {"while", reserved_word::KEYWORD, keyword::WHILE},
+  {"do", reserved_word::KEYWORD, keyword::DO}, {"return", reserved_word::KEYWORD, keyword::RETURN},
+  {"break", reserved_word::KEYWORD, keyword::BREAK}, {"continue", reserved_word::KEYWORD, keyword::CONTINUE},
+  {"namespace", reserved_word::KEYWORD, keyword::NAMESPACE}, {"struct", reserved_word::KEYWORD, keyword::STRUCT},
+  {"auto", reserved_word::KEYWORD, keyword::AUTO}, {"val", reserved_word::KEYWORD, keyword::VAL},
+  {"true", reserved_word::TRUE_LIT}, {"false", reserved_word::FALSE_LIT}
+};
 
-constexpr bool is_whitespace(const char c) {
-  return c == ' ' || c == '\n' || c == '\t' || c == '\v';
-}
+constexpr size_t reserved_slots = 32;
+constexpr auto spelling_size = [](const reserved_word &w) { return w.spelling.size(); };
+constexpr size_t min_reserved_len = std::ranges::min_element(reserved_words, {}, spelling_size)->spelling.size();
+constexpr size_t max_reserved_len = std::ranges::max_element(reserved_words, {}, spelling_size)->spelling.size();
+
+struct reserved_hash {
+  uint32_t mul_first;
+  uint32_t mul_last;
+
+  [[nodiscard]] constexpr size_t operator()(const std::string_view word) const {
+    return (static_cast<uint8_t>(word.front()) * mul_first + static_cast<uint8_t>(word.back()) * mul_last + word.size())
+        % reserved_slots;
+  }
+};
 
-inline void extract(std::istream &strm, location &curr, const bool is_newline = false) {
-  strm.get();
-  curr.col++;
-  if(is_newline) {
-    curr.col = 1;
-    curr.line++;
+// brute-force the multipliers at compile time; any collision-free pair will do
+constexpr reserved_hash find_reserved_hash() {
+  for(uint32_t first = 1; first < 64; ++first) {
+    for(uint32_t last = 1; last < 64; ++last) {
+      const reserved_hash h{first, last};
+      bool used[reserved_slots]{};
+      bool ok = true;
+      for(const auto &w : reserved_words) {
+        const auto slot = h(w.spelling);
+        if(used[slot]) { ok = false; break; }
+        used[slot] = true;
+      }
+      if(ok) return h;
+    }
   }
+  return {0, 0};
 }
 
-inline uint64_t read_hex(std::istream &strm, location &curr) {
-  uint64_t res = 0;
-  while(!strm.eof()) {
-    switch(peek(strm)) {
-      case '0': res = res * 16 + 0; break;
-      case '1': res = res * 16 + 1; break;
-      case '2': res = res * 16 + 2; break;
-      case '3': res = res * 16 + 3; break;
-      case '4': res = res * 16 + 4; break;
-      case '5': res = res * 16 + 5; break;
-      case '6': res = res * 16 + 6; break;
-      case '7': res = res * 16 + 7; break;
-      case '8': res = res * 16 + 8; break;
-      case '9': res = res * 16 + 9; break;
-      case 'a': case 'A': res = res * 16 + 10; break;
-      case 'b': case 'B': res = res * 16 + 11; break;
-      case 'c': case 'C': res = res * 16 + 12; break;
-      case 'd': case 'D': res = res * 16 + 13; break;
-      case 'e': case 'E': res = res * 16 + 14; break;
-      case 'f': case 'F': res = res * 16 + 15; break;
-      default: return res;
+constexpr reserved_hash reserved_hasher = find_reserved_hash();
+static_assert(reserved_hasher.mul_first != 0, "no perfect hash for the reserved words; grow reserved_slots");
+
+constexpr std::array<reserved_word, reserved_slots> reserved_table = [] {
+  std::array<reserved_word, reserved_slots> res{};
+  for(const auto &w : reserved_words) res[reserved_hasher(w.spelling)] = w;
+  return res;
+}();
+
+// one hash and (at most) one comparison; no allocation
+constexpr const reserved_word *find_reserved(const std::string_view word) {
+  if(word.size() < min_reserved_len || word.size() > max_reserved_len) return nullptr;
+  const auto &slot = reserved_table[reserved_hasher(word)];
+  return slot.spelling == word ? &slot : nullptr;
+}
+
+static_assert(find_reserved("namespace")->kw == keyword::NAMESPACE);
+static_assert(find_reserved("false")->kind == reserved_word::FALSE_LIT);
+static_assert(find_reserved("fun_") == nullptr && find_reserved("x") == nullptr);
+
+// operators and punctuation; adding an operator means adding a row here
+struct operator_spelling {
+  std::string_view spelling;
+  symbol sym;
+};
+
+constexpr operator_spelling operators[] = {
+  {"+", symbol::PLUS}, {"-", symbol::MINUS}, {"*", symbol::MULTIPLY}, {"/", symbol::DIVIDE}, {"%", symbol::MODULO},
+  {"++", symbol::INCREMENT}, {"--", symbol::DECREMENT}, {"=", symbol::ASSIGN},
+  {"==", symbol::EQUALS}, {"!=", symbol::NOT_EQUALS}, {"<", symbol::LESS_THAN}, {">", symbol::GREATER_THAN},
+  {"<=", symbol::LESS_THAN_EQUALS}, {">=", symbol::GREATER_THAN_EQUALS},
+  {"&&", symbol::AND}, {"||", symbol::OR}, {"!", symbol::NOT}, {"&", symbol::BIT_AND}, {"|", symbol::BIT_OR},
+  {"~", symbol::BIT_NEG}, {"^", symbol::XOR}, {"<<", symbol::SHIFT_LEFT}, {">>", symbol::SHIFT_RIGHT},
+  {".", symbol::DOT}, {"::", symbol::NAMESPACE},
+  {"(", symbol::PAREN_OPEN}, {")", symbol::PAREN_CLOSE}, {"[", symbol::BRACKET_OPEN}, {"]", symbol::BRACKET_CLOSE},
+  {"{", symbol::BRACE_OPEN}, {"}", symbol::BRACE_CLOSE},
+  {",", symbol::COMMA}, {";", symbol::SEMI}, {":", symbol::COLON}, {"?", symbol::QUESTION},
+  {"+=", symbol::PLUS_ASSIGN}, {"-=", symbol::MINUS_ASSIGN}, {"*=", symbol::MULTIPLY_ASSIGN},
+  {"/=", symbol::DIVIDE_ASSIGN}, {"%=", symbol::MODULO_ASSIGN},
+  {"&=", symbol::BIT_AND_ASSIGN}, {"|=", symbol::BIT_OR_ASSIGN}, {"^=", symbol::XOR_ASSIGN},
+  {"=>", symbol::ARROW}
+};
+static_assert(std::size(operators) == static_cast<size_t>(symbol::ARROW) + 1, "every symbol needs a spelling");
+
+// worst case, every character of every spelling gets its own state (+ the dead and start states)
+constexpr size_t max_operator_states = [] {
+  size_t res = 2;
+  for(const auto &[spelling, _] : operators) res += spelling.size();
+  return res;
+}();
+static_assert(max_operator_states <= 256, "operator DFA states no longer fit in a byte");
+
+struct operator_dfa {
+  static constexpr uint8_t dead = 0;
+  static constexpr uint8_t start = 1;
+  static constexpr uint8_t no_symbol = 0xff;
+
+  std::array<std::array<uint8_t, 256>, max_operator_states> next{};
+  std::array<uint8_t, max_operator_states> accepts{};
+};
+
+constexpr operator_dfa operator_table = [] {
+  operator_dfa res{};
+  res.accepts.fill(operator_dfa::no_symbol);
+  uint8_t states = 2;
+
+  for(const auto &[spelling, sym] : operators) {
+    uint8_t state = operator_dfa::start;
+    for(const char c : spelling) {
+      auto &target = res.next[state][static_cast<uint8_t>(c)];
+      if(target == operator_dfa::dead) target = states++;
+      state = target;
     }
-    extract(strm, curr);
+    res.accepts[state] = static_cast<uint8_t>(sym);
   }
 
   return res;
+}();
+
+constexpr bool at_end(const cursor &cur) {
+  return cur.pos >= cur.end;
+}
+
+// returns '\0' at the end of the buffer (never a valid start of a token)
+constexpr char peek(const cursor &cur) {
+  return at_end(cur) ? '\0' : *cur.pos;
+}
+
+constexpr location here(const cursor &cur) {
+  return location{ cur.file, static_cast<uint32_t>(cur.pos - cur.begin) };
+}
+
+constexpr void extract(cursor &cur) {
+  ++cur.pos;
+}
+
+// parses [first, last) in one go; out-of-range literals are reported instead of thrown
+template <typename T>
+inline token parse_literal(
+  const cursor &cur, const char *first, const char *last, const location &start, const int base = 10
+) {
+  if(*first == '+') ++first; // from_chars doesn't accept an explicit plus sign
+
+  T value{};
+  std::from_chars_result res{};
+  if constexpr(std::is_integral_v<T>) res = std::from_chars(first, last, value, base);
+  else res = std::from_chars(first, last, value, std::chars_format::fixed);
+
+  if(res.ec != std::errc{} || res.ptr != last) {
+    logger << literal_out_of_range(start);
+    return token{invalid_ignored{}, start};
+  }
+  return encode(literal{value}, start, cur.payloads);
 }
 
-inline token read_decimal(std::istream &strm, const location &start, location &curr, const std::string &buf) {
-  std::string buffer = buf;
-  char next = peek(strm);
+constexpr bool is_unsigned_suffix(const char c) {
+  return c == 'u' || c == 'U';
+}
+
+inline token read_hex(cursor &cur, const location &start) {
+  const char *first = cur.pos;
+  while(isxdigit(peek(cur))) extract(cur);
+  const char *last = cur.pos;
+  if(is_unsigned_suffix(peek(cur))) extract(cur); // hexadecimal literals are always unsigned
+  return parse_literal<uint64_t>(cur, first, last, start, 16);
+}
+
+// the literal's text is [first, cur.pos) once all digits are consumed, so no buffer has to be built on the way
+inline token read_decimal(cursor &cur, const char *first, const location &start) {
+  char next = peek(cur);
   while(isdigit(next)) {
-    extract(strm, curr);
-    buffer += next;
-    next = peek(strm);
+    extract(cur);
+    next = peek(cur);
   }
 
   if(next == '.') {
     // -> float or double
-    extract(strm, curr);
-    buffer += next;
-    next = peek(strm);
+    extract(cur);
+    next = peek(cur);
 
     if(!isdigit(next)) {
-      logger << incomplete_float(curr);
+      logger << incomplete_float(here(cur));
       return token{invalid_ignored{}, start};
     }
 
     while(isdigit(next)) {
-      extract(strm, curr);
-      buffer += next;
-      next = peek(strm);
+      extract(cur);
+      next = peek(cur);
     }
 
+    const char *last = cur.pos;
     if(next == 'f' || next == 'F') {
-      extract(strm, curr);
-      return token{literal{std::stof(buffer)}, start};
+      extract(cur);
+      return parse_literal<float>(cur, first, last, start);
     }
-    return token{literal{std::stod(buffer)}, start};
+    return parse_literal<double>(cur, first, last, start);
   }
+
   // -> integer
-  return token{literal{std::stol(buffer)}, start};
+  const char *last = cur.pos;
+  if(is_unsigned_suffix(next)) {
+    extract(cur);
+    return parse_literal<uint64_t>(cur, first, last, start);
+  }
+  return parse_literal<int64_t>(cur, first, last, start);
 }
 
-inline token numerical_no_sign(std::istream &strm, location &curr) {
-  const location start = curr;
-  if(char next = peek(strm); next == '0') {
-    extract(strm, curr);
-    next = peek(strm);
+inline token numerical_no_sign(cursor &cur) {
+  const location start = here(cur);
+  const char *first = cur.pos;
+  if(char next = peek(cur); next == '0') {
+    extract(cur);
+    next = peek(cur);
     if(next == 'x' || next == 'X') {
       // -> hexadecimal literal
-      extract(strm, curr);
-      next = peek(strm);
-      if(isxdigit(next)) return token{ literal{read_hex(strm, curr)}, start };
-      logger << incomplete_hex(curr);
+      extract(cur);
+      next = peek(cur);
+      if(isxdigit(next)) return read_hex(cur, start);
+      logger << incomplete_hex(here(cur));
       return token{invalid_ignored{}, start};
     }
-    if(next == '.') {
-      extract(strm, curr);
-      if(!isdigit(peek(strm))) {
-        logger << incomplete_float(curr);
-        return token{invalid_ignored{}, start};
-      }
-      return read_decimal(strm, start, curr, "0.");
-    }
-    if(isdigit(next)) {
-      return read_decimal(strm, start, curr, ""); // leading 0 doesn't matter
-    }
-
-    return token{ literal<int64_t>{0}, start };
+    // leading 0 doesn't matter (also handles 0.x and a lone 0, possibly with suffix)
   }
-  return read_decimal(strm, start, curr, "");
+  return read_decimal(cur, first, start);
 }
 
-inline token id_kw_bool(std::istream &strm, location &curr) {
-  const location start = curr;
-  std::string buf;
-  char next = peek(strm);
+inline token id_kw_bool(cursor &cur) {
+  const location start = here(cur);
+  const char *first = cur.pos;
+  char next = peek(cur);
   while(isalnum(next) || next == '_') {
-    extract(strm, curr);
-    buf += next;
-    next = peek(strm);
+    extract(cur);
+    next = peek(cur);
   }
 
-  if(buf == "true") return token{literal{true}, start};
-  if(buf == "false") return token{literal{false}, start};
-  if(const auto it = keywords.find(buf); it != keywords.end()) return token{it->second, start};
-  return token{identifier{std::move(buf)}, start};
+  const std::string_view word{first, cur.pos};
+  if(const auto *reserved = find_reserved(word)) {
+    switch(reserved->kind) {
+      case reserved_word::KEYWORD: return token{reserved->kw, start};
+      case reserved_word::TRUE_LIT: return token{literal{true}, start};
+      case reserved_word::FALSE_LIT: return token{literal{false}, start};
+      case reserved_word::NONE: break;
+    }
+  }
+  return token{identifier{word}, start};
 }
 
-inline token char_lit(std::istream &strm, location &curr) {
-  const location start = curr;
-  extract(strm, curr);
+inline token char_lit(cursor &cur) {
+  const location start = here(cur);
+  extract(cur);
 
-  char next = peek(strm);
+  char next = peek(cur);
   char lit;
-  if(strm.eof()) {
-    logger << unterminated_char(curr);
+  if(at_end(cur)) {
+    logger << unterminated_char(here(cur));
     return token{invalid_ignored{}, start};
   }
   if(next == '\'') {
-    logger << zero_width_char(curr);
+    logger << zero_width_char(here(cur));
     return token{invalid_ignored{}, start};
   }
   if(next == '\\') {
-    extract(strm, curr);
-    switch(peek(strm)) {
+    extract(cur);
+    switch(peek(cur)) {
       case '\\': lit = '\\'; break;
       case 'n': lit = '\n'; break;
       case 'r': lit = '\r'; break;
@@ -173,7 +301,7 @@ inline token char_lit(std::istream &strm, location &curr) {
       case '0': lit = '\0'; break;
       case '\'': lit = '\''; break;
       default: {
-        logger << invalid_escape_sequence_char(curr);
+        logger << invalid_escape_sequence_char(here(cur));
         lit = '\255';
         break;
       }
@@ -183,127 +311,116 @@ inline token char_lit(std::istream &strm, location &curr) {
     lit = next;
   }
 
-  extract(strm, curr);
-  if(peek(strm) != '\'') {
-    extract(strm, curr);
-    next = peek(strm);
-    while(next != '\'') {
-      extract(strm, curr);
-      next = peek(strm);
+  extract(cur);
+  if(peek(cur) != '\'') {
+    extract(cur);
+    while(!at_end(cur) && peek(cur) != '\'') {
+      extract(cur);
+    }
+    if(at_end(cur)) {
+      logger << unterminated_char(here(cur));
+      return token{invalid_ignored{}, start};
     }
-    logger << char_literal_too_wide(curr);
+    logger << char_literal_too_wide(here(cur));
     return token{invalid_ignored{}, start};
   }
-  extract(strm, curr);
+  extract(cur);
   return lit == '\255' ? token{invalid_ignored{}, start} : token{literal{lit}, start};
 }
 
-inline token string_lit(std::istream &strm, location &curr) {
-  const location start = curr;
-  std::string buf;
-  extract(strm, curr);
+// consumes characters up to (not including) the next `"`, `\` or newline
+inline void string_run(cursor &cur) {
+  cur.pos = scan::find_string_stop(cur.pos, cur.end);
+}
+
+inline token string_lit(cursor &cur) {
+  const location start = here(cur);
+  extract(cur);
+
+  // fast path: no escape sequences -> the literal is a view into the source buffer
+  const char *first = cur.pos;
+  string_run(cur);
+  if(peek(cur) == '"') {
+    const std::string_view view{first, cur.pos};
+    extract(cur);
+    return encode(literal{view}, start, cur.payloads);
+  }
 
-  char next = peek(strm);
-  bool escaped = false;
-  while(next != '"' || escaped) {
-    if(strm.eof()) {
-      logger << unterminated_string(curr);
+  // slow path: decode escape sequences into a buffer owned by the source
+  std::string buf{first, cur.pos};
+  while(true) {
+    if(at_end(cur)) {
+      logger << unterminated_string(here(cur));
       return token{invalid_ignored{}, start};
     }
 
-    if(escaped) {
-      escaped = false;
-      switch(next) {
-        case '\\': buf += '\\'; break;
-        case 'n': case '\n': buf += '\n'; break;
-        case 'r': buf += '\r'; break;
-        case 't': buf += '\v'; break;
-        case '0': buf += '\0'; break;
-        case '\"': buf += '\"'; break;
-        default: {
-          logger << invalid_escape_sequence_str(curr);
-        }
+    switch(peek(cur)) {
+      case '"': {
+        extract(cur);
+        return encode(literal{cur.buffer->store(std::move(buf))}, start, cur.payloads);
       }
-    }
-    else {
-      switch(next) {
-        case '\n': {
-          logger << newline_in_string(curr);
-          return token{invalid_ignored{}, start};
-        }
-        case '\\': {
-          escaped = true;
-          break;
-        }
-        default: {
-          buf += next;
-          break;
+      case '\n': {
+        logger << newline_in_string(here(cur));
+        return token{invalid_ignored{}, start};
+      }
+      default: { // -> '\\'
+        extract(cur);
+        if(at_end(cur)) continue; // reported as unterminated
+        switch(peek(cur)) {
+          case '\\': buf += '\\'; break;
+          case 'n': case '\n': buf += '\n'; break;
+          case 'r': buf += '\r'; break;
+          case 't': buf += '\v'; break;
+          case '0': buf += '\0'; break;
+          case '\"': buf += '\"'; break;
+          default: {
+            logger << invalid_escape_sequence_str(here(cur));
+          }
         }
+        extract(cur);
+        break;
       }
     }
 
-    extract(strm, curr);
-    next = peek(strm);
+    const char *run = cur.pos;
+    string_run(cur);
+    buf.append(run, cur.pos);
   }
-
-  extract(strm, curr);
-
-  return token{literal{std::move(buf)}, start};
 }
 
-inline token starts_with_sign(std::istream &strm, location &curr) {
-  const location start = curr;
-  const char sign = peek(strm);
-  extract(strm, curr);
-
-  if(strm.eof()) {
-    return token {sign == '+' ? symbol::PLUS : symbol::MINUS, start};
-  }
-
-  const char next = peek(strm);
-  if(isdigit(next)) return read_decimal(strm, start, curr, std::string{sign});
-  if(sign == '+') {
-    if(next == '+') {
-      extract(strm, curr);
-      return token{symbol::INCREMENT, start};
-    }
-    if(next == '=') {
-      extract(strm, curr);
-      return token{symbol::PLUS_ASSIGN, start};
-    }
-    return token{symbol::PLUS, start};
-  }
-  // else -> sign == '-'
-  if(next == '-') {
-    extract(strm, curr);
-    return token{symbol::DECREMENT, start};
-  }
-  if(next == '=') {
-    extract(strm, curr);
-    return token{symbol::MINUS_ASSIGN, start};
-  }
-  return token{symbol::MINUS, start};
+inline token signed_number(cursor &cur) {
+  const location start = here(cur);
+  const char *first = cur.pos;
+  extract(cur); // sign, read_decimal handles it through the text span
+  return read_decimal(cur, first, start);
 }
 
-inline void skip_line_comment(std::istream &strm, location &curr) {
-  extract(strm, curr); // extract second '/' of '//'
-  while(!strm.eof() && peek(strm) != '\n') extract(strm, curr);
-  extract(strm, curr, true); // eat newline
+inline void skip_line_comment(cursor &cur) {
+  extract(cur); // extract second '/' of '//'
+  cur.pos = scan::find_newline(cur.pos, cur.end);
+  if(!at_end(cur)) extract(cur); // eat newline
 }
 
-inline void skip_block_comment(std::istream &strm, location &curr) {
+inline void skip_block_comment(cursor &cur) {
   size_t depth = 1;
   bool was_star = false;
   bool was_slash = false;
 
   while(depth > 0) {
-    if(strm.eof()) {
-      logger << unterminated_block_comment(curr);
+    // only '*' and '/' matter; anything in between resets the state
+    if(const char *delim = scan::find_comment_delim(cur.pos, cur.end); delim != cur.pos) {
+      was_star = false;
+      was_slash = false;
+      cur.pos = delim;
+    }
+
+    if(at_end(cur)) {
+      logger << unterminated_block_comment(here(cur));
       return;
     }
 
-    const char next = peek(strm);
-    extract(strm, curr, next == '\n');
+    const char next = peek(cur);
+    extract(cur);
 
     if(next == '/') {
       if(was_star) { // '*/'
@@ -330,107 +447,54 @@ inline void skip_block_comment(std::istream &strm, location &curr) {
   }
 }
 
-inline token div_or_comment(std::istream &strm, location &curr) {
-  const location start = curr;
-  extract(strm, curr); // current is '/'
+inline token comment(cursor &cur) {
+  const location start = here(cur);
+  extract(cur); // current is '/'
 
-  switch(peek(strm)) {
-    case '/': {
-      skip_line_comment(strm, curr);
-      break;
-    }
-    case '*': {
-      skip_block_comment(strm, curr);
-      break;
-    }
-    case '=': {
-      extract(strm, curr);
-      return token{symbol::DIVIDE_ASSIGN, start};
-    }
-    default: return token{symbol::DIVIDE, start};
-  }
+  if(peek(cur) == '/') skip_line_comment(cur);
+  else skip_block_comment(cur);
 
   return token{invalid_ignored{}, start};
 }
 
-inline token multi_matcher(
-  const symbol no_match, std::initializer_list<std::pair<char, symbol>> matchers, std::istream &strm,
-  const location &start, location &curr
-) {
-  const char next = peek(strm);
-  for(const auto &[c, s]: matchers) {
-    if(next == c) {
-      extract(strm, curr);
-      return token{s, start};
+inline token symbol_token(cursor &cur) {
+  const location start = here(cur);
+  uint8_t state = operator_dfa::start;
+  uint8_t accepted = operator_dfa::no_symbol;
+  const char *accepted_end = cur.pos;
+
+  // maximal munch: run the DFA until it dies, then fall back to the last accepting state
+  for(const char *p = cur.pos; p < cur.end; ++p) {
+    state = operator_table.next[state][static_cast<uint8_t>(*p)];
+    if(state == operator_dfa::dead) break;
+    if(operator_table.accepts[state] != operator_dfa::no_symbol) {
+      accepted = operator_table.accepts[state];
+      accepted_end = p + 1;
     }
   }
-  return token{no_match, start};
-}
 
-inline token symbol_token(std::istream &strm, location &curr) {
-  const location start = curr;
-  const char fst = peek(strm); // will never be +, -, or /
-  extract(strm, curr);
-
-  switch(fst) {
-    // no case '+' (also no '++')
-    // no case '-' (also no '--')
-    case '*': return multi_matcher(symbol::MULTIPLY, {{'=', symbol::MULTIPLY_ASSIGN}}, strm, start, curr);
-    // no case '/' (also no '//' or '/*')
-    case '%': return multi_matcher(symbol::MODULO, {{'=', symbol::MODULO_ASSIGN}}, strm, start, curr);
-    case '=': return multi_matcher(
-      symbol::ASSIGN,
-      {{'=', symbol::EQUALS}, {'>', symbol::ARROW}},
-      strm, start, curr
-    );
-    case '!': return multi_matcher(symbol::NOT, {{'=', symbol::NOT_EQUALS}}, strm, start, curr);
-    case '<': return multi_matcher(
-      symbol::LESS_THAN,
-      {{'=', symbol::LESS_THAN_EQUALS}, {'<', symbol::SHIFT_LEFT}},
-      strm, start, curr
-    );
-    case '>': return multi_matcher(
-      symbol::GREATER_THAN,
-      {{'=', symbol::GREATER_THAN_EQUALS}, {'>', symbol::SHIFT_RIGHT}},
-      strm, start, curr
-    );
-    case '&': return multi_matcher(symbol::BIT_AND, {{'&', symbol::AND}, {'=', symbol::BIT_AND_ASSIGN}}, strm, start, curr);
-    case '|': return multi_matcher(symbol::BIT_OR, {{'|', symbol::OR}, {'=', symbol::BIT_OR_ASSIGN}}, strm, start, curr);
-    case '~': return token{symbol::BIT_NEG, start};
-    case '^': return multi_matcher(symbol::XOR, {{'=', symbol::XOR_ASSIGN}}, strm, start, curr);
-    case '.': return token{symbol::DOT, start};
-    case ':': return multi_matcher(symbol::COLON, {{':', symbol::NAMESPACE}}, strm, start, curr);
-    case '(': return token{symbol::PAREN_OPEN, start};
-    case ')': return token{symbol::PAREN_CLOSE, start};
-    case '[': return token{symbol::BRACKET_OPEN, start};
-    case ']': return token{symbol::BRACKET_CLOSE, start};
-    case '{': return token{symbol::BRACE_OPEN, start};
-    case '}': return token{symbol::BRACE_CLOSE, start};
-    case ',': return token{symbol::COMMA, start};
-    case ';': return token{symbol::SEMI, start};
-    case '?': return token{symbol::QUESTION, start};
-    default: {
-      logger << invalid_token(fst, start);
-      return token{invalid_ignored{}, start};
-    }
+  if(accepted == operator_dfa::no_symbol) {
+    logger << invalid_token(*cur.pos, start);
+    extract(cur);
+    return token{invalid_ignored{}, start};
   }
+
+  cur.pos = accepted_end;
+  return token{static_cast<symbol>(accepted), start};
 }
 }
 
-token jayc::lexer::read_token(std::istream &strm, location &curr) {
-  char next = peek(strm);
-  while(is_whitespace(next) && !strm.eof()) {
-    extract(strm, curr, next == '\n');
-    next = peek(strm);
-  }
+token jayc::lexer::read_token(cursor &cur) {
+  cur.pos = scan::skip_whitespace(cur.pos, cur.end);
 
-  if(strm.eof()) return token{eof{}, curr};
+  if(at_end(cur)) return token{eof{}, here(cur)};
 
-  if(isdigit(next)) return numerical_no_sign(strm, curr); // definitely numerical
-  if(isalpha(next) || next == '_') return id_kw_bool(strm, curr); // identifier or keyword or bool literal
-  if(next == '\'') return char_lit(strm, curr); // character literal
-  if(next == '"') return string_lit(strm, curr); // string literal
-  if(next == '+' || next == '-') return starts_with_sign(strm, curr); // either symbol or numerical
-  if(next == '/') return div_or_comment(strm, curr); // divide or comment
-  return symbol_token(strm, curr);
-}
\ No newline at end of file
+  const char next = *cur.pos;
+  if(isdigit(next)) return numerical_no_sign(cur); // definitely numerical
+  if(isalpha(next) || next == '_') return id_kw_bool(cur); // identifier or keyword or bool literal
+  if(next == '\'') return char_lit(cur); // character literal
+  if(next == '"') return string_lit(cur); // string literal
+  if((next == '+' || next == '-') && cur.pos + 1 < cur.end && isdigit(cur.pos[1])) return signed_number(cur);
+  if(next == '/' && cur.pos + 1 < cur.end && (cur.pos[1] == '/' || cur.pos[1] == '*')) return comment(cur);
+  return symbol_token(cur); // operator or punctuation
+}
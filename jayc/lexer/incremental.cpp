@@ -0,0 +1,125 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <algorithm>
+
+#include "incremental.hpp"
+#include "lexer.hpp"
+#include "error.hpp"
+
+using namespace jayc;
+using namespace jayc::lexer;
+
+namespace {
+std::string edited_text(const source_buffer &old, const std::vector<text_edit> &edits) {
+  std::string res;
+  res.reserve(old.size());
+  uint32_t at = 0;
+  for(const auto &e : edits) {
+    res.append(old.begin() + at, old.begin() + e.offset);
+    res += e.inserted;
+    at = e.offset + e.removed;
+  }
+  res.append(old.begin() + at, old.end());
+  return res;
+}
+
+token shifted(token t, const int64_t delta) {
+  t.pos.offset = static_cast<uint32_t>(t.pos.offset + delta);
+  return t;
+}
+
+size_t first_at_or_after(const std::vector<token> &tokens, const size_t from, const uint32_t offset) {
+  const auto it = std::ranges::lower_bound(tokens.begin() + static_cast<ptrdiff_t>(from), tokens.end(), offset, {},
+                                           [](const token &t) { return t.pos.offset; });
+  return static_cast<size_t>(it - tokens.begin());
+}
+}
+
+relex_result jayc::lexer::relex(const file_id file, const std::vector<token> &previous, std::vector<text_edit> edits) {
+  const auto old = sources.buffer(file);
+  if(old == nullptr) {
+    logger << error{ location{file, 0}, "Cannot re-lex a file without source buffer." };
+    throw unrecoverable{};
+  }
+
+  std::ranges::sort(edits, {}, &text_edit::offset);
+  for(size_t e = 0; e < edits.size(); e++) {
+    const auto end = static_cast<uint64_t>(edits[e].offset) + edits[e].removed;
+    if(end > old->size() || (e + 1 < edits.size() && end > edits[e + 1].offset)) {
+      logger << error{ location{file, edits[e].offset}, "Edits must be in range and must not overlap." };
+      throw unrecoverable{};
+    }
+  }
+
+  relex_result res;
+  auto buffer = source_buffer::from_string(edited_text(*old, edits));
+  sources.replace_buffer(file, buffer);
+  if(edits.empty() || previous.empty()) {
+    res.tokens = previous;
+    return res;
+  }
+
+  cursor cur{buffer.get(), file, &sources.payloads(file), buffer->begin(), buffer->begin(), buffer->end()};
+  res.tokens.reserve(previous.size());
+
+  size_t i = 0; // next old token to carry over
+  int64_t delta = 0; // shift (new - old offset) for text before edits[e]
+  size_t e = 0;
+  bool first_pass = true;
+  while(e < edits.size()) {
+    // restart at the last token starting before the edit: it may run into the edited bytes
+    const size_t found = first_at_or_after(previous, i, edits[e].offset);
+    const size_t restart = found > i ? found - 1 : i;
+    for(; i < restart; i++) res.tokens.push_back(shifted(previous[i], delta));
+    if(first_pass) res.first = res.tokens.size();
+    first_pass = false;
+
+    cur.pos = cur.begin + (restart == 0 && previous[0].pos.offset >= edits[e].offset ? 0 : previous[restart].pos.offset + delta);
+    int64_t after = delta + static_cast<int64_t>(edits[e].inserted.size()) - edits[e].removed; // shift past edits[e]
+
+    bool synced = false;
+    while(!synced) {
+      token t = read_token(cur);
+      if(is<invalid_ignored>(t)) continue;
+      if(is<eof>(t)) {
+        // ran to the end: no old token lines up anymore, every remaining edit is covered
+        res.tokens.push_back(t);
+        i = previous.size();
+        e = edits.size();
+        break;
+      }
+
+      // edits that start before this token are part of the same re-lexed range
+      while(e + 1 < edits.size() && t.pos.offset >= edits[e + 1].offset + after) {
+        ++e;
+        after += static_cast<int64_t>(edits[e].inserted.size()) - edits[e].removed;
+      }
+
+      const auto edit_end = static_cast<int64_t>(edits[e].offset) + edits[e].removed + after;
+      if(t.pos.offset >= edit_end) {
+        // past the edit, text matches the old text up to the next edit; a token starting at the same (shifted) spot
+        // as an old one means the lexer is back in sync
+        const int64_t old_offset = t.pos.offset - after;
+        if(e + 1 == edits.size() || old_offset < edits[e + 1].offset) {
+          const size_t j = first_at_or_after(previous, i, static_cast<uint32_t>(old_offset));
+          if(j < previous.size() && previous[j].pos.offset == old_offset && previous[j].value() == t.value()) {
+            i = j;
+            delta = after;
+            ++e;
+            synced = true;
+            continue;
+          }
+        }
+      }
+      res.tokens.push_back(t);
+    }
+
+    res.old_end = i;
+    res.new_end = res.tokens.size();
+  }
+
+  for(; i < previous.size(); i++) res.tokens.push_back(shifted(previous[i], delta));
+  return res;
+}
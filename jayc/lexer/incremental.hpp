@@ -0,0 +1,34 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef INCREMENTAL_HPP
+#define INCREMENTAL_HPP
+
+#include <string>
+#include <vector>
+
+#include "token_stream.hpp"
+
+namespace jayc::lexer {
+// replaces the bytes [offset, offset + removed) of the previous text by inserted
+struct text_edit {
+  uint32_t offset; //!< Start of the edit, in the previous text
+  uint32_t removed = 0; //!< Number of bytes removed
+  std::string inserted{}; //!< Text inserted in their place
+};
+
+struct relex_result {
+  std::vector<token> tokens; //!< The updated (eof-terminated) token buffer
+  size_t first = 0; //!< First re-lexed token; tokens before it are unchanged
+  size_t old_end = 0; //!< End (exclusive) of the replaced range in the previous buffer
+  size_t new_end = 0; //!< End (exclusive) of the replacement range in tokens; later tokens are the old ones, shifted
+};
+
+// applies the (non-overlapping) edits to the file and updates its token buffer (as produced by token_stream::drain)
+// lexing restarts at the last token starting before each edit and stops as soon as the new tokens line up with the
+// old ones again; the file keeps its ID, so payloads of the tokens that survive the edit remain valid
+relex_result relex(file_id file, const std::vector<token> &previous, std::vector<text_edit> edits);
+}
+
+#endif //INCREMENTAL_HPP
@@ -18,6 +18,10 @@ inline error incomplete_hex(const location &pos) {
   return error{ pos, "Incomplete hexadecimal integer literal." };
 }
 
+inline error literal_out_of_range(const location &pos) {
+  return error{ pos, "Numeric literal out of range." };
+}
+
 inline error unterminated_char(const location &pos) {
   return error{ pos, "Unterminated character literal." };
 }
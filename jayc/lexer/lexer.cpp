@@ -10,19 +10,20 @@
 
 using jayc::location;
 using jayc::logger;
+using jayc::sources;
 using namespace jayc::lexer;
 
-token_stream<lexer<std::ifstream>> jayc::lexer::lex(const std::string &file) {
-  std::ifstream strm{file};
+token_stream<lexer> jayc::lexer::lex(const std::string &file) {
+  auto buffer = source_buffer::map_file(file);
 
-  if(!strm.is_open() || !strm.good()) {
-    logger << error{ location{file, 1, 0}, "Failed to open file `" + file + "`." };
+  if(buffer == nullptr) {
+    logger << error{ location{sources.add_file(file), 0}, "Failed to open file `" + file + "`." };
     throw unrecoverable{};
   }
 
-  return token_stream{lexer{file, std::move(strm)}};
+  return token_stream{lexer{file, std::move(buffer)}};
 }
 
-token_stream<lexer<std::stringstream>> jayc::lexer::lex_source(const std::string &source) {
-  return token_stream{lexer{"<inline script>", std::stringstream{source}}};
-}
\ No newline at end of file
+token_stream<lexer> jayc::lexer::lex_source(const std::string &source) {
+  return token_stream{lexer{"<inline script>", source_buffer::from_string(source)}};
+}
@@ -6,32 +6,49 @@
 #define LEXER_HPP
 
 #include <string>
-#include <iostream>
-#include <sstream>
-#include <fstream>
+#include <memory>
 #include "token_stream.hpp"
+#include "source_buffer.hpp"
 
 namespace jayc::lexer {
-token read_token(std::istream &strm, location &curr);
+struct cursor {
+  source_buffer *buffer;
+  file_id file;
+  token_payloads *payloads;
+  const char *begin;
+  const char *pos;
+  const char *end;
+};
+
+token read_token(cursor &cur);
 
-template <typename Stream> requires(std::derived_from<Stream, std::istream>)
 class lexer {
 public:
-  explicit lexer(const std::string &file, Stream &&strm)
-      : input{std::move(strm)}, curr{file, 1, 1} {}
-
-  token operator()() { return read_token(input, curr); }
-
-  [[nodiscard]] inline bool eof() const { return input.eof() || !input.good(); }
-  [[nodiscard]] constexpr location pos() const { return curr; }
+  explicit lexer(const std::string &file, std::shared_ptr<source_buffer> buffer)
+      : buffer{std::move(buffer)}, cur{this->buffer.get(), sources.add_file(file, this->buffer), nullptr,
+                                       this->buffer->begin(), this->buffer->begin(), this->buffer->end()} {
+    cur.payloads = &sources.payloads(cur.file);
+  }
+
+  token operator()() {
+    token t = read_token(cur);
+    if(t.kind == token_kind::EOF_TOKEN) done = true;
+    return t;
+  }
+
+  [[nodiscard]] constexpr bool eof() const { return done; }
+  [[nodiscard]] constexpr location pos() const {
+    return location{ cur.file, static_cast<uint32_t>(cur.pos - cur.begin) };
+  }
 
 private:
-  Stream input;
-  location curr{};
+  std::shared_ptr<source_buffer> buffer;
+  cursor cur;
+  bool done = false;
 };
 
-token_stream<lexer<std::ifstream>> lex(const std::string &file);
-token_stream<lexer<std::stringstream>> lex_source(const std::string &source);
+token_stream<lexer> lex(const std::string &file);
+token_stream<lexer> lex_source(const std::string &source);
 }
 
 #endif //LEXER_HPP
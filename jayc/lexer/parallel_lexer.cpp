@@ -0,0 +1,132 @@
+//
+// Created by jay on 9/19/24.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "parallel_lexer.hpp"
+#include "lexer.hpp"
+#include "scan.hpp"
+#include "error.hpp"
+
+using namespace jayc;
+using namespace jayc::lexer;
+
+namespace {
+struct chunk {
+  uint32_t begin; //!< Offset at which lexing starts (speculative until reconciled)
+  uint32_t limit; //!< Tokens starting at or after this offset belong to the next chunk
+  uint32_t resume = 0; //!< Offset at which a sequential lexer would continue after this chunk's tokens
+  std::vector<token> tokens{};
+  std::vector<error_queue::message> messages{};
+};
+
+void lex_chunk(chunk &c, cursor cur, const bool last) {
+  c.tokens.clear();
+  c.messages.clear();
+  error_queue::capture guard{c.messages};
+
+  cur.pos = cur.begin + c.begin;
+  while(true) {
+    const char *before = cur.pos;
+    const size_t logged = c.messages.size();
+    const token t = read_token(cur);
+
+    if(t.kind == token_kind::EOF_TOKEN) {
+      if(last) c.tokens.push_back(t);
+      cur.pos = before;
+      break;
+    }
+    if(t.pos.offset >= c.limit) {
+      // the next chunk lexes (and reports) this token
+      c.messages.resize(logged);
+      cur.pos = before;
+      break;
+    }
+    c.tokens.push_back(t);
+  }
+
+  c.resume = static_cast<uint32_t>(cur.pos - cur.begin);
+}
+
+std::vector<chunk> split(const source_buffer &buffer, size_t count) {
+  const auto size = static_cast<uint32_t>(buffer.size());
+  std::vector<chunk> res;
+  uint32_t at = 0;
+  for(size_t i = 1; i < count && at < size; i++) {
+    const auto target = static_cast<uint32_t>(size * i / count);
+    if(target <= at) continue;
+    const char *nl = scan::find_newline(buffer.begin() + target, buffer.end());
+    const auto boundary = static_cast<uint32_t>(std::min(nl + 1, buffer.end()) - buffer.begin());
+    if(boundary >= size) break;
+    res.push_back(chunk{ .begin = at, .limit = boundary });
+    at = boundary;
+  }
+  res.push_back(chunk{ .begin = at, .limit = size });
+  return res;
+}
+
+std::vector<token> lex_buffer(const std::string &name, std::shared_ptr<source_buffer> buffer, size_t count) {
+  const file_id file = sources.add_file(name, buffer);
+  const cursor cur{buffer.get(), file, &sources.payloads(file), buffer->begin(), buffer->begin(), buffer->end()};
+
+  if(count == 0) {
+    count = std::clamp<size_t>(buffer->size() / min_parallel_chunk, 1, std::max(1u, std::thread::hardware_concurrency()));
+  }
+  auto chunks = split(*buffer, count);
+
+  // an explicit chunk count may exceed the core count; workers take chunks in order until none are left
+  const size_t threads = std::clamp<size_t>(chunks.size(), 1, std::max(1u, std::thread::hardware_concurrency()));
+  std::atomic<size_t> next{0};
+  const auto work = [&chunks, &cur, &next] {
+    for(size_t i = next++; i < chunks.size(); i = next++) lex_chunk(chunks[i], cur, i + 1 == chunks.size());
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+    for(size_t i = 1; i < threads; i++) workers.emplace_back(work);
+    work();
+  }
+
+  // reconcile: a chunk's speculative result holds iff the previous chunk's last token ends before its start
+  // (anything in between is whitespace); otherwise it started in a comment or literal and is lexed again
+  for(size_t i = 1; i < chunks.size(); i++) {
+    if(chunks[i - 1].resume > chunks[i].begin) {
+      chunks[i].begin = chunks[i - 1].resume;
+      lex_chunk(chunks[i], cur, i + 1 == chunks.size());
+    }
+  }
+
+  std::vector<token> res;
+  size_t total = 0;
+  for(const auto &c : chunks) total += c.tokens.size();
+  res.reserve(total);
+  for(const auto &c : chunks) {
+    logger.replay(c.messages);
+    if(!c.tokens.empty()) {
+      const auto count = static_cast<uint32_t>(c.tokens.size());
+      trace(trace_category::LEXER, trace_event::TOKENS_LEXED, c.tokens.front().pos, count);
+    }
+    std::ranges::copy_if(c.tokens, std::back_inserter(res), [](const token &t) { return !is<invalid_ignored>(t); });
+  }
+  return res;
+}
+}
+
+std::vector<token> jayc::lexer::lex_parallel(const std::string &file, const size_t chunks) {
+  auto buffer = source_buffer::map_file(file);
+
+  if(buffer == nullptr) {
+    logger << error{ location{sources.add_file(file), 0}, "Failed to open file `" + file + "`." };
+    throw unrecoverable{};
+  }
+
+  return lex_buffer(file, std::move(buffer), chunks);
+}
+
+std::vector<token> jayc::lexer::lex_source_parallel(const std::string &source, const size_t chunks) {
+  return lex_buffer("<inline script>", source_buffer::from_string(source), chunks);
+}
@@ -0,0 +1,25 @@
+//
+// Created by jay on 9/19/24.
+//
+
+#ifndef PARALLEL_LEXER_HPP
+#define PARALLEL_LEXER_HPP
+
+#include <string>
+#include <vector>
+
+#include "token_stream.hpp"
+
+namespace jayc::lexer {
+// below this many bytes per chunk, splitting costs more than it gains
+constexpr size_t min_parallel_chunk = 64 * 1024;
+
+// lexes a file on several threads: the buffer is split at newlines and each chunk is lexed speculatively, assuming it
+// starts outside any comment or literal; chunks for which that assumption turns out wrong are re-lexed afterwards
+// the result (tokens and diagnostics) is identical to lex(file).drain()
+// chunks = 0 -> one chunk per hardware thread, but at least min_parallel_chunk bytes per chunk
+std::vector<token> lex_parallel(const std::string &file, size_t chunks = 0);
+std::vector<token> lex_source_parallel(const std::string &source, size_t chunks = 0);
+}
+
+#endif //PARALLEL_LEXER_HPP
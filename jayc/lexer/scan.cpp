@@ -0,0 +1,159 @@
+//
+// Created by jay on 9/18/24.
+//
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JAYC_HAS_X86_SIMD 1
+#else
+#define JAYC_HAS_X86_SIMD 0
+#endif
+
+#include "scan.hpp"
+
+using namespace jayc::lexer;
+
+namespace {
+// Skip = false: find the first byte in the set; Skip = true: find the first byte *not* in the set
+template <bool Skip, char ... Needles>
+const char *find_scalar(const char *p, const char *end) {
+  for(; p < end; ++p) {
+    if(((*p == Needles) || ...) != Skip) return p;
+  }
+  return end;
+}
+
+template <char Needle>
+size_t count_scalar(const char *p, const char *end) {
+  size_t res = 0;
+  for(; p < end; ++p) res += *p == Needle;
+  return res;
+}
+
+#if JAYC_HAS_X86_SIMD
+template <bool Skip, char ... Needles>
+__attribute__((target("sse2"))) const char *find_sse2(const char *p, const char *end) {
+  for(; end - p >= 16; p += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hits = _mm_setzero_si128();
+    ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Needles)))), ...);
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+    if constexpr(Skip) mask = ~mask & 0xffffu;
+    if(mask != 0) return p + std::countr_zero(mask);
+  }
+  return find_scalar<Skip, Needles...>(p, end);
+}
+
+template <char Needle>
+__attribute__((target("sse2,popcnt"))) size_t count_sse2(const char *p, const char *end) {
+  size_t res = 0;
+  const __m128i needle = _mm_set1_epi8(Needle);
+  for(; end - p >= 16; p += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    res += std::popcount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle))));
+  }
+  return res + count_scalar<Needle>(p, end);
+}
+
+template <bool Skip, char ... Needles>
+__attribute__((target("avx2,bmi"))) const char *find_avx2(const char *p, const char *end) {
+  for(; end - p >= 32; p += 32) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i hits = _mm256_setzero_si256();
+    ((hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(Needles)))), ...);
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+    if constexpr(Skip) mask = ~mask;
+    if(mask != 0) return p + std::countr_zero(mask);
+  }
+  return find_sse2<Skip, Needles...>(p, end);
+}
+
+template <char Needle>
+__attribute__((target("avx2,popcnt"))) size_t count_avx2(const char *p, const char *end) {
+  size_t res = 0;
+  const __m256i needle = _mm256_set1_epi8(Needle);
+  for(; end - p >= 32; p += 32) {
+    const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    res += std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle))));
+  }
+  return res + count_sse2<Needle>(p, end);
+}
+#endif
+
+struct kernels {
+  scan::level lvl;
+  const char *(*skip_whitespace)(const char *, const char *);
+  const char *(*find_newline)(const char *, const char *);
+  const char *(*find_comment_delim)(const char *, const char *);
+  const char *(*find_string_stop)(const char *, const char *);
+  size_t (*count_newlines)(const char *, const char *);
+};
+
+#define JAYC_SCAN_KERNELS(lvl, find, count) kernels { \
+    lvl, \
+    find<true, ' ', '\n', '\t', '\v'>, \
+    find<false, '\n'>, \
+    find<false, '*', '/'>, \
+    find<false, '"', '\\', '\n'>, \
+    count<'\n'> \
+  }
+
+constexpr kernels scalar_kernels = JAYC_SCAN_KERNELS(scan::level::SCALAR, find_scalar, count_scalar);
+#if JAYC_HAS_X86_SIMD
+constexpr kernels sse2_kernels = JAYC_SCAN_KERNELS(scan::level::SSE2, find_sse2, count_sse2);
+constexpr kernels avx2_kernels = JAYC_SCAN_KERNELS(scan::level::AVX2, find_avx2, count_avx2);
+#endif
+
+#undef JAYC_SCAN_KERNELS
+
+const kernels *kernels_for(const scan::level l) {
+  switch(l) {
+#if JAYC_HAS_X86_SIMD
+    case scan::level::AVX2: return &avx2_kernels;
+    case scan::level::SSE2: return &sse2_kernels;
+#endif
+    default: return &scalar_kernels;
+  }
+}
+
+std::atomic<const kernels *> active{nullptr};
+
+const kernels &current() {
+  const kernels *k = active.load(std::memory_order_relaxed);
+  if(k != nullptr) return *k;
+
+  auto best = scan::level::SCALAR;
+  if(scan::supported(scan::level::AVX2)) best = scan::level::AVX2;
+  else if(scan::supported(scan::level::SSE2)) best = scan::level::SSE2;
+  k = kernels_for(best);
+  active.store(k, std::memory_order_relaxed);
+  return *k;
+}
+}
+
+bool scan::supported(const level l) {
+  switch(l) {
+    case level::SCALAR: return true;
+#if JAYC_HAS_X86_SIMD
+    case level::SSE2: return __builtin_cpu_supports("sse2");
+    case level::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("popcnt");
+#endif
+    default: return false;
+  }
+}
+
+scan::level scan::active_level() { return current().lvl; }
+
+void scan::force_level(const level l) {
+  active.store(kernels_for(supported(l) ? l : level::SCALAR), std::memory_order_relaxed);
+}
+
+const char *scan::skip_whitespace(const char *p, const char *end) { return current().skip_whitespace(p, end); }
+const char *scan::find_newline(const char *p, const char *end) { return current().find_newline(p, end); }
+const char *scan::find_comment_delim(const char *p, const char *end) { return current().find_comment_delim(p, end); }
+const char *scan::find_string_stop(const char *p, const char *end) { return current().find_string_stop(p, end); }
+size_t scan::count_newlines(const char *p, const char *end) { return current().count_newlines(p, end); }
@@ -0,0 +1,26 @@
+//
+// Created by jay on 9/18/24.
+//
+
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+#include <cstddef>
+
+namespace jayc::lexer::scan {
+// bulk scanning kernels; each returns the first position in [p, end) that stops the scan (or end)
+enum struct level { SCALAR, SSE2, AVX2 };
+
+// the best level the CPU supports is picked on first use; force_level is meant for tests and benchmarks
+level active_level();
+void force_level(level l);
+bool supported(level l);
+
+const char *skip_whitespace(const char *p, const char *end); //!< first byte that is not ' ', '\n', '\t' or '\v'
+const char *find_newline(const char *p, const char *end); //!< first '\n'
+const char *find_comment_delim(const char *p, const char *end); //!< first '*' or '/'
+const char *find_string_stop(const char *p, const char *end); //!< first '"', '\\' or '\n'
+size_t count_newlines(const char *p, const char *end);
+}
+
+#endif //SCAN_HPP
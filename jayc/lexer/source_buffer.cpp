@@ -0,0 +1,83 @@
+//
+// Created by jay on 9/16/24.
+//
+
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JAYC_HAS_MMAP 1
+#else
+#define JAYC_HAS_MMAP 0
+#endif
+
+#include "source_buffer.hpp"
+
+using namespace jayc::lexer;
+
+namespace {
+bool try_map(const std::string &file, const char *&data, size_t &length) {
+#if JAYC_HAS_MMAP
+  const int fd = open(file.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+
+  struct stat st{};
+  if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+    // empty files can't be mapped; irregular files (pipes, ...) should be read
+    close(fd);
+    return false;
+  }
+
+  void *ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(ptr == MAP_FAILED) return false;
+
+  madvise(ptr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+  data = static_cast<const char *>(ptr);
+  length = static_cast<size_t>(st.st_size);
+  return true;
+#else
+  return false;
+#endif
+}
+}
+
+std::shared_ptr<source_buffer> source_buffer::map_file(const std::string &file) {
+  std::shared_ptr<source_buffer> res{new source_buffer};
+  if(try_map(file, res->data, res->length)) {
+    res->mapped = true;
+    return res;
+  }
+
+  std::ifstream strm{file, std::ios::binary};
+  if(!strm.is_open() || !strm.good()) return nullptr;
+
+  res->owned.assign(std::istreambuf_iterator<char>{strm}, std::istreambuf_iterator<char>{});
+  res->data = res->owned.data();
+  res->length = res->owned.size();
+  return res;
+}
+
+std::shared_ptr<source_buffer> source_buffer::from_string(std::string source) {
+  std::shared_ptr<source_buffer> res{new source_buffer};
+  res->owned = std::move(source);
+  res->data = res->owned.data();
+  res->length = res->owned.size();
+  return res;
+}
+
+std::string_view source_buffer::store(std::string decoded_str) {
+  std::lock_guard guard{lock};
+  return decoded.emplace_back(std::move(decoded_str));
+}
+
+source_buffer::~source_buffer() {
+#if JAYC_HAS_MMAP
+  if(mapped) munmap(const_cast<char *>(data), length);
+#endif
+}
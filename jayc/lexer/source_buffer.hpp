@@ -0,0 +1,50 @@
+//
+// Created by jay on 9/16/24.
+//
+
+#ifndef SOURCE_BUFFER_HPP
+#define SOURCE_BUFFER_HPP
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace jayc::lexer {
+class source_buffer {
+public:
+  source_buffer(const source_buffer &) = delete;
+  source_buffer(source_buffer &&) = delete;
+  source_buffer &operator=(const source_buffer &) = delete;
+  source_buffer &operator=(source_buffer &&) = delete;
+
+  // maps the file into memory (falls back to reading it if mapping is not possible)
+  static std::shared_ptr<source_buffer> map_file(const std::string &file);
+  // takes ownership of an in-memory source
+  static std::shared_ptr<source_buffer> from_string(std::string source);
+
+  [[nodiscard]] constexpr const char *begin() const { return data; }
+  [[nodiscard]] constexpr const char *end() const { return data + length; }
+  [[nodiscard]] constexpr size_t size() const { return length; }
+  [[nodiscard]] constexpr std::string_view view() const { return {data, length}; }
+
+  // keeps a decoded string (e.g. string literal with escapes) alive as long as the buffer; thread-safe
+  std::string_view store(std::string decoded);
+
+  ~source_buffer();
+
+private:
+  source_buffer() = default;
+
+  const char *data = nullptr;
+  size_t length = 0;
+  bool mapped = false;
+  std::string owned{};
+  std::mutex lock;
+  std::deque<std::string> decoded{};
+};
+}
+
+#endif //SOURCE_BUFFER_HPP
@@ -0,0 +1,220 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "token_cache.hpp"
+#include "source_buffer.hpp"
+#include "source_manager.hpp"
+
+using namespace jayc;
+using namespace jayc::lexer;
+
+namespace {
+constexpr char magic[4] = { 'J', 'T', 'O', 'K' };
+
+struct header {
+  char magic[4];
+  uint32_t version;
+  uint64_t source_hash;
+  uint32_t token_count;
+  uint32_t wide_count;
+  uint32_t string_count;
+  uint32_t pool_size;
+};
+
+struct cached_token {
+  uint8_t kind;
+  uint8_t sub;
+  uint16_t reserved;
+  uint32_t payload; //!< Inline bits, or index into the wide literal or string table
+};
+
+struct string_entry {
+  uint32_t offset;
+  uint32_t length;
+};
+
+static_assert(std::is_trivially_copyable_v<header> && sizeof(header) == 32);
+static_assert(std::is_trivially_copyable_v<cached_token> && sizeof(cached_token) == 8);
+
+bool uses_wide(const token_kind kind, const uint8_t sub) {
+  return sub != 0 && (kind == token_kind::INT64 || kind == token_kind::UINT64 || kind == token_kind::FLOAT64);
+}
+
+bool uses_string(const token_kind kind) {
+  return kind == token_kind::IDENTIFIER || kind == token_kind::STRING;
+}
+
+template <typename T>
+void write_all(std::ofstream &out, const std::vector<T> &data) {
+  out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+}
+
+// bounds-checked sequential reads from the mapped cache
+class reader {
+public:
+  reader(const char *begin, const char *end) : at{begin}, end{end} {}
+
+  template <typename T>
+  bool read(T &out) {
+    if(static_cast<size_t>(end - at) < sizeof(T)) return false;
+    std::memcpy(&out, at, sizeof(T));
+    at += sizeof(T);
+    return true;
+  }
+
+  template <typename T>
+  bool read(std::vector<T> &out, const size_t count) {
+    if(static_cast<size_t>(end - at) / sizeof(T) < count) return false;
+    out.resize(count);
+    std::memcpy(out.data(), at, count * sizeof(T));
+    at += count * sizeof(T);
+    return true;
+  }
+
+  const char *take(const size_t count) {
+    if(static_cast<size_t>(end - at) < count) return nullptr;
+    const char *res = at;
+    at += count;
+    return res;
+  }
+
+  [[nodiscard]] bool done() const { return at == end; }
+
+private:
+  const char *at;
+  const char *end;
+};
+}
+
+uint64_t jayc::lexer::source_hash(const std::string_view source) {
+  // FNV-1a: stable across builds and platforms, unlike std::hash
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for(const char c : source) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+bool jayc::lexer::write_token_cache(const std::string &path, const file_id file, const std::vector<token> &tokens) {
+  const auto buffer = sources.buffer(file);
+  if(buffer == nullptr) return false;
+
+  std::vector<cached_token> records;
+  std::vector<uint32_t> offsets;
+  std::vector<uint64_t> wides;
+  std::vector<string_entry> table;
+  std::string pool;
+  std::unordered_map<std::string_view, uint32_t> seen;
+  records.reserve(tokens.size());
+  offsets.reserve(tokens.size());
+
+  const auto add_string = [&](const std::string_view str) {
+    if(const auto it = seen.find(str); it != seen.end()) return it->second;
+    table.push_back(string_entry{ static_cast<uint32_t>(pool.size()), static_cast<uint32_t>(str.size()) });
+    pool += str;
+    return seen[str] = static_cast<uint32_t>(table.size() - 1);
+  };
+
+  for(const auto &t : tokens) {
+    cached_token rec{ static_cast<uint8_t>(t.kind), t.sub, 0, t.payload };
+    if(t.kind == token_kind::IDENTIFIER) rec.payload = add_string(as<identifier>(t).ident.view());
+    else if(t.kind == token_kind::STRING) rec.payload = add_string(as<literal<std::string_view>>(t).value);
+    else if(uses_wide(t.kind, t.sub)) {
+      wides.push_back(internal_::wide_payload(t));
+      rec.payload = static_cast<uint32_t>(wides.size() - 1);
+    }
+    records.push_back(rec);
+    offsets.push_back(t.pos.offset);
+  }
+
+  const header head{
+    { magic[0], magic[1], magic[2], magic[3] }, token_cache_version, source_hash(buffer->view()),
+    static_cast<uint32_t>(records.size()), static_cast<uint32_t>(wides.size()), static_cast<uint32_t>(table.size()),
+    static_cast<uint32_t>(pool.size())
+  };
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if(!out) return false;
+  out.write(reinterpret_cast<const char *>(&head), sizeof(header));
+  write_all(out, records);
+  write_all(out, offsets);
+  write_all(out, wides);
+  write_all(out, table);
+  out.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+  return static_cast<bool>(out);
+}
+
+std::optional<cached_lexer> cached_lexer::load(const std::string &path, const std::string &source_file) {
+  const auto cache = source_buffer::map_file(path);
+  if(cache == nullptr) return std::nullopt;
+
+  reader in{cache->begin(), cache->end()};
+  header head{};
+  if(!in.read(head) || std::memcmp(head.magic, magic, sizeof(magic)) != 0 || head.version != token_cache_version) {
+    return std::nullopt;
+  }
+
+  auto source = source_buffer::map_file(source_file);
+  if(source == nullptr || source_hash(source->view()) != head.source_hash) return std::nullopt;
+
+  std::vector<cached_token> records;
+  std::vector<uint32_t> offsets;
+  std::vector<uint64_t> wides;
+  std::vector<string_entry> table;
+  const char *pool = nullptr;
+  if(!in.read(records, head.token_count) || !in.read(offsets, head.token_count) || !in.read(wides, head.wide_count) ||
+     !in.read(table, head.string_count) || (pool = in.take(head.pool_size)) == nullptr || !in.done()) {
+    return std::nullopt;
+  }
+
+  for(const auto &[offset, length] : table) {
+    if(offset > head.pool_size || length > head.pool_size - offset) return std::nullopt;
+  }
+  for(size_t i = 0; i < records.size(); i++) {
+    const auto &rec = records[i];
+    if(rec.kind > static_cast<uint8_t>(token_kind::BOOL) || offsets[i] > source->size()) return std::nullopt;
+    const auto kind = static_cast<token_kind>(rec.kind);
+    if((uses_string(kind) && rec.payload >= table.size()) || (uses_wide(kind, rec.sub) && rec.payload >= wides.size())) {
+      return std::nullopt;
+    }
+  }
+
+  // string literals view into the pool, which is kept alive by the source buffer
+  const std::string_view kept = source->store(std::string(pool, head.pool_size));
+  const file_id file = sources.add_file(source_file, source);
+  auto &payloads = sources.payloads(file);
+
+  std::vector<token> tokens;
+  tokens.reserve(records.size());
+  for(size_t i = 0; i < records.size(); i++) {
+    const auto &rec = records[i];
+    token t;
+    t.pos = location{file, offsets[i]};
+    t.kind = static_cast<token_kind>(rec.kind);
+    t.sub = rec.sub;
+    t.payload = rec.payload;
+    if(uses_string(t.kind)) {
+      const auto str = kept.substr(table[rec.payload].offset, table[rec.payload].length);
+      t.payload = t.kind == token_kind::IDENTIFIER ? jaydk::interned{str}.id() : payloads.add_string(str);
+    }
+    else if(uses_wide(t.kind, t.sub)) {
+      t.payload = payloads.add_wide(wides[rec.payload]);
+    }
+    tokens.push_back(t);
+  }
+
+  const location end{file, static_cast<uint32_t>(source->size())};
+  return cached_lexer{std::move(tokens), end};
+}
+
+std::optional<token_stream<cached_lexer>> jayc::lexer::lex_cached(const std::string &path, const std::string &source_file) {
+  auto loaded = cached_lexer::load(path, source_file);
+  if(!loaded.has_value()) return std::nullopt;
+  return token_stream{std::move(*loaded)};
+}
@@ -0,0 +1,53 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef TOKEN_CACHE_HPP
+#define TOKEN_CACHE_HPP
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "token_stream.hpp"
+
+namespace jayc::lexer {
+// binary token cache (native byte order), versioned and keyed by a hash of the source it was lexed from:
+//   header | token array (kind, sub, payload) | location table (offsets) | wide literals | string table | string pool
+// identifiers and string literals are stored by spelling (interned IDs are per-process)
+constexpr uint32_t token_cache_version = 1;
+
+uint64_t source_hash(std::string_view source);
+
+// writes the (eof-terminated) token buffer of file to path; false if the file cannot be written
+bool write_token_cache(const std::string &path, file_id file, const std::vector<token> &tokens);
+
+// token source replaying a token cache, so cached files go through token_stream/parser without being lexed
+class cached_lexer {
+public:
+  // nullopt if there is no (valid) cache at path for the current contents of source_file
+  static std::optional<cached_lexer> load(const std::string &path, const std::string &source_file);
+
+  token operator()() {
+    if(idx >= tokens.size()) return token{jayc::lexer::eof{}, pos()};
+    return tokens[idx++];
+  }
+
+  [[nodiscard]] constexpr bool eof() const { return idx >= tokens.size(); }
+  [[nodiscard]] constexpr location pos() const {
+    return idx < tokens.size() ? tokens[idx].pos : end;
+  }
+
+private:
+  cached_lexer(std::vector<token> tokens, const location end) : tokens{std::move(tokens)}, end{end} {}
+
+  std::vector<token> tokens;
+  location end;
+  size_t idx = 0;
+};
+
+std::optional<token_stream<cached_lexer>> lex_cached(const std::string &path, const std::string &source_file);
+}
+
+#endif //TOKEN_CACHE_HPP
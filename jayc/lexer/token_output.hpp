@@ -74,6 +74,7 @@ template <> struct _internal_type_name<float> { constexpr static auto value = "f
 template <> struct _internal_type_name<double> { constexpr static auto value = "float(64)"; };
 template <> struct _internal_type_name<char> { constexpr static auto value = "char(8)"; };
 template <> struct _internal_type_name<std::string> { constexpr static auto value = "string"; };
+template <> struct _internal_type_name<std::string_view> { constexpr static auto value = "string"; };
 template <> struct _internal_type_name<bool> { constexpr static auto value = "bool(1)"; };
 }
 
@@ -84,7 +85,7 @@ inline std::ostream &operator<<(std::ostream &target, const literal<T> &lit) {
 
 inline std::ostream &operator<<(std::ostream &target, const token &tok) {
   target << tok.pos << ": ";
-  std::visit([&target](const auto &x) { target << x; }, tok.actual);
+  std::visit([&target](const auto &x) { target << x; }, tok.value());
   return target;
 }
 
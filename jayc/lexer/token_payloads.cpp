@@ -0,0 +1,23 @@
+//
+// Created by jay on 9/18/24.
+//
+
+#include "token_payloads.hpp"
+
+using namespace jayc::lexer;
+
+token_payloads::token_payloads(const bool deduplicate) : deduplicate{deduplicate} {}
+
+uint32_t token_payloads::add_wide(const uint64_t bits) {
+  if(!deduplicate) return wides.push_back(bits);
+  std::lock_guard guard{dedup_lock};
+  if(const auto it = wide_ids.find(bits); it != wide_ids.end()) return it->second;
+  return wide_ids[bits] = wides.push_back(bits);
+}
+
+uint32_t token_payloads::add_string(const std::string_view str) {
+  if(!deduplicate) return strings.push_back(str);
+  std::lock_guard guard{dedup_lock};
+  if(const auto it = string_ids.find(str); it != string_ids.end()) return it->second;
+  return string_ids[str] = strings.push_back(str);
+}
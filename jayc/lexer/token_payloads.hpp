@@ -0,0 +1,41 @@
+//
+// Created by jay on 9/18/24.
+//
+
+#ifndef TOKEN_PAYLOADS_HPP
+#define TOKEN_PAYLOADS_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "util/append_only.hpp"
+
+namespace jayc::lexer {
+// per-file side tables for token payloads that don't fit in a token's 32 bits (64-bit literals, string literals)
+// append-only; the lexer writes while the parser may already be reading earlier entries, and reads never lock
+// a deduplicating table stores each distinct payload once; it backs tokens that don't belong to a lexed file (file 0),
+// which are built from constants and would otherwise grow the table for the lifetime of the process
+class token_payloads {
+public:
+  explicit token_payloads(bool deduplicate = false);
+
+  uint32_t add_wide(uint64_t bits);
+  [[nodiscard]] uint64_t wide(const uint32_t idx) const { return wides[idx]; }
+
+  // the view must outlive the table (views into the source buffer or source_buffer::store are fine)
+  uint32_t add_string(std::string_view str);
+  [[nodiscard]] std::string_view string(const uint32_t idx) const { return strings[idx]; }
+
+private:
+  bool deduplicate;
+  std::mutex dedup_lock;
+  std::unordered_map<uint64_t, uint32_t> wide_ids;
+  std::unordered_map<std::string_view, uint32_t> string_ids;
+  jaydk::append_only<uint64_t> wides;
+  jaydk::append_only<std::string_view> strings;
+};
+}
+
+#endif //TOKEN_PAYLOADS_HPP
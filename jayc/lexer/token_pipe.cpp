@@ -0,0 +1,51 @@
+//
+// Created by jay on 9/19/24.
+//
+
+#include "token_pipe.hpp"
+
+using namespace jayc::lexer;
+
+token_pipe::token_pipe(token_stream<lexer> &&stream)
+    : stream{std::move(stream)}, worker{[this](const std::stop_token &stop) { produce(stop); }} {}
+
+void token_pipe::produce(const std::stop_token &stop) {
+  try {
+    bool done = false;
+    while(!done && !stop.stop_requested()) {
+      std::vector<token> chunk;
+      chunk.reserve(chunk_size);
+      stream.fill(chunk, chunk_size);
+      done = !chunk.empty() && is<eof>(chunk.back());
+
+      while(!ring.try_push(chunk)) {
+        if(stop.stop_requested()) return;
+        std::this_thread::yield();
+      }
+    }
+  }
+  catch(...) {
+    failure = std::current_exception();
+  }
+  finished.store(true, std::memory_order_release);
+}
+
+bool token_pipe::next(std::vector<token> &out) {
+  if(delivered) return false;
+
+  std::vector<token> chunk;
+  while(!ring.try_pop(chunk)) {
+    if(finished.load(std::memory_order_acquire)) {
+      // the producer may have pushed its last chunk right before finishing
+      if(ring.try_pop(chunk)) break;
+      delivered = true;
+      if(failure != nullptr) std::rethrow_exception(failure);
+      return false;
+    }
+    std::this_thread::yield();
+  }
+
+  if(!chunk.empty() && is<eof>(chunk.back())) delivered = true;
+  out.insert(out.end(), chunk.begin(), chunk.end());
+  return true;
+}
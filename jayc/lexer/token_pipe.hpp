@@ -0,0 +1,46 @@
+//
+// Created by jay on 9/19/24.
+//
+
+#ifndef TOKEN_PIPE_HPP
+#define TOKEN_PIPE_HPP
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "util/spsc_ring.hpp"
+#include "lexer.hpp"
+
+namespace jayc::lexer {
+// runs the lexer on its own thread, publishing chunks of tokens through a lock-free SPSC ring
+// the consumer (token_it) overlaps parsing with lexing; errors thrown by the lexer are rethrown by next()
+class token_pipe {
+public:
+  constexpr static size_t chunk_size = 4096;
+  constexpr static size_t chunks_in_flight = 16;
+
+  explicit token_pipe(token_stream<lexer> &&stream);
+  token_pipe(const token_pipe &) = delete;
+  token_pipe(token_pipe &&) = delete;
+  token_pipe &operator=(const token_pipe &) = delete;
+  token_pipe &operator=(token_pipe &&) = delete;
+
+  // appends the next chunk to out (blocking until one is ready); false once the final (eof) chunk was delivered
+  bool next(std::vector<token> &out);
+
+  ~token_pipe() = default; // the worker is asked to stop and joined
+private:
+  void produce(const std::stop_token &stop);
+
+  token_stream<lexer> stream;
+  jaydk::spsc_ring<std::vector<token>, chunks_in_flight> ring;
+  std::atomic<bool> finished = false;
+  std::exception_ptr failure = nullptr;
+  bool delivered = false;
+  std::jthread worker; // last: starts after everything above is initialized, stops before it is destroyed
+};
+}
+
+#endif //TOKEN_PIPE_HPP
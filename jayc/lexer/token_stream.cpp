@@ -2,6 +2,85 @@
 // Created by jay on 9/2/24.
 //
 
+#include <limits>
+
 #include "token_stream.hpp"
+#include "token_payloads.hpp"
+#include "source_manager.hpp"
 
 using namespace jayc;
+using namespace jayc::lexer;
+
+namespace {
+token make(const token_kind kind, const location &pos, const uint8_t sub, const uint32_t payload) {
+  token res;
+  res.pos = pos;
+  res.kind = kind;
+  res.sub = sub;
+  res.payload = payload;
+  return res;
+}
+
+token_payloads &table_for(token_payloads *payloads, const location &pos) {
+  return payloads != nullptr ? *payloads : sources.payloads(pos.file);
+}
+}
+
+token::token(const token_t &value, const location pos) : token{encode(value, pos)} {}
+
+token_t token::value() const {
+  switch(kind) {
+    case token_kind::EOF_TOKEN: return eof{};
+    case token_kind::INVALID_IGNORED: return invalid_ignored{};
+    case token_kind::SYMBOL: return as<symbol>(*this);
+    case token_kind::KEYWORD: return as<keyword>(*this);
+    case token_kind::IDENTIFIER: return as<identifier>(*this);
+    case token_kind::INT64: return as<literal<int64_t>>(*this);
+    case token_kind::UINT64: return as<literal<uint64_t>>(*this);
+    case token_kind::FLOAT32: return as<literal<float>>(*this);
+    case token_kind::FLOAT64: return as<literal<double>>(*this);
+    case token_kind::CHAR: return as<literal<char>>(*this);
+    case token_kind::STRING: return as<literal<std::string_view>>(*this);
+    case token_kind::BOOL: return as<literal<bool>>(*this);
+  }
+  return invalid_ignored{};
+}
+
+token jayc::lexer::encode(const token_t &value, const location &pos, token_payloads *payloads) {
+  return std::visit([&pos, payloads]<typename T>(const T &v) -> token {
+    constexpr auto kind = token_kind_of<T>::value;
+    if constexpr(std::same_as<T, symbol> || std::same_as<T, keyword>) {
+      return make(kind, pos, static_cast<uint8_t>(v), 0);
+    }
+    else if constexpr(std::same_as<T, identifier>) return make(kind, pos, 0, v.ident.id());
+    else if constexpr(std::same_as<T, literal<int64_t>>) {
+      // small values are stored inline (sign-extended on decode)
+      if(v.value >= std::numeric_limits<int32_t>::min() && v.value <= std::numeric_limits<int32_t>::max()) {
+        return make(kind, pos, 0, std::bit_cast<uint32_t>(static_cast<int32_t>(v.value)));
+      }
+      return make(kind, pos, 1, table_for(payloads, pos).add_wide(std::bit_cast<uint64_t>(v.value)));
+    }
+    else if constexpr(std::same_as<T, literal<uint64_t>>) {
+      if(v.value <= std::numeric_limits<uint32_t>::max()) return make(kind, pos, 0, static_cast<uint32_t>(v.value));
+      return make(kind, pos, 1, table_for(payloads, pos).add_wide(v.value));
+    }
+    else if constexpr(std::same_as<T, literal<float>>) return make(kind, pos, 0, std::bit_cast<uint32_t>(v.value));
+    else if constexpr(std::same_as<T, literal<double>>) {
+      return make(kind, pos, 1, table_for(payloads, pos).add_wide(std::bit_cast<uint64_t>(v.value)));
+    }
+    else if constexpr(std::same_as<T, literal<char>>) return make(kind, pos, 0, static_cast<uint8_t>(v.value));
+    else if constexpr(std::same_as<T, literal<std::string_view>>) {
+      return make(kind, pos, 0, table_for(payloads, pos).add_string(v.value));
+    }
+    else if constexpr(std::same_as<T, literal<bool>>) return make(kind, pos, 0, v.value ? 1 : 0);
+    else return make(kind, pos, 0, 0);
+  }, value);
+}
+
+uint64_t internal_::wide_payload(const token &t) {
+  return sources.payloads(t.pos.file).wide(t.payload);
+}
+
+std::string_view internal_::string_payload(const token &t) {
+  return sources.payloads(t.pos.file).string(t.payload);
+}
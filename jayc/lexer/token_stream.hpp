@@ -5,11 +5,19 @@
 #ifndef TOKEN_STREAM_HPP
 #define TOKEN_STREAM_HPP
 
+#include <bit>
+#include <concepts>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <variant>
 #include <cstdint>
+#include <limits>
+#include <vector>
 
 #include "error_queue.hpp"
+#include "trace.hpp"
+#include "util/interner.hpp"
 
 namespace jayc::lexer {
 struct eof {
@@ -36,7 +44,7 @@ enum class keyword {
   FUN, VAR, IF, ELSE, FOR, WHILE, DO, RETURN, BREAK, CONTINUE, NAMESPACE, STRUCT, AUTO, VAL
 };
 struct identifier {
-  std::string ident;
+  jaydk::interned ident;
   constexpr bool operator==(const identifier &other) const { return ident == other.ident; }
 };
 template <typename T> struct literal {
@@ -47,14 +55,75 @@ template <typename T> struct literal {
 using token_t = std::variant<
   eof, invalid_ignored, symbol, keyword, identifier, literal<int64_t>,
   literal<uint64_t>, literal<float>, literal<double>, literal<char>,
-  literal<std::string>, literal<bool>
+  literal<std::string_view>, literal<bool>
 >;
 
+// token_t is the decoded form of a token; the lexer and parser pass the compact form below
+enum struct token_kind : uint8_t {
+  EOF_TOKEN, INVALID_IGNORED, SYMBOL, KEYWORD, IDENTIFIER, INT64, UINT64, FLOAT32, FLOAT64, CHAR, STRING, BOOL
+};
+
+template <typename T> struct token_kind_of;
+template <> struct token_kind_of<eof> { constexpr static auto value = token_kind::EOF_TOKEN; };
+template <> struct token_kind_of<invalid_ignored> { constexpr static auto value = token_kind::INVALID_IGNORED; };
+template <> struct token_kind_of<symbol> { constexpr static auto value = token_kind::SYMBOL; };
+template <> struct token_kind_of<keyword> { constexpr static auto value = token_kind::KEYWORD; };
+template <> struct token_kind_of<identifier> { constexpr static auto value = token_kind::IDENTIFIER; };
+template <> struct token_kind_of<literal<int64_t>> { constexpr static auto value = token_kind::INT64; };
+template <> struct token_kind_of<literal<uint64_t>> { constexpr static auto value = token_kind::UINT64; };
+template <> struct token_kind_of<literal<float>> { constexpr static auto value = token_kind::FLOAT32; };
+template <> struct token_kind_of<literal<double>> { constexpr static auto value = token_kind::FLOAT64; };
+template <> struct token_kind_of<literal<char>> { constexpr static auto value = token_kind::CHAR; };
+template <> struct token_kind_of<literal<std::string_view>> { constexpr static auto value = token_kind::STRING; };
+template <> struct token_kind_of<literal<bool>> { constexpr static auto value = token_kind::BOOL; };
+
+class token_payloads;
+
+// 16 bytes, trivially copyable; payloads that don't fit live in the per-file token_payloads table
 struct token {
-  token_t actual;
-  location pos;
+  constexpr token() = default;
+  // ReSharper disable once CppNonExplicitConvertingConstructor
+  token(const token_t &value, location pos = {}); // NOLINT(*-explicit-constructor)
+
+  location pos{};
+  token_kind kind = token_kind::EOF_TOKEN;
+  uint8_t sub = 0; //!< Symbol or keyword; for 64-bit literals: whether payload indexes the side table
+  uint32_t payload = 0; //!< Interned ID, string table index, inline literal bits or side table index
+
+  [[nodiscard]] token_t value() const;
 };
 
+static_assert(sizeof(token) == 16);
+static_assert(std::is_trivially_copyable_v<token>);
+
+// payloads == nullptr -> use the side table of the file the token belongs to
+token encode(const token_t &value, const location &pos, token_payloads *payloads = nullptr);
+
+template <typename T>
+constexpr bool is(const token &t) { return t.kind == token_kind_of<T>::value; }
+
+namespace internal_ {
+uint64_t wide_payload(const token &t);
+std::string_view string_payload(const token &t);
+}
+
+template <typename T>
+constexpr T as(const token &t) {
+  if constexpr(std::same_as<T, symbol>) return static_cast<symbol>(t.sub);
+  else if constexpr(std::same_as<T, keyword>) return static_cast<keyword>(t.sub);
+  else if constexpr(std::same_as<T, identifier>) return identifier{ jaydk::interned::from_id(t.payload) };
+  else if constexpr(std::same_as<T, literal<int64_t>>) {
+    return { t.sub ? std::bit_cast<int64_t>(internal_::wide_payload(t)) : std::bit_cast<int32_t>(t.payload) };
+  }
+  else if constexpr(std::same_as<T, literal<uint64_t>>) return { t.sub ? internal_::wide_payload(t) : t.payload };
+  else if constexpr(std::same_as<T, literal<float>>) return { std::bit_cast<float>(t.payload) };
+  else if constexpr(std::same_as<T, literal<double>>) return { std::bit_cast<double>(internal_::wide_payload(t)) };
+  else if constexpr(std::same_as<T, literal<char>>) return { static_cast<char>(t.payload) };
+  else if constexpr(std::same_as<T, literal<std::string_view>>) return { internal_::string_payload(t) };
+  else if constexpr(std::same_as<T, literal<bool>>) return { t.payload != 0 };
+  else return T{};
+}
+
 template <typename YS>
 concept token_source = requires(YS &s, const YS &ss) {
   { s() } -> std::convertible_to<token>;
@@ -75,18 +144,44 @@ public:
 
   inline token_stream &operator>>(token &t) {
     if(source.eof()) {
-      t.actual = eof{};
-      t.pos = source.pos();
+      t = token{eof{}, source.pos()};
     }
     else {
       do {
         t = source();
-      } while(jaydk::is<invalid_ignored>(t.actual));
+      } while(is<invalid_ignored>(t));
       return *this;
     }
     return *this;
   }
 
+  // lexes up to max tokens (skipping ignored ones) into out in one tight loop; the final token is eof
+  inline size_t fill(std::vector<token> &out, const size_t max = std::numeric_limits<size_t>::max()) {
+    const location start = source.pos();
+    size_t count = 0;
+    while(count < max) {
+      if(source.eof()) {
+        out.push_back(token{eof{}, source.pos()});
+        ++count;
+        break;
+      }
+
+      const token t = source();
+      if(is<invalid_ignored>(t)) continue;
+      out.push_back(t);
+      ++count;
+      if(is<eof>(t)) break;
+    }
+    trace(trace_category::LEXER, trace_event::TOKENS_LEXED, start, static_cast<uint32_t>(count));
+    return count;
+  }
+
+  inline std::vector<token> drain() {
+    std::vector<token> res;
+    fill(res);
+    return res;
+  }
+
   ~token_stream() = default;
 private:
   YS source;
@@ -3,18 +3,23 @@
 //
 
 #include <cstdint>
+#include <fstream>
 #include <iostream>
 #include <argparse/argparse.hpp>
 #include <termcolor/termcolor.hpp>
 
 #include "args.hpp"
 #include "error.hpp"
+#include "trace.hpp"
 
 #include "lexer/lexer.hpp"
+#include "lexer/token_cache.hpp"
 #include "lexer/token_output.hpp"
 
 #include "parser/parser.hpp"
 #include "parser/ast_output.hpp"
+#include "parser/ast_cache.hpp"
+#include "parser/flat_ast.hpp"
 
 #include "semantic_checker/semantic_checker.hpp"
 
@@ -22,18 +27,64 @@ void if_set(std::optional<std::string> &out, const std::string &name, const argp
   if(parser.present(name)) out = parser.get<std::string>(name);
 }
 
+jayc::parser::ast parse_input(const jayc::args &args) {
+  using namespace jayc;
+
+  if(!args.lexer_out.has_value()) {
+    auto parser = parser::parser(lexer::lex(args.input));
+    if(args.parallel_parser) return parser.parse_parallel();
+    return args.pipelined_lexer ? parser.parse_pipelined() : parser.parse();
+  }
+
+  if(!args.lexer_out_text) {
+    if(auto cached = lexer::lex_cached(*args.lexer_out, args.input); cached.has_value()) {
+      auto parser = parser::parser(std::move(*cached));
+      return args.parallel_parser ? parser.parse_parallel() : parser.parse();
+    }
+  }
+
+  auto tokens = lexer::lex(args.input).drain();
+  if(args.lexer_out_text) {
+    std::ofstream out(*args.lexer_out);
+    for(const auto &t : tokens) out << t << "\n";
+  }
+  else if(logger.phase_error() == 0 && !tokens.empty() &&
+          !lexer::write_token_cache(*args.lexer_out, tokens.back().pos.file, tokens)) {
+    logger << warning{ location{}, "Failed to write token cache `" + *args.lexer_out + "`." };
+  }
+
+  if(args.parallel_parser) return parser::build_ast_parallel(std::move(tokens));
+  auto it = parser::token_it(std::move(tokens));
+  return parser::build_ast(it);
+}
+
+void dump_trace(const jayc::args &args) {
+  if(!args.trace.has_value()) return;
+  if(args.trace_out.has_value()) {
+    std::ofstream out(*args.trace_out);
+    jayc::traces.dump(out);
+  }
+  else jayc::traces.dump(std::cerr);
+}
+
 int main(const int argc, const char **argv) {
   argparse::ArgumentParser arg_parser("jayc");
   jayc::args args{};
 
   arg_parser.add_argument("input").help("Set the input file for compiling.");
   arg_parser.add_argument("-o", "--output").help("Set the output file.");
-  arg_parser.add_argument("--lexer-out").help("Set the output file for the lexer token stream.");
-  arg_parser.add_argument("--parser-out").help("Set the output file for the unchecked AST.");
+  arg_parser.add_argument("--lexer-out").help("Set the output file for the lexer token stream (binary token cache).");
+  arg_parser.add_argument("--lexer-text").flag().help("Write the lexer token stream as human-readable text.");
+  arg_parser.add_argument("--parser-out").help("Set the output file for the unchecked AST (binary; if up-to-date, lexing and parsing are skipped entirely).");
+  arg_parser.add_argument("--parser-text").flag().help("Write the unchecked AST as human-readable text (to stdout without --parser-out).");
   arg_parser.add_argument("--typecheck-out").help("Set the output file for type-checked AST.");
   arg_parser.add_argument("--codegen-out").help("Set the output file for raw IR.");
   arg_parser.add_argument("--link-out").help("Set the output file for post-link output.");
   arg_parser.add_argument("--bytecode-out").help("Set the output file for human-readable bytecode.");
+  arg_parser.add_argument("--pipelined-lexer").flag().help("Lex on a separate thread while parsing.");
+  arg_parser.add_argument("--parallel-parse").flag().help("Parse top-level declarations on several threads.");
+  arg_parser.add_argument("--trace").help("Record trace events for the given categories (lexer, parser, sema, all).");
+  arg_parser.add_argument("--trace-out").help("Set the output file for recorded trace events.");
   arg_parser.add_argument("--no-parse").flag().help("Disable parsing (and later stages).");
   arg_parser.add_argument("--no-typecheck").flag().help("Disable type-checking (and later stages).");
   arg_parser.add_argument("--no-codegen").flag().help("Disable code-generation (and later stages).");
@@ -57,7 +108,13 @@ int main(const int argc, const char **argv) {
     if_set(args.codegen_out, "--codegen-out", arg_parser);
     if_set(args.linker_out, "--link-out", arg_parser);
     if_set(args.bytecode_out, "--bytecode-out", arg_parser);
+    if_set(args.trace, "--trace", arg_parser);
+    if_set(args.trace_out, "--trace-out", arg_parser);
 
+    args.lexer_out_text = arg_parser["--lexer-text"] == true;
+    args.parser_out_text = arg_parser["--parser-text"] == true;
+    args.pipelined_lexer = arg_parser["--pipelined-lexer"] == true;
+    args.parallel_parser = arg_parser["--parallel-parse"] == true;
     args.perform_parser = arg_parser["--no-parse"] != true;
     args.perform_type_check = arg_parser["--no-typecheck"] != true;
     args.perform_codegen = arg_parser["--no-codegen"] != true;
@@ -66,6 +123,13 @@ int main(const int argc, const char **argv) {
 
     args.link_targets = arg_parser.get<std::vector<std::string>>("--lib");
     args.link_sources = arg_parser.get<std::vector<std::string>>("--lib-path");
+
+    if(args.trace.has_value()) {
+      if(!jayc::trace_compiled) throw std::runtime_error("--trace: this build of jayc has tracing compiled out");
+      const auto categories = jayc::tracer::parse_categories(*args.trace);
+      if(!categories.has_value()) throw std::runtime_error("--trace: unknown category in `" + *args.trace + "`");
+      jayc::traces.enable_mask(*categories);
+    }
   }
   catch(const std::exception &e) {
     std::cerr << e.what() << "\n" << arg_parser << "\n";
@@ -73,16 +137,33 @@ int main(const int argc, const char **argv) {
   }
 
   try {
-    auto strm = jayc::lexer::lex(args.input);
-    auto parser = jayc::parser::parser(std::move(strm));
-    auto ast = parser.parse();
-    std::cout << ast;
+    const bool binary_ast = args.parser_out.has_value() && !args.parser_out_text;
+    // an up-to-date AST skips lexing and parsing entirely, unless their token cache or trace events are wanted
+    const bool reuse_ast = binary_ast && !args.lexer_out.has_value() && !args.trace.has_value();
+    if(reuse_ast && jayc::parser::flat::mapped_ast::load(*args.parser_out, args.input).has_value()) {
+      dump_trace(args);
+      return 0;
+    }
+
+    auto ast = parse_input(args);
+    if(args.parser_out_text && args.parser_out.has_value()) {
+      std::ofstream out(*args.parser_out);
+      out << ast;
+    }
+    else if(args.parser_out_text) std::cout << ast;
+    // not after warnings either: reusing the AST would silently drop them
+    else if(binary_ast && jayc::logger.phase_error() == 0 && jayc::logger.phase_warning() == 0 &&
+            !jayc::parser::flat::write_ast_cache(*args.parser_out, args.input, jayc::parser::flat::flatten(ast))) {
+      jayc::logger << jayc::warning{ jayc::location{}, "Failed to write AST `" + *args.parser_out + "`." };
+    }
+    dump_trace(args);
     if(jayc::logger.phase_error() != 0) {
       return -1;
     }
 
   }
   catch(jayc::unrecoverable &) {
+    dump_trace(args);
     return -1;
   }
 
@@ -5,14 +5,20 @@
 #ifndef AST_HPP
 #define AST_HPP
 
-#include <string>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
 #include <utility>
-#include <vector>
 #include <optional>
+#include <vector>
 
 #include "error_queue.hpp"
+#include "lexer/token_stream.hpp"
 #include "util/optional_helpers.hpp"
-#include "util/managed.hpp"
+#include "util/interner.hpp"
+#include "util/arena.hpp"
 #include "util/variant_helpers.hpp"
 
 namespace jayc::parser {
@@ -21,6 +27,13 @@ struct node {
   location pos;
 };
 
+// a node's structure (kinds, names by spelling, literals, children), ignoring locations; see ast_hash.hpp
+struct structural_hash {
+  uint64_t low = 0;
+  uint64_t high = 0;
+  constexpr bool operator==(const structural_hash &) const = default;
+};
+
 enum struct unary_op {
   UN_PLUS, UN_MINUS, PRE_INCR, POST_INCR, PRE_DECR, POST_DECR, BOOL_NEG, BIT_NEG
 };
@@ -34,9 +47,9 @@ enum struct binary_op {
 
 struct name {
   // name: <identifier>(< <name>(, <name>)* >)? ([])? (::<name>)?
-  std::string section;
-  std::vector<name> template_args;
-  jaydk::heap_opt<name> next;
+  jaydk::interned section;
+  jaydk::arena_vector<name> template_args;
+  jaydk::arena_opt<name> next;
   bool is_array;
 };
 
@@ -53,47 +66,50 @@ struct name_expr {
 
 struct unary_expr {
   unary_op op;
-  jaydk::managed<expression> expr;
+  jaydk::arena_ptr<expression> expr;
 };
 
 struct binary_expr {
   binary_op op;
-  jaydk::managed<expression> left;
-  jaydk::managed<expression> right;
+  jaydk::arena_ptr<expression> left;
+  jaydk::arena_ptr<expression> right;
 };
 
 struct ternary_expr {
-  jaydk::managed<expression> cond;
-  jaydk::managed<expression> true_expr;
-  jaydk::managed<expression> false_expr;
+  jaydk::arena_ptr<expression> cond;
+  jaydk::arena_ptr<expression> true_expr;
+  jaydk::arena_ptr<expression> false_expr;
 };
 
 struct call_expr {
-  jaydk::managed<expression> call;
-  std::vector<expression> args;
+  jaydk::arena_ptr<expression> call;
+  jaydk::arena_vector<expression> args;
 };
 
 struct index_expr {
-  jaydk::managed<expression> base;
-  jaydk::managed<expression> index;
+  jaydk::arena_ptr<expression> base;
+  jaydk::arena_ptr<expression> index;
 };
 
 struct member_expr {
-  jaydk::managed<expression> base;
-  std::string member;
+  jaydk::arena_ptr<expression> base;
+  jaydk::interned member;
 };
 
 struct expression : node {
   using actual_t = std::variant<
     literal_expr<int64_t>, literal_expr<uint64_t>, literal_expr<float>, literal_expr<double>,
-    literal_expr<char>, literal_expr<std::string>, literal_expr<bool>, name_expr,
+    literal_expr<char>, literal_expr<std::string_view>, literal_expr<bool>, name_expr,
     unary_expr, binary_expr, ternary_expr, call_expr, index_expr, member_expr
   >;
 
-  template <typename T> requires(jaydk::is_alternative_for<T, actual_t>)
-  expression(const T &t, const location &pos) : node{pos}, content{t} {}
+  template <typename T> requires(jaydk::is_alternative_for<std::remove_cvref_t<T>, actual_t>)
+  expression(T &&t, const location &pos) : node{pos}, content{std::forward<T>(t)}, hash{hash_content(content)} {}
 
   actual_t content;
+  structural_hash hash; //!< Computed from the children's hashes on construction
+
+  static structural_hash hash_content(const actual_t &content);
 };
 }
 using namespace expressions_;
@@ -101,7 +117,7 @@ using namespace expressions_;
 namespace statements_ {
 struct statement;
 struct block {
-  std::vector<statement> statements;
+  jaydk::arena_vector<statement> statements;
 };
 
 struct expr_stmt {
@@ -109,34 +125,34 @@ struct expr_stmt {
 };
 
 struct var_decl_stmt {
-  std::string var_name;
+  jaydk::interned var_name;
   std::optional<name> type_name;
   expression value;
   bool is_mutable;
 };
 struct if_stmt {
   expression condition;
-  jaydk::managed<statement> true_block;
-  std::optional<jaydk::managed<statement>> false_block;
+  jaydk::arena_ptr<statement> true_block;
+  std::optional<jaydk::arena_ptr<statement>> false_block;
 };
 
 struct for_stmt {
-  jaydk::managed<statement> init;
+  jaydk::arena_ptr<statement> init;
   expression condition;
   expression update;
-  jaydk::managed<statement> block;
+  jaydk::arena_ptr<statement> block;
 };
 
 struct for_each_stmt {
-  std::string binding;
+  jaydk::interned binding;
   expression collection;
-  jaydk::managed<statement> block;
+  jaydk::arena_ptr<statement> block;
 };
 
 struct while_stmt {
   bool is_do_while = false;
   expression condition;
-  jaydk::managed<statement> block;
+  jaydk::arena_ptr<statement> block;
 };
 
 struct break_stmt {};
@@ -152,10 +168,13 @@ struct statement : node {
     while_stmt, break_stmt, continue_stmt, return_stmt
   >;
 
-  template <typename T> requires(jaydk::is_alternative_for<T, actual_t>)
-  statement(const T &t, const location &pos) : node{pos}, content{t} {}
+  template <typename T> requires(jaydk::is_alternative_for<std::remove_cvref_t<T>, actual_t>)
+  statement(T &&t, const location &pos) : node{pos}, content{std::forward<T>(t)}, hash{hash_content(content)} {}
 
   actual_t content;
+  structural_hash hash; //!< Computed from the children's hashes on construction
+
+  static structural_hash hash_content(const actual_t &content);
 };
 }
 using namespace statements_;
@@ -164,56 +183,100 @@ namespace declarations_ {
 struct declaration;
 
 struct namespace_decl {
-  std::string name;
-  std::vector<declaration> declarations;
+  jaydk::interned name;
+  jaydk::arena_vector<declaration> declarations;
+};
+
+// the statements of a function; with lazy bodies (see token_it::defer_bodies), the parser only keeps the body's tokens,
+// and its statements are parsed (into the module's arena) the first time they're asked for
+// a body is materialised at most once; bodies of the same module may be materialised from several threads, which then
+// take turns on the module's arena (see arena::writers), but not while the module itself is still being parsed
+class function_body {
+public:
+  struct deferred {
+    std::span<const lexer::token> tokens; //!< Between the braces, followed by an eof token at the closing brace
+    jaydk::arena *nodes; //!< The module's arena
+    std::atomic<bool> materialised{false};
+    bool failed = false; //!< Whether a statement failed to parse (the errors are logged when materialising)
+    jaydk::arena_vector<statement> statements{};
+  };
+
+  function_body() = default;
+  explicit function_body(jaydk::arena_vector<statement> statements) : eager{std::move(statements)} {}
+  explicit function_body(deferred *lazy) : lazy{lazy} {}
+
+  // parses the body first if it's still deferred (defined with the parser)
+  // a deferred body that fails to parse has no statements (like the declaration an eager parse would have rejected)
+  [[nodiscard]] const jaydk::arena_vector<statement> &statements() const;
+  [[nodiscard]] inline bool is_materialised() const { return lazy == nullptr || lazy->materialised.load(); }
+  // materialises the body; whether it failed to parse
+  [[nodiscard]] bool failed() const;
+
+  [[nodiscard]] inline auto begin() const { return statements().begin(); }
+  [[nodiscard]] inline auto end() const { return statements().end(); }
+  [[nodiscard]] inline size_t size() const { return statements().size(); }
+  [[nodiscard]] inline bool empty() const { return statements().empty(); }
+
+  // a deferred body hashes its tokens instead of its statements (whether materialised or not), so only compare hashes
+  // of modules parsed the same way
+  [[nodiscard]] structural_hash hash() const;
+
+private:
+  jaydk::arena_vector<statement> eager;
+  deferred *lazy = nullptr;
 };
 
 struct function_decl {
   struct arg {
     name type;
-    std::string arg_name;
+    jaydk::interned arg_name;
     location pos;
   };
   struct no_return_type {};
   struct auto_type {};
   using return_type_t = std::variant<no_return_type, auto_type, name>;
 
-  std::string function_name;
-  std::vector<arg> args;
+  // not inline: the lists are already in the arena, and inline storage would grow every declaration (see the
+  // arg_lists benchmarks)
+  using args_t = jaydk::arena_vector<arg>;
+
+  jaydk::interned function_name;
+  args_t args;
   return_type_t return_type;
-  std::vector<statement> body;
+  function_body body;
 };
 
 struct template_function_decl {
   struct template_arg {
-    std::string arg_name;
-    std::vector<name> constraints;
+    jaydk::interned arg_name;
+    jaydk::arena_small_vector<name, 1> constraints; //!< Usually just one
   };
 
   function_decl base;
-  std::vector<template_arg> template_args;
+  jaydk::arena_vector<template_arg> template_args;
 };
 
 struct ext_function_decl {
   using arg = function_decl::arg;
   using return_type_t = function_decl::return_type_t;
+  using args_t = function_decl::args_t;
 
   name receiver;
-  std::string ext_func_name;
-  std::vector<arg> args;
+  jaydk::interned ext_func_name;
+  args_t args;
   return_type_t return_type;
-  std::vector<statement> body;
+  function_body body;
 };
 
 struct template_ext_function_decl {
   using template_arg = template_function_decl::template_arg;
 
   ext_function_decl base;
-  std::vector<template_arg> template_args;
+  jaydk::arena_vector<template_arg> template_args;
 };
 
 struct global_decl {
-  std::string glob_name;
+  jaydk::interned glob_name;
   std::optional<name> type;
   expression value;
   bool is_mutable;
@@ -222,20 +285,20 @@ struct global_decl {
 struct template_type_decl;
 
 struct type_decl {
-  std::string type_name;
-  std::vector<name> bases;
-  std::vector<std::pair<global_decl, location>> fields;
-  std::vector<std::pair<function_decl, location>> members;
-  std::vector<std::pair<template_function_decl, location>> template_members;
-  std::vector<std::pair<type_decl, location>> nested_types;
-  std::vector<std::pair<template_type_decl, location>> nested_template_types;
+  jaydk::interned type_name;
+  jaydk::arena_vector<name> bases;
+  jaydk::arena_vector<std::pair<global_decl, location>> fields;
+  jaydk::arena_vector<std::pair<function_decl, location>> members;
+  jaydk::arena_vector<std::pair<template_function_decl, location>> template_members;
+  jaydk::arena_vector<std::pair<type_decl, location>> nested_types;
+  jaydk::arena_vector<std::pair<template_type_decl, location>> nested_template_types;
 };
 
 struct template_type_decl {
   using template_arg = template_function_decl::template_arg;
 
   type_decl base;
-  std::vector<template_arg> template_args;
+  jaydk::arena_vector<template_arg> template_args;
 };
 
 struct declaration : node {
@@ -244,16 +307,26 @@ struct declaration : node {
     type_decl, template_type_decl, global_decl
   >;
 
-  template <typename T> requires(jaydk::is_alternative_for<T, actual_t>)
-  inline declaration(const T &t, const location &pos) : node{pos}, content{t} {}
+  template <typename T> requires(jaydk::is_alternative_for<std::remove_cvref_t<T>, actual_t>)
+  inline declaration(T &&t, const location &pos)
+    : node{pos}, content{std::forward<T>(t)}, hash{hash_content(content)} {}
 
   actual_t content;
+  structural_hash hash; //!< Computed from the children's hashes on construction
+
+  static structural_hash hash_content(const actual_t &content);
 };
 }
 using namespace declarations_;
 
-// using ast = std::vector<declaration>;
-using ast = namespace_decl;
+// the arena every node of a parsed module lives in; listed first, so it outlives the declarations
+struct ast_storage {
+  std::shared_ptr<jaydk::arena> nodes = std::make_shared<jaydk::arena>();
+  std::vector<std::shared_ptr<jaydk::arena>> shards{}; //!< Arenas of declarations parsed on other threads
+};
+
+// a parsed module; dropping the last copy releases all of its nodes at once
+struct ast : ast_storage, namespace_decl {};
 }
 
 #endif //AST_HPP
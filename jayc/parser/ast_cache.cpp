@@ -0,0 +1,346 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include "ast_cache.hpp"
+#include "lexer/token_cache.hpp"
+#include "source_manager.hpp"
+
+using namespace jaydk;
+using namespace jayc;
+using namespace jayc::parser::flat;
+using namespace jayc::parser::flat::internal_;
+
+namespace {
+constexpr char magic[4] = { 'J', 'A', 'S', 'T' };
+constexpr size_t section_align = 8;
+
+struct header {
+  char magic[4];
+  uint32_t version;
+  uint64_t source_hash;
+  uint32_t node_count;
+  uint32_t delta_bytes;
+  uint32_t literal_count;
+  uint32_t string_count;
+  uint32_t string_pool_size;
+  uint32_t name_count;
+  uint32_t name_arg_count;
+  uint32_t arg_count;
+  uint32_t template_arg_count;
+  uint32_t function_count;
+  uint32_t type_count;
+  uint32_t variable_count;
+  uint32_t symbol_count;
+  uint32_t symbol_pool_size;
+};
+
+static_assert(std::is_trivially_copyable_v<header> && sizeof(header) == 72);
+static_assert(sizeof(node_kind) == 1 && std::is_trivially_copyable_v<range> && sizeof(range) == 8);
+
+bool has_symbol_payload(const node_kind k) {
+  return k == node_kind::MEMBER || k == node_kind::FOR_EACH || k == node_kind::NAMESPACE;
+}
+
+// zigzag + LEB128, shifted by one so 0 can mean "unknown location"
+void put_delta(std::string &out, const int64_t delta) {
+  uint64_t v = ((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63)) + 1;
+  while(v >= 0x80) {
+    out += static_cast<char>((v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  out += static_cast<char>(v);
+}
+
+// nullopt on a truncated or overlong varint
+std::optional<uint64_t> get_varint(const uint8_t *&at, const uint8_t *end) {
+  uint64_t v = 0;
+  for(unsigned shift = 0; shift < 64 && at != end; shift += 7) {
+    const uint8_t byte = *at++;
+    v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if((byte & 0x80) == 0) return v;
+  }
+  return std::nullopt;
+}
+
+class writer {
+public:
+  template <typename T>
+  void section(const std::vector<T> &data) { section(data.data(), data.size() * sizeof(T)); }
+
+  void section(const void *data, const size_t size) {
+    out.append(static_cast<const char *>(data), size);
+    out.append((section_align - out.size() % section_align) % section_align, '\0');
+  }
+
+  std::string out;
+};
+
+// bounds- and alignment-checked sections of the mapped file
+class reader {
+public:
+  reader(const char *begin, const char *end) : at{begin}, end{end} {}
+
+  template <typename T>
+  bool read(std::span<const T> &out, const size_t count) {
+    if(reinterpret_cast<uintptr_t>(at) % alignof(T) != 0 || static_cast<size_t>(end - at) / sizeof(T) < count) {
+      return false;
+    }
+    out = std::span<const T>{ reinterpret_cast<const T *>(at), count };
+    return skip(count * sizeof(T));
+  }
+
+  bool read(std::string_view &out, const size_t count) {
+    if(static_cast<size_t>(end - at) < count) return false;
+    out = std::string_view{ at, count };
+    return skip(count);
+  }
+
+  [[nodiscard]] bool done() const { return at == end; }
+
+private:
+  bool skip(const size_t count) {
+    const size_t padded = count + (section_align - count % section_align) % section_align;
+    if(static_cast<size_t>(end - at) < padded) return false;
+    at += padded;
+    return true;
+  }
+
+  const char *at;
+  const char *end;
+};
+
+bool within(const range r, const size_t size) { return r.begin <= r.end && r.end <= size; }
+bool name_or(const uint32_t idx, const size_t names, const uint32_t sentinel) { return idx == sentinel || idx < names; }
+}
+
+bool jayc::parser::flat::write_ast_cache(
+  const std::string &path, const std::string &source_file, const flat_ast &tree
+) {
+  const auto source = lexer::source_buffer::map_file(source_file);
+  if(source == nullptr) return false;
+
+  std::vector<range> symbols;
+  std::string symbol_pool;
+  std::unordered_map<uint32_t, uint32_t> seen;
+  const auto symbol = [&](const interned &i) {
+    if(const auto it = seen.find(i.id()); it != seen.end()) return it->second;
+    const auto spelling = i.view();
+    const auto begin = static_cast<uint32_t>(symbol_pool.size());
+    symbol_pool += spelling;
+    symbols.push_back(range{ begin, static_cast<uint32_t>(symbol_pool.size()) });
+    return seen[i.id()] = static_cast<uint32_t>(symbols.size() - 1);
+  };
+  const auto offset = [](const location &loc) { return loc.file == 0 ? 0 : loc.offset + 1; };
+
+  std::vector<uint32_t> payloads = tree.payload;
+  std::string deltas;
+  uint32_t previous = 0;
+  for(size_t i = 0; i < tree.size(); i++) {
+    if(has_symbol_payload(tree.kind[i])) payloads[i] = symbol(interned::from_id(tree.payload[i]));
+    if(tree.pos[i].file == 0) deltas += '\0';
+    else {
+      put_delta(deltas, static_cast<int64_t>(tree.pos[i].offset) - previous);
+      previous = tree.pos[i].offset;
+    }
+  }
+
+  std::vector<cached_name> names;
+  for(const auto &n : tree.names) names.push_back({ symbol(n.section), n.template_args, n.next, n.is_array });
+  std::vector<cached_arg> args;
+  for(const auto &a : tree.args) args.push_back({ a.type, symbol(a.arg_name), offset(a.pos) });
+  std::vector<cached_template_arg> template_args;
+  for(const auto &t : tree.template_args) template_args.push_back({ symbol(t.arg_name), t.constraints });
+  std::vector<cached_function> functions;
+  for(const auto &f : tree.functions) {
+    functions.push_back({ symbol(f.function_name), f.receiver, f.args, f.template_args, f.return_type });
+  }
+  std::vector<cached_type> types;
+  for(const auto &t : tree.types) types.push_back({ symbol(t.type_name), t.bases, t.template_args });
+  std::vector<cached_variable> variables;
+  for(const auto &v : tree.variables) variables.push_back({ symbol(v.var_name), v.type, v.is_mutable });
+
+  const header head{
+    { magic[0], magic[1], magic[2], magic[3] }, ast_cache_version, lexer::source_hash(source->view()),
+    static_cast<uint32_t>(tree.size()), static_cast<uint32_t>(deltas.size()),
+    static_cast<uint32_t>(tree.literals.size()), static_cast<uint32_t>(tree.strings.size()),
+    static_cast<uint32_t>(tree.string_pool.size()), static_cast<uint32_t>(names.size()),
+    static_cast<uint32_t>(tree.name_args.size()), static_cast<uint32_t>(args.size()),
+    static_cast<uint32_t>(template_args.size()), static_cast<uint32_t>(functions.size()),
+    static_cast<uint32_t>(types.size()), static_cast<uint32_t>(variables.size()),
+    static_cast<uint32_t>(symbols.size()), static_cast<uint32_t>(symbol_pool.size())
+  };
+
+  writer w;
+  w.section(&head, sizeof(header));
+  w.section(tree.kind);
+  w.section(tree.subtree_end);
+  w.section(payloads);
+  w.section(deltas.data(), deltas.size());
+  w.section(tree.literals);
+  w.section(tree.strings);
+  w.section(tree.string_pool.data(), tree.string_pool.size());
+  w.section(names);
+  w.section(tree.name_args);
+  w.section(args);
+  w.section(template_args);
+  w.section(functions);
+  w.section(types);
+  w.section(variables);
+  w.section(symbols);
+  w.section(symbol_pool.data(), symbol_pool.size());
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if(!out) return false;
+  out.write(w.out.data(), static_cast<std::streamsize>(w.out.size()));
+  return static_cast<bool>(out);
+}
+
+std::optional<mapped_ast> mapped_ast::load(const std::string &path, const std::string &source_file) {
+  mapped_ast res;
+  res.file = lexer::source_buffer::map_file(path);
+  if(res.file == nullptr || res.file->size() < sizeof(header)) return std::nullopt;
+
+  header head{};
+  std::memcpy(&head, res.file->begin(), sizeof(header));
+  if(std::memcmp(head.magic, magic, sizeof(magic)) != 0 || head.version != ast_cache_version) return std::nullopt;
+
+  auto source = lexer::source_buffer::map_file(source_file);
+  if(source == nullptr || lexer::source_hash(source->view()) != head.source_hash) return std::nullopt;
+
+  reader in{ res.file->begin() + sizeof(header), res.file->end() };
+  std::span<const range> symbol_table;
+  std::string_view symbol_pool;
+  if(!in.read(res.kinds, head.node_count) || !in.read(res.ends, head.node_count) ||
+     !in.read(res.payloads, head.node_count) || !in.read(res.deltas, head.delta_bytes) ||
+     !in.read(res.literals, head.literal_count) || !in.read(res.strings, head.string_count) ||
+     !in.read(res.string_pool, head.string_pool_size) || !in.read(res.names, head.name_count) ||
+     !in.read(res.name_args, head.name_arg_count) || !in.read(res.args, head.arg_count) ||
+     !in.read(res.template_args, head.template_arg_count) || !in.read(res.functions, head.function_count) ||
+     !in.read(res.types, head.type_count) || !in.read(res.variables, head.variable_count) ||
+     !in.read(symbol_table, head.symbol_count) || !in.read(symbol_pool, head.symbol_pool_size) || !in.done()) {
+    return std::nullopt;
+  }
+
+  // validate every index up front, so accessors can trust the mapped data
+  const size_t n = res.size(), symbols = symbol_table.size(), names = res.names.size();
+  if(n == 0 || res.kinds[0] != node_kind::NAMESPACE || res.ends[0] != n) return std::nullopt;
+  for(size_t i = 0; i < n; i++) {
+    const auto k = res.kinds[i];
+    const auto p = res.payloads[i];
+    if(k > node_kind::GLOBAL || res.ends[i] <= i || res.ends[i] > n) return std::nullopt;
+
+    bool valid = true;
+    switch(k) {
+      case node_kind::STRING_LITERAL: valid = p < res.strings.size(); break;
+      case node_kind::NAME: valid = p < names; break;
+      case node_kind::VAR_DECL: case node_kind::GLOBAL: valid = p < res.variables.size(); break;
+      case node_kind::FUNCTION: case node_kind::TEMPLATE_FUNCTION:
+      case node_kind::EXT_FUNCTION: case node_kind::TEMPLATE_EXT_FUNCTION:
+        valid = p < res.functions.size(); break;
+      case node_kind::TYPE: case node_kind::TEMPLATE_TYPE: valid = p < res.types.size(); break;
+      default:
+        if(k < node_kind::STRING_LITERAL || k == node_kind::BOOL_LITERAL) valid = p < res.literals.size();
+        else if(has_symbol_payload(k)) valid = p < symbols;
+        break;
+    }
+    if(!valid) return std::nullopt;
+  }
+
+  const auto *at = res.deltas.data();
+  for(size_t i = 0; i < n; i++) {
+    if(!get_varint(at, res.deltas.data() + res.deltas.size()).has_value()) return std::nullopt;
+  }
+  if(at != res.deltas.data() + res.deltas.size()) return std::nullopt;
+
+  for(const auto &r : res.strings) if(!within(r, res.string_pool.size())) return std::nullopt;
+  for(const auto &r : symbol_table) if(!within(r, symbol_pool.size())) return std::nullopt;
+  for(const auto idx : res.name_args) if(idx >= names) return std::nullopt;
+  for(const auto &e : res.names) {
+    if(e.section >= symbols || !within(e.template_args, res.name_args.size()) || !name_or(e.next, names, none)) {
+      return std::nullopt;
+    }
+  }
+  for(const auto &e : res.args) if(e.type >= names || e.arg_name >= symbols) return std::nullopt;
+  for(const auto &e : res.template_args) {
+    if(e.arg_name >= symbols || !within(e.constraints, res.name_args.size())) return std::nullopt;
+  }
+  for(const auto &e : res.functions) {
+    if(e.function_name >= symbols || !name_or(e.receiver, names, none) || !within(e.args, res.args.size()) ||
+       !within(e.template_args, res.template_args.size()) ||
+       !(e.return_type == auto_type || name_or(e.return_type, names, none))) {
+      return std::nullopt;
+    }
+  }
+  for(const auto &e : res.types) {
+    if(e.type_name >= symbols || !within(e.bases, res.name_args.size()) ||
+       !within(e.template_args, res.template_args.size())) {
+      return std::nullopt;
+    }
+  }
+  for(const auto &e : res.variables) if(e.var_name >= symbols || !name_or(e.type, names, none)) return std::nullopt;
+
+  res.symbols.reserve(symbols);
+  for(const auto &[begin, end] : symbol_table) {
+    res.symbols.push_back(interned{ symbol_pool.substr(begin, end - begin) }.id());
+  }
+  res.source = sources.add_file(source_file, std::move(source));
+  return res;
+}
+
+std::string_view mapped_ast::string_value(const node_id id) const {
+  const auto [begin, end] = strings[payloads[id]];
+  return string_pool.substr(begin, end - begin);
+}
+
+location mapped_ast::pos(const node_id id) const {
+  if(positions.empty()) {
+    positions.reserve(size());
+    const auto *at = deltas.data();
+    uint32_t previous = 0;
+    for(size_t i = 0; i < size(); i++) {
+      const auto v = *get_varint(at, deltas.data() + deltas.size()); // validated on load
+      if(v == 0) {
+        positions.push_back(location{});
+        continue;
+      }
+      const auto zigzag = v - 1;
+      previous += static_cast<uint32_t>(static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+      positions.push_back(location{ source, previous });
+    }
+  }
+  return positions[id];
+}
+
+flat_ast mapped_ast::to_flat() const {
+  const auto sym = [this](const uint32_t idx) { return interned::from_id(symbols[idx]); };
+  const auto loc = [this](const uint32_t offset) { return offset == 0 ? location{} : location{ source, offset - 1 }; };
+
+  flat_ast out;
+  out.kind.assign(kinds.begin(), kinds.end());
+  out.subtree_end.assign(ends.begin(), ends.end());
+  out.payload.assign(payloads.begin(), payloads.end());
+  out.pos.reserve(size());
+  for(node_id i = 0; i < size(); i++) {
+    if(has_symbol_payload(kinds[i])) out.payload[i] = symbols[payloads[i]];
+    out.pos.push_back(pos(i));
+  }
+
+  out.literals.assign(literals.begin(), literals.end());
+  out.strings.assign(strings.begin(), strings.end());
+  out.string_pool = std::string{string_pool};
+  for(const auto &n : names) out.names.push_back({ sym(n.section), n.template_args, n.next, n.is_array != 0 });
+  out.name_args.assign(name_args.begin(), name_args.end());
+  for(const auto &a : args) out.args.push_back({ a.type, sym(a.arg_name), loc(a.offset) });
+  for(const auto &t : template_args) out.template_args.push_back({ sym(t.arg_name), t.constraints });
+  for(const auto &f : functions) {
+    out.functions.push_back({ sym(f.function_name), f.receiver, f.args, f.template_args, f.return_type });
+  }
+  for(const auto &t : types) out.types.push_back({ sym(t.type_name), t.bases, t.template_args });
+  for(const auto &v : variables) out.variables.push_back({ sym(v.var_name), v.type, v.is_mutable != 0 });
+  return out;
+}
@@ -0,0 +1,89 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef AST_CACHE_HPP
+#define AST_CACHE_HPP
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "flat_ast.hpp"
+#include "lexer/source_buffer.hpp"
+
+namespace jayc::parser::flat {
+// binary AST (native byte order), versioned and keyed by a hash of the source it was parsed from; it's a flat_ast
+// written section by section, each section 8-byte aligned:
+//   header | kind | subtree_end | payload | positions | literals | strings | string pool | names | name args | args |
+//   template args | functions | types | variables | symbols | symbol pool
+// positions are varint deltas between consecutive nodes' offsets; interned names are stored by spelling (interned IDs
+// are per-process) in the symbol table
+constexpr uint32_t ast_cache_version = 1;
+
+namespace internal_ {
+// side table records on disk: interned names are symbol table indices, locations are offset + 1 (0: unknown)
+struct cached_name { uint32_t section; range template_args; uint32_t next; uint32_t is_array; };
+struct cached_arg { uint32_t type; uint32_t arg_name; uint32_t offset; };
+struct cached_template_arg { uint32_t arg_name; range constraints; };
+struct cached_function {
+  uint32_t function_name; uint32_t receiver; range args; range template_args; uint32_t return_type;
+};
+struct cached_type { uint32_t type_name; range bases; range template_args; };
+struct cached_variable { uint32_t var_name; uint32_t type; uint32_t is_mutable; };
+}
+
+// writes the tree parsed from source_file to path; false if either file cannot be read or written
+bool write_ast_cache(const std::string &path, const std::string &source_file, const flat_ast &tree);
+
+// a binary AST mapped into memory; the node arrays are used in place, and only the interned names are resolved on load
+class mapped_ast {
+public:
+  // nullopt if there is no (valid) binary AST at path for the current contents of source_file
+  static std::optional<mapped_ast> load(const std::string &path, const std::string &source_file);
+
+  [[nodiscard]] inline size_t size() const { return kinds.size(); }
+  [[nodiscard]] inline node_kind kind(const node_id id) const { return kinds[id]; }
+  [[nodiscard]] inline node_id subtree_end(const node_id id) const { return ends[id]; }
+  [[nodiscard]] inline uint32_t payload(const node_id id) const { return payloads[id]; }
+  // for MEMBER, FOR_EACH and NAMESPACE nodes
+  [[nodiscard]] inline jaydk::interned ident(const node_id id) const {
+    return jaydk::interned::from_id(symbols[payloads[id]]);
+  }
+  [[nodiscard]] std::string_view string_value(node_id id) const;
+  // positions are decoded (all at once) the first time one is asked for; not thread-safe
+  [[nodiscard]] location pos(node_id id) const;
+
+  // deserialises the whole tree
+  [[nodiscard]] flat_ast to_flat() const;
+
+  // bytes of the mapped file
+  [[nodiscard]] inline size_t mapped_size() const { return file->size(); }
+
+private:
+  mapped_ast() = default;
+
+  std::shared_ptr<lexer::source_buffer> file;
+  file_id source = 0;
+  std::span<const node_kind> kinds;
+  std::span<const node_id> ends;
+  std::span<const uint32_t> payloads;
+  std::span<const uint8_t> deltas;
+  std::span<const uint64_t> literals;
+  std::span<const range> strings;
+  std::string_view string_pool;
+  std::span<const internal_::cached_name> names;
+  std::span<const uint32_t> name_args;
+  std::span<const internal_::cached_arg> args;
+  std::span<const internal_::cached_template_arg> template_args;
+  std::span<const internal_::cached_function> functions;
+  std::span<const internal_::cached_type> types;
+  std::span<const internal_::cached_variable> variables;
+  std::vector<uint32_t> symbols; //!< Interned ID of each symbol table entry
+  mutable std::vector<location> positions{};
+};
+}
+
+#endif //AST_CACHE_HPP
@@ -0,0 +1,317 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <bit>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#include "ast_hash.hpp"
+
+using namespace jaydk;
+using namespace jayc;
+using namespace jayc::parser;
+
+namespace {
+template <typename ... Fs> struct overload : Fs... { using Fs::operator()...; };
+
+// node categories, mixed in first so an expression never hashes like a statement with the same fields
+enum struct tag : uint64_t { NAME = 1, EXPRESSION, STATEMENT, DECLARATION, FUNCTION, TYPE, GLOBAL, TOKENS };
+
+constexpr uint64_t avalanche(uint64_t x) {
+  // murmur3's finaliser
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// two 64-bit lanes with different multipliers, only avalanched once done (most nodes mix in just a few words)
+class hasher {
+public:
+  explicit hasher(const tag t, const uint64_t kind = 0) { mix(static_cast<uint64_t>(t) << 32 | kind); }
+
+  hasher &mix(const uint64_t v) {
+    low = std::rotl((low ^ v) * 0x9e3779b97f4a7c15ULL, 29);
+    high = std::rotl((high + v) * 0xc2b2ae3d27d4eb4fULL, 31) ^ low;
+    return *this;
+  }
+
+  hasher &mix(const structural_hash &h) { return mix(h.low).mix(h.high); }
+
+  hasher &mix(const std::string_view s) {
+    mix(s.size());
+    size_t i = 0;
+    for(; i + 8 <= s.size(); i += 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, s.data() + i, 8);
+      mix(chunk);
+    }
+    if(i < s.size()) {
+      uint64_t chunk = 0;
+      std::memcpy(&chunk, s.data() + i, s.size() - i);
+      mix(chunk);
+    }
+    return *this;
+  }
+
+  // by spelling, since interned IDs depend on the order things were interned in
+  hasher &mix(const interned i) {
+    thread_local std::vector<uint64_t> spellings; // per interned ID; 0: not yet hashed
+    if(i.id() >= spellings.size()) spellings.resize(i.id() + 1, 0);
+    auto &cached = spellings[i.id()];
+    if(cached == 0) cached = std::max<uint64_t>(hasher{ tag::NAME }.mix(i.view()).done().low, 1);
+    return mix(cached);
+  }
+
+  [[nodiscard]] structural_hash done() const {
+    const auto l = avalanche(low ^ std::rotl(high, 17));
+    return { l, avalanche(high + l) };
+  }
+
+private:
+  uint64_t low = 0x243f6a8885a308d3ULL;
+  uint64_t high = 0x13198a2e03707344ULL;
+};
+
+structural_hash hash_name(const name &n) {
+  hasher h{ tag::NAME, n.is_array };
+  h.mix(n.section).mix(n.template_args.size());
+  for(const auto &arg : n.template_args) h.mix(hash_name(arg));
+  if(n.next.has_value()) h.mix(hash_name(*n.next));
+  return h.done();
+}
+
+template <typename T>
+hasher &mix_opt(hasher &h, const std::optional<T> &v, auto &&hash) {
+  h.mix(v.has_value());
+  if(v.has_value()) h.mix(hash(*v));
+  return h;
+}
+
+template <typename R>
+hasher &mix_all(hasher &h, const R &range, auto &&hash) {
+  h.mix(std::ranges::size(range));
+  for(const auto &x : range) h.mix(hash(x));
+  return h;
+}
+
+const auto node_hash = [](const auto &n) { return n.hash; };
+
+hasher &mix_template_args(hasher &h, const arena_vector<template_function_decl::template_arg> &args) {
+  h.mix(args.size());
+  for(const auto &a : args) mix_all(h.mix(a.arg_name), a.constraints, hash_name);
+  return h;
+}
+
+hasher &mix_signature(
+  hasher &h, const function_decl::args_t &args, const function_decl::return_type_t &return_type
+) {
+  h.mix(args.size());
+  for(const auto &a : args) h.mix(hash_name(a.type)).mix(a.arg_name);
+  h.mix(return_type.index());
+  if(is<name>(return_type)) h.mix(hash_name(as<name>(return_type)));
+  return h;
+}
+
+structural_hash hash_function(const function_decl &fn) {
+  hasher h{ tag::FUNCTION };
+  return mix_signature(h.mix(fn.function_name), fn.args, fn.return_type).mix(fn.body.hash()).done();
+}
+
+structural_hash hash_global(const global_decl &g) {
+  hasher h{ tag::GLOBAL, g.is_mutable };
+  return mix_opt(h.mix(g.glob_name), g.type, hash_name).mix(g.value.hash).done();
+}
+
+structural_hash hash_namespace(const namespace_decl &ns) {
+  hasher h{ tag::DECLARATION };
+  return mix_all(h.mix(ns.name), ns.declarations, node_hash).done();
+}
+
+structural_hash hash_template_type(const template_type_decl &t);
+
+structural_hash hash_type(const type_decl &t) {
+  hasher h{ tag::TYPE };
+  mix_all(h.mix(t.type_name), t.bases, hash_name);
+  mix_all(h, t.fields, [](const auto &f) { return hash_global(f.first); });
+  mix_all(h, t.members, [](const auto &m) { return hash_function(m.first); });
+  mix_all(h, t.template_members, [](const auto &m) {
+    hasher th{ tag::FUNCTION, 1 };
+    return mix_template_args(th, m.first.template_args).mix(hash_function(m.first.base)).done();
+  });
+  mix_all(h, t.nested_types, [](const auto &n) { return hash_type(n.first); });
+  mix_all(h, t.nested_template_types, [](const auto &n) { return hash_template_type(n.first); });
+  return h.done();
+}
+
+structural_hash hash_template_type(const template_type_decl &t) {
+  hasher h{ tag::TYPE, 1 };
+  return mix_template_args(h, t.template_args).mix(hash_type(t.base)).done();
+}
+
+void spell(std::ostream &out, const name &n) {
+  out << n.section;
+  if(!n.template_args.empty()) {
+    out << "<";
+    for(size_t i = 0; i < n.template_args.size(); i++) {
+      if(i != 0) out << ", ";
+      spell(out, n.template_args[i]);
+    }
+    out << ">";
+  }
+  if(n.is_array) out << "[]";
+  if(n.next.has_value()) spell(out << "::", *n.next);
+}
+
+// the name a declaration is matched by in diff_declarations
+std::string key_of(const declaration &d) {
+  std::stringstream out;
+  std::visit(overload{
+    [&out](const namespace_decl &ns) { out << ns.name; },
+    [&out](const function_decl &fn) { out << fn.function_name; },
+    [&out](const template_function_decl &fn) { out << fn.base.function_name; },
+    [&out](const ext_function_decl &fn) { spell(out, fn.receiver); out << "." << fn.ext_func_name; },
+    [&out](const template_ext_function_decl &fn) { spell(out, fn.base.receiver); out << "." << fn.base.ext_func_name; },
+    [&out](const type_decl &t) { out << t.type_name; },
+    [&out](const template_type_decl &t) { out << t.base.type_name; },
+    [&out](const global_decl &g) { out << g.glob_name; },
+  }, d.content);
+  return out.str();
+}
+
+void diff(
+  const std::string &prefix, const arena_vector<declaration> &before, const arena_vector<declaration> &after,
+  std::vector<decl_change> &out
+) {
+  // key -> the declarations in `before` with that key, in order; overloads pair up by position
+  std::unordered_map<std::string, std::vector<const declaration *>> old_decls;
+  std::unordered_map<const declaration *, bool> matched;
+  for(const auto &d : before) old_decls[key_of(d)].push_back(&d);
+
+  std::unordered_map<std::string, size_t> seen;
+  for(const auto &d : after) {
+    const auto key = key_of(d);
+    const auto nth = seen[key]++;
+    const auto it = old_decls.find(key);
+    if(it == old_decls.end() || nth >= it->second.size()) {
+      out.push_back({ decl_change_kind::ADDED, prefix + key, nullptr, &d });
+      continue;
+    }
+
+    const auto *old = it->second[nth];
+    matched[old] = true;
+    if(old->hash == d.hash) continue;
+    if(is<namespace_decl>(old->content) && is<namespace_decl>(d.content)) {
+      diff(prefix + key + "::", as<namespace_decl>(old->content).declarations,
+        as<namespace_decl>(d.content).declarations, out);
+    }
+    else out.push_back({ decl_change_kind::CHANGED, prefix + key, old, &d });
+  }
+
+  for(const auto &d : before) {
+    if(!matched.contains(&d)) out.push_back({ decl_change_kind::REMOVED, prefix + key_of(d), &d, nullptr });
+  }
+}
+}
+
+structural_hash expression::hash_content(const actual_t &content) {
+  hasher h{ tag::EXPRESSION, content.index() };
+  std::visit(overload{
+    [&h](const literal_expr<int64_t> &l) { h.mix(std::bit_cast<uint64_t>(l.value)); },
+    [&h](const literal_expr<uint64_t> &l) { h.mix(l.value); },
+    [&h](const literal_expr<float> &l) { h.mix(std::bit_cast<uint32_t>(l.value)); },
+    [&h](const literal_expr<double> &l) { h.mix(std::bit_cast<uint64_t>(l.value)); },
+    [&h](const literal_expr<char> &l) { h.mix(static_cast<uint8_t>(l.value)); },
+    [&h](const literal_expr<std::string_view> &l) { h.mix(l.value); },
+    [&h](const literal_expr<bool> &l) { h.mix(l.value); },
+    [&h](const name_expr &n) { h.mix(hash_name(n.actual)); },
+    [&h](const unary_expr &u) { h.mix(static_cast<uint64_t>(u.op)).mix(u.expr->hash); },
+    [&h](const binary_expr &b) { h.mix(static_cast<uint64_t>(b.op)).mix(b.left->hash).mix(b.right->hash); },
+    [&h](const ternary_expr &t) { h.mix(t.cond->hash).mix(t.true_expr->hash).mix(t.false_expr->hash); },
+    [&h](const call_expr &c) { mix_all(h.mix(c.call->hash), c.args, node_hash); },
+    [&h](const index_expr &i) { h.mix(i.base->hash).mix(i.index->hash); },
+    [&h](const member_expr &m) { h.mix(m.base->hash).mix(m.member); },
+  }, content);
+  return h.done();
+}
+
+structural_hash statement::hash_content(const actual_t &content) {
+  hasher h{ tag::STATEMENT, content.index() };
+  std::visit(overload{
+    [&h](const block &b) { mix_all(h, b.statements, node_hash); },
+    [&h](const expr_stmt &e) { h.mix(e.expr.hash); },
+    [&h](const var_decl_stmt &v) {
+      mix_opt(h.mix(v.var_name).mix(v.is_mutable), v.type_name, hash_name).mix(v.value.hash);
+    },
+    [&h](const if_stmt &i) {
+      h.mix(i.condition.hash).mix(i.true_block->hash).mix(i.false_block.has_value());
+      if(i.false_block.has_value()) h.mix((*i.false_block)->hash);
+    },
+    [&h](const for_stmt &f) { h.mix(f.init->hash).mix(f.condition.hash).mix(f.update.hash).mix(f.block->hash); },
+    [&h](const for_each_stmt &f) { h.mix(f.binding).mix(f.collection.hash).mix(f.block->hash); },
+    [&h](const while_stmt &w) { h.mix(w.is_do_while).mix(w.condition.hash).mix(w.block->hash); },
+    [](const break_stmt &) {},
+    [](const continue_stmt &) {},
+    [&h](const return_stmt &r) { mix_opt(h, r.value, node_hash); },
+  }, content);
+  return h.done();
+}
+
+structural_hash declaration::hash_content(const actual_t &content) {
+  hasher h{ tag::DECLARATION, content.index() };
+  std::visit(overload{
+    [&h](const namespace_decl &ns) { h.mix(hash_namespace(ns)); },
+    [&h](const function_decl &fn) { h.mix(hash_function(fn)); },
+    [&h](const template_function_decl &fn) { mix_template_args(h, fn.template_args).mix(hash_function(fn.base)); },
+    [&h](const ext_function_decl &fn) {
+      h.mix(hash_name(fn.receiver)).mix(fn.ext_func_name);
+      mix_signature(h, fn.args, fn.return_type).mix(fn.body.hash());
+    },
+    [&h](const template_ext_function_decl &fn) {
+      mix_template_args(h, fn.template_args).mix(hash_name(fn.base.receiver)).mix(fn.base.ext_func_name);
+      mix_signature(h, fn.base.args, fn.base.return_type).mix(fn.base.body.hash());
+    },
+    [&h](const type_decl &t) { h.mix(hash_type(t)); },
+    [&h](const template_type_decl &t) { h.mix(hash_template_type(t)); },
+    [&h](const global_decl &g) { h.mix(hash_global(g)); },
+  }, content);
+  return h.done();
+}
+
+structural_hash function_body::hash() const {
+  if(lazy != nullptr) return hash_tokens(lazy->tokens);
+  hasher h{ tag::STATEMENT };
+  return mix_all(h, eager, node_hash).done();
+}
+
+structural_hash jayc::parser::hash_of(const namespace_decl &ns) {
+  return hash_namespace(ns);
+}
+
+structural_hash jayc::parser::hash_tokens(const std::span<const lexer::token> tokens) {
+  using namespace jayc::lexer;
+  hasher h{ tag::TOKENS, tokens.size() };
+  for(const auto &t : tokens) {
+    h.mix(static_cast<uint64_t>(t.kind) << 8 | t.sub);
+    switch(t.kind) {
+      case token_kind::IDENTIFIER: h.mix(as<identifier>(t).ident); break;
+      case token_kind::INT64: h.mix(std::bit_cast<uint64_t>(as<literal<int64_t>>(t).value)); break;
+      case token_kind::UINT64: h.mix(as<literal<uint64_t>>(t).value); break;
+      case token_kind::FLOAT64: h.mix(std::bit_cast<uint64_t>(as<literal<double>>(t).value)); break;
+      case token_kind::STRING: h.mix(as<literal<std::string_view>>(t).value); break;
+      case token_kind::FLOAT32: case token_kind::CHAR: case token_kind::BOOL: h.mix(t.payload); break;
+      default: break;
+    }
+  }
+  return h.done();
+}
+
+std::vector<decl_change> jayc::parser::diff_declarations(const namespace_decl &before, const namespace_decl &after) {
+  std::vector<decl_change> changes;
+  diff("", before.declarations, after.declarations, changes);
+  return changes;
+}
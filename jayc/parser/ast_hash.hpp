@@ -0,0 +1,39 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef AST_HASH_HPP
+#define AST_HASH_HPP
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "ast.hpp"
+
+namespace jayc::parser {
+// every expression, statement and declaration carries a structural_hash, computed bottom-up as the parser builds it
+// (each node only mixes its own fields with its children's hashes); locations are ignored and names are hashed by
+// spelling, so the same code hashes the same across compiles, wherever it is in the file
+
+// the hash of a module (or any namespace) as a whole
+structural_hash hash_of(const namespace_decl &ns);
+// the hash of a run of tokens (what a deferred function body hashes)
+structural_hash hash_tokens(std::span<const lexer::token> tokens);
+
+enum struct decl_change_kind { ADDED, REMOVED, CHANGED };
+
+struct decl_change {
+  decl_change_kind kind;
+  std::string path; //!< Qualified name (`a::b::f`; `T.f` for extension functions)
+  const declaration *before; //!< nullptr if added
+  const declaration *after; //!< nullptr if removed
+};
+
+// compares two versions of a module at declaration granularity; declarations are matched by qualified name (overloads
+// in order of appearance), namespaces are compared member by member, and unchanged declarations are left out
+// changes are in the order of `after`, followed by the removed declarations in the order of `before`
+std::vector<decl_change> diff_declarations(const namespace_decl &before, const namespace_decl &after);
+}
+
+#endif //AST_HASH_HPP
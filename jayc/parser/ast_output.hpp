@@ -407,7 +407,7 @@ inline void print_decl(std::ostream &target, const declaration &d, size_t i) {
 }
 
 inline std::ostream &operator<<(std::ostream &target, const jayc::parser::ast &ast) {
-  for(const auto &d: ast) jayc::parser::print_decl(target, d, 0);
+  for(const auto &d: ast.declarations) jayc::parser::print_decl(target, d, 0);
   return target;
 }
 
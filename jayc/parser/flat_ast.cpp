@@ -0,0 +1,337 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <bit>
+
+#include "flat_ast.hpp"
+
+using namespace jaydk;
+using namespace jayc;
+using namespace jayc::parser;
+using namespace jayc::parser::flat;
+
+namespace {
+template <typename ... Fs> struct overload : Fs... { using Fs::operator()...; };
+
+struct flattener {
+  flat_ast &out;
+
+  // appends a node and returns its ID; close(id) must follow once its children are emitted
+  node_id open(const node_kind k, const location &pos, const uint32_t payload = 0) const {
+    const auto id = static_cast<node_id>(out.kind.size());
+    out.kind.push_back(k);
+    out.pos.push_back(pos);
+    out.subtree_end.push_back(id + 1);
+    out.payload.push_back(payload);
+    return id;
+  }
+
+  void close(const node_id id) const { out.subtree_end[id] = static_cast<node_id>(out.kind.size()); }
+
+  void leaf(const node_kind k, const location &pos, const uint32_t payload = 0) const { (void)open(k, pos, payload); }
+
+  uint32_t literal(const uint64_t bits) const {
+    out.literals.push_back(bits);
+    return static_cast<uint32_t>(out.literals.size() - 1);
+  }
+
+  uint32_t name_of(const name &n) {
+    // template arguments first, so they have their own (contiguous) range in name_args
+    std::vector<uint32_t> args;
+    args.reserve(n.template_args.size());
+    for(const auto &a : n.template_args) args.push_back(name_of(a));
+
+    const auto idx = static_cast<uint32_t>(out.names.size());
+    out.names.push_back({ .section = n.section, .template_args = name_list(args), .next = none, .is_array = n.is_array });
+    if(n.next.has_value()) {
+      const auto next = name_of(*n.next);
+      out.names[idx].next = next;
+    }
+    return idx;
+  }
+
+  template <typename R>
+  range names_of(const R &names) {
+    std::vector<uint32_t> indices;
+    indices.reserve(names.size());
+    for(const auto &n : names) indices.push_back(name_of(n));
+    return name_list(indices);
+  }
+
+  range name_list(const std::vector<uint32_t> &indices) const {
+    const auto begin = static_cast<uint32_t>(out.name_args.size());
+    out.name_args.insert(out.name_args.end(), indices.begin(), indices.end());
+    return { begin, static_cast<uint32_t>(out.name_args.size()) };
+  }
+
+  uint32_t optional_name(const std::optional<name> &n) { return n.has_value() ? name_of(*n) : none; }
+
+  template <typename R>
+  range template_args_of(const R &template_args) {
+    std::vector<template_arg_entry> entries;
+    entries.reserve(template_args.size());
+    for(const auto &t : template_args) entries.push_back({ .arg_name = t.arg_name, .constraints = names_of(t.constraints) });
+    const auto begin = static_cast<uint32_t>(out.template_args.size());
+    out.template_args.insert(out.template_args.end(), entries.begin(), entries.end());
+    return { begin, static_cast<uint32_t>(out.template_args.size()) };
+  }
+
+  template <typename R>
+  range args_of(const R &args) {
+    std::vector<arg_entry> entries;
+    entries.reserve(args.size());
+    for(const auto &a : args) entries.push_back({ .type = name_of(a.type), .arg_name = a.arg_name, .pos = a.pos });
+    const auto begin = static_cast<uint32_t>(out.args.size());
+    out.args.insert(out.args.end(), entries.begin(), entries.end());
+    return { begin, static_cast<uint32_t>(out.args.size()) };
+  }
+
+  uint32_t return_type_of(const function_decl::return_type_t &t) {
+    if(std::holds_alternative<function_decl::auto_type>(t)) return auto_type;
+    if(const auto *n = std::get_if<name>(&t)) return name_of(*n);
+    return none;
+  }
+
+  uint32_t variable(const jaydk::interned var_name, const std::optional<name> &type, const bool is_mutable) {
+    const auto t = optional_name(type);
+    out.variables.push_back({ .var_name = var_name, .type = t, .is_mutable = is_mutable });
+    return static_cast<uint32_t>(out.variables.size() - 1);
+  }
+
+  uint32_t function(const jaydk::interned fn_name, const uint32_t receiver, const range args, const range template_args,
+                    const uint32_t return_type) const {
+    out.functions.push_back({
+      .function_name = fn_name, .receiver = receiver, .args = args, .template_args = template_args, .return_type = return_type
+    });
+    return static_cast<uint32_t>(out.functions.size() - 1);
+  }
+
+  void operator()(const expression &e) {
+    std::visit(overload{
+      [this, &e](const literal_expr<int64_t> &l) { leaf(node_kind::INT_LITERAL, e.pos, literal(std::bit_cast<uint64_t>(l.value))); },
+      [this, &e](const literal_expr<uint64_t> &l) { leaf(node_kind::UINT_LITERAL, e.pos, literal(l.value)); },
+      [this, &e](const literal_expr<float> &l) { leaf(node_kind::FLOAT_LITERAL, e.pos, literal(std::bit_cast<uint32_t>(l.value))); },
+      [this, &e](const literal_expr<double> &l) { leaf(node_kind::DOUBLE_LITERAL, e.pos, literal(std::bit_cast<uint64_t>(l.value))); },
+      [this, &e](const literal_expr<char> &l) { leaf(node_kind::CHAR_LITERAL, e.pos, literal(static_cast<uint8_t>(l.value))); },
+      [this, &e](const literal_expr<bool> &l) { leaf(node_kind::BOOL_LITERAL, e.pos, literal(l.value ? 1 : 0)); },
+      [this, &e](const literal_expr<std::string_view> &l) {
+        const auto begin = static_cast<uint32_t>(out.string_pool.size());
+        out.string_pool += l.value;
+        out.strings.push_back({ begin, static_cast<uint32_t>(out.string_pool.size()) });
+        leaf(node_kind::STRING_LITERAL, e.pos, static_cast<uint32_t>(out.strings.size() - 1));
+      },
+      [this, &e](const name_expr &n) {
+        const auto idx = name_of(n.actual);
+        leaf(node_kind::NAME, e.pos, idx);
+      },
+      [this, &e](const unary_expr &u) {
+        const auto id = open(node_kind::UNARY, e.pos, static_cast<uint32_t>(u.op));
+        (*this)(*u.expr);
+        close(id);
+      },
+      [this, &e](const binary_expr &b) {
+        const auto id = open(node_kind::BINARY, e.pos, static_cast<uint32_t>(b.op));
+        (*this)(*b.left);
+        (*this)(*b.right);
+        close(id);
+      },
+      [this, &e](const ternary_expr &t) {
+        const auto id = open(node_kind::TERNARY, e.pos);
+        (*this)(*t.cond);
+        (*this)(*t.true_expr);
+        (*this)(*t.false_expr);
+        close(id);
+      },
+      [this, &e](const call_expr &c) {
+        const auto id = open(node_kind::CALL, e.pos);
+        (*this)(*c.call);
+        for(const auto &a : c.args) (*this)(a);
+        close(id);
+      },
+      [this, &e](const index_expr &i) {
+        const auto id = open(node_kind::INDEX, e.pos);
+        (*this)(*i.base);
+        (*this)(*i.index);
+        close(id);
+      },
+      [this, &e](const member_expr &m) {
+        const auto id = open(node_kind::MEMBER, e.pos, m.member.id());
+        (*this)(*m.base);
+        close(id);
+      }
+    }, e.content);
+  }
+
+  void operator()(const statement &s) {
+    std::visit(overload{
+      [this, &s](const block &b) {
+        const auto id = open(node_kind::BLOCK, s.pos);
+        for(const auto &sub : b.statements) (*this)(sub);
+        close(id);
+      },
+      [this, &s](const expr_stmt &e) {
+        const auto id = open(node_kind::EXPR_STMT, s.pos);
+        (*this)(e.expr);
+        close(id);
+      },
+      [this, &s](const var_decl_stmt &v) {
+        const auto var = variable(v.var_name, v.type_name, v.is_mutable);
+        const auto id = open(node_kind::VAR_DECL, s.pos, var);
+        (*this)(v.value);
+        close(id);
+      },
+      [this, &s](const if_stmt &i) {
+        const auto id = open(node_kind::IF, s.pos);
+        (*this)(i.condition);
+        (*this)(*i.true_block);
+        if(i.false_block.has_value()) (*this)(**i.false_block);
+        close(id);
+      },
+      [this, &s](const for_stmt &f) {
+        const auto id = open(node_kind::FOR, s.pos);
+        (*this)(*f.init);
+        (*this)(f.condition);
+        (*this)(f.update);
+        (*this)(*f.block);
+        close(id);
+      },
+      [this, &s](const for_each_stmt &f) {
+        const auto id = open(node_kind::FOR_EACH, s.pos, f.binding.id());
+        (*this)(f.collection);
+        (*this)(*f.block);
+        close(id);
+      },
+      [this, &s](const while_stmt &w) {
+        const auto id = open(w.is_do_while ? node_kind::DO_WHILE : node_kind::WHILE, s.pos);
+        (*this)(w.condition);
+        (*this)(*w.block);
+        close(id);
+      },
+      [this, &s](const break_stmt &) { leaf(node_kind::BREAK, s.pos); },
+      [this, &s](const continue_stmt &) { leaf(node_kind::CONTINUE, s.pos); },
+      [this, &s](const return_stmt &r) {
+        const auto id = open(node_kind::RETURN, s.pos);
+        if(r.value.has_value()) (*this)(*r.value);
+        close(id);
+      }
+    }, s.content);
+  }
+
+  void body(const node_kind k, const location &pos, const uint32_t fn, const function_body &statements) {
+    const auto id = open(k, pos, fn);
+    for(const auto &s : statements) (*this)(s);
+    close(id);
+  }
+
+  void function_node(const function_decl &f, const location &pos) {
+    const auto fn = function(f.function_name, none, args_of(f.args), {}, return_type_of(f.return_type));
+    body(node_kind::FUNCTION, pos, fn, f.body);
+  }
+
+  void template_function_node(const template_function_decl &f, const location &pos) {
+    const auto targs = template_args_of(f.template_args);
+    const auto fn = function(f.base.function_name, none, args_of(f.base.args), targs, return_type_of(f.base.return_type));
+    body(node_kind::TEMPLATE_FUNCTION, pos, fn, f.base.body);
+  }
+
+  void global_node(const global_decl &g, const location &pos) {
+    const auto var = variable(g.glob_name, g.type, g.is_mutable);
+    const auto id = open(node_kind::GLOBAL, pos, var);
+    (*this)(g.value);
+    close(id);
+  }
+
+  void type_node(const node_kind k, const type_decl &t, const range template_args, const location &pos) {
+    out.types.push_back({ .type_name = t.type_name, .bases = names_of(t.bases), .template_args = template_args });
+    const auto id = open(k, pos, static_cast<uint32_t>(out.types.size() - 1));
+    for(const auto &[g, p] : t.fields) global_node(g, p);
+    for(const auto &[f, p] : t.members) function_node(f, p);
+    for(const auto &[f, p] : t.template_members) template_function_node(f, p);
+    for(const auto &[n, p] : t.nested_types) type_node(node_kind::TYPE, n, {}, p);
+    for(const auto &[n, p] : t.nested_template_types) {
+      const auto targs = template_args_of(n.template_args);
+      type_node(node_kind::TEMPLATE_TYPE, n.base, targs, p);
+    }
+    close(id);
+  }
+
+  void namespace_node(const namespace_decl &n, const location &pos) {
+    const auto id = open(node_kind::NAMESPACE, pos, n.name.id());
+    for(const auto &d : n.declarations) (*this)(d);
+    close(id);
+  }
+
+  void operator()(const declaration &d) {
+    std::visit(overload{
+      [this, &d](const namespace_decl &n) { namespace_node(n, d.pos); },
+      [this, &d](const function_decl &f) { function_node(f, d.pos); },
+      [this, &d](const template_function_decl &f) { template_function_node(f, d.pos); },
+      [this, &d](const ext_function_decl &f) {
+        const auto receiver = name_of(f.receiver);
+        const auto fn = function(f.ext_func_name, receiver, args_of(f.args), {}, return_type_of(f.return_type));
+        body(node_kind::EXT_FUNCTION, d.pos, fn, f.body);
+      },
+      [this, &d](const template_ext_function_decl &f) {
+        const auto targs = template_args_of(f.template_args);
+        const auto receiver = name_of(f.base.receiver);
+        const auto fn = function(f.base.ext_func_name, receiver, args_of(f.base.args), targs, return_type_of(f.base.return_type));
+        body(node_kind::TEMPLATE_EXT_FUNCTION, d.pos, fn, f.base.body);
+      },
+      [this, &d](const type_decl &t) { type_node(node_kind::TYPE, t, {}, d.pos); },
+      [this, &d](const template_type_decl &t) {
+        const auto targs = template_args_of(t.template_args);
+        type_node(node_kind::TEMPLATE_TYPE, t.base, targs, d.pos);
+      },
+      [this, &d](const global_decl &g) { global_node(g, d.pos); }
+    }, d.content);
+  }
+};
+
+template <typename T>
+size_t bytes(const std::vector<T> &v) { return v.size() * sizeof(T); }
+}
+
+size_t flat_ast::child_count(const node_id id) const {
+  size_t count = 0;
+  for([[maybe_unused]] const auto c : children(id)) count++;
+  return count;
+}
+
+node_id flat_ast::child(const node_id id, size_t n) const {
+  node_id at = id + 1;
+  while(n-- > 0) at = subtree_end[at];
+  return at;
+}
+
+int64_t flat_ast::int_value(const node_id id) const { return std::bit_cast<int64_t>(literals[payload[id]]); }
+uint64_t flat_ast::uint_value(const node_id id) const { return literals[payload[id]]; }
+float flat_ast::float_value(const node_id id) const { return std::bit_cast<float>(static_cast<uint32_t>(literals[payload[id]])); }
+double flat_ast::double_value(const node_id id) const { return std::bit_cast<double>(literals[payload[id]]); }
+char flat_ast::char_value(const node_id id) const { return static_cast<char>(literals[payload[id]]); }
+bool flat_ast::bool_value(const node_id id) const { return literals[payload[id]] != 0; }
+
+std::string_view flat_ast::string_value(const node_id id) const {
+  const auto [begin, end] = strings[payload[id]];
+  return std::string_view{string_pool}.substr(begin, end - begin);
+}
+
+name flat_ast::to_name(const uint32_t index) const {
+  const auto &entry = names[index];
+  name res{ .section = entry.section, .template_args = {}, .next = std::nullopt, .is_array = entry.is_array };
+  for(uint32_t i = entry.template_args.begin; i < entry.template_args.end; i++) res.template_args.push_back(to_name(name_args[i]));
+  if(entry.next != none) res.next = to_name(entry.next);
+  return res;
+}
+
+size_t flat_ast::memory() const {
+  return bytes(kind) + bytes(pos) + bytes(subtree_end) + bytes(payload) + bytes(literals) + bytes(strings) +
+         string_pool.size() + bytes(names) + bytes(name_args) + bytes(args) + bytes(template_args) + bytes(functions) +
+         bytes(types) + bytes(variables);
+}
+
+flat_ast jayc::parser::flat::flatten(const ast &module) {
+  flat_ast out;
+  flattener{out}.namespace_node(module, location{});
+  return out;
+}
@@ -0,0 +1,222 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef FLAT_AST_HPP
+#define FLAT_AST_HPP
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.hpp"
+
+namespace jayc::parser::flat {
+enum struct node_kind : uint8_t {
+  // expressions
+  INT_LITERAL, UINT_LITERAL, FLOAT_LITERAL, DOUBLE_LITERAL, CHAR_LITERAL, STRING_LITERAL, BOOL_LITERAL,
+  NAME, UNARY, BINARY, TERNARY, CALL, INDEX, MEMBER,
+  // statements
+  BLOCK, EXPR_STMT, VAR_DECL, IF, FOR, FOR_EACH, WHILE, DO_WHILE, BREAK, CONTINUE, RETURN,
+  // declarations
+  NAMESPACE, FUNCTION, TEMPLATE_FUNCTION, EXT_FUNCTION, TEMPLATE_EXT_FUNCTION, TYPE, TEMPLATE_TYPE, GLOBAL
+};
+
+constexpr bool is_expression(const node_kind k) { return k <= node_kind::MEMBER; }
+constexpr bool is_statement(const node_kind k) { return k >= node_kind::BLOCK && k <= node_kind::RETURN; }
+constexpr bool is_declaration(const node_kind k) { return k >= node_kind::NAMESPACE; }
+
+using node_id = uint32_t;
+constexpr static uint32_t none = UINT32_MAX;
+constexpr static uint32_t auto_type = UINT32_MAX - 1; //!< Return type of functions declared with `: auto`
+
+struct range {
+  uint32_t begin = 0;
+  uint32_t end = 0;
+  [[nodiscard]] constexpr uint32_t size() const { return end - begin; }
+  constexpr bool operator==(const range &) const = default;
+};
+
+// one segment of a name (a<b>::c[]); template arguments are in name_args, the next segment is another entry
+struct name_entry {
+  jaydk::interned section;
+  range template_args; //!< Into flat_ast::name_args
+  uint32_t next = none;
+  bool is_array = false;
+  bool operator==(const name_entry &) const = default;
+};
+
+struct arg_entry {
+  uint32_t type; //!< Into flat_ast::names
+  jaydk::interned arg_name;
+  location pos;
+  bool operator==(const arg_entry &) const = default;
+};
+
+struct template_arg_entry {
+  jaydk::interned arg_name;
+  range constraints; //!< Into flat_ast::name_args
+  bool operator==(const template_arg_entry &) const = default;
+};
+
+struct function_entry {
+  jaydk::interned function_name;
+  uint32_t receiver = none; //!< Receiver type (for extension functions), into flat_ast::names
+  range args; //!< Into flat_ast::args
+  range template_args; //!< Into flat_ast::template_args
+  uint32_t return_type = none; //!< Into flat_ast::names, or none/auto_type
+  bool operator==(const function_entry &) const = default;
+};
+
+struct type_entry {
+  jaydk::interned type_name;
+  range bases; //!< Into flat_ast::name_args
+  range template_args; //!< Into flat_ast::template_args
+  bool operator==(const type_entry &) const = default;
+};
+
+struct variable_entry {
+  jaydk::interned var_name;
+  uint32_t type = none; //!< Into flat_ast::names
+  bool is_mutable = false;
+  bool operator==(const variable_entry &) const = default;
+};
+
+/*
+ * All nodes of a module in pre-order, as parallel arrays (one entry per node):
+ *  - kind: what the node is;
+ *  - pos: where it starts;
+ *  - subtree_end: one past its last descendant; its children are id + 1, subtree_end[id + 1], ... up to subtree_end[id];
+ *  - payload: kind-specific; an operator, an interned ID or an index into one of the side tables below.
+ *
+ * payload per kind:
+ *  - literals: index into literals (raw bits), strings for STRING_LITERAL
+ *  - NAME: index into names; UNARY/BINARY: the operator; MEMBER, FOR_EACH, NAMESPACE: interned ID
+ *  - VAR_DECL, GLOBAL: index into variables; *FUNCTION: index into functions; *TYPE: index into types
+ *
+ * children per kind:
+ *  - UNARY: operand; BINARY: left, right; TERNARY: condition, true, false; CALL: callee, args...; INDEX: base, index
+ *  - MEMBER: base; BLOCK: statements...; EXPR_STMT, VAR_DECL, GLOBAL: the expression
+ *  - IF: condition, then, else (optional); FOR: init, condition, update, body; FOR_EACH: collection, body
+ *  - WHILE, DO_WHILE: condition, body; RETURN: value (optional)
+ *  - NAMESPACE: declarations...; *FUNCTION: body statements...
+ *  - *TYPE: fields (GLOBAL), members, template members, nested types, nested template types
+ */
+struct flat_ast {
+  class children_range {
+  public:
+    class iterator {
+    public:
+      using value_type = node_id;
+      using difference_type = std::ptrdiff_t;
+
+      constexpr iterator() = default;
+      constexpr iterator(const flat_ast *tree, const node_id at) : tree{tree}, at{at} {}
+
+      constexpr node_id operator*() const { return at; }
+      constexpr iterator &operator++() { at = tree->subtree_end[at]; return *this; }
+      constexpr iterator operator++(int) { auto copy = *this; ++*this; return copy; }
+      constexpr bool operator==(const iterator &other) const { return at == other.at; }
+
+    private:
+      const flat_ast *tree = nullptr;
+      node_id at = 0;
+    };
+
+    constexpr children_range(const flat_ast *tree, const node_id parent) : tree{tree}, parent{parent} {}
+    [[nodiscard]] constexpr iterator begin() const { return { tree, parent + 1 }; }
+    [[nodiscard]] constexpr iterator end() const { return { tree, tree->subtree_end[parent] }; }
+
+  private:
+    const flat_ast *tree;
+    node_id parent;
+  };
+
+  [[nodiscard]] inline size_t size() const { return kind.size(); }
+  [[nodiscard]] inline children_range children(const node_id id) const { return { this, id }; }
+  [[nodiscard]] size_t child_count(node_id id) const;
+  // the n-th child (n < child_count(id))
+  [[nodiscard]] node_id child(node_id id, size_t n) const;
+
+  [[nodiscard]] inline unary_op unary(const node_id id) const { return static_cast<unary_op>(payload[id]); }
+  [[nodiscard]] inline binary_op binary(const node_id id) const { return static_cast<binary_op>(payload[id]); }
+  [[nodiscard]] inline jaydk::interned ident(const node_id id) const { return jaydk::interned::from_id(payload[id]); }
+  [[nodiscard]] int64_t int_value(node_id id) const;
+  [[nodiscard]] uint64_t uint_value(node_id id) const;
+  [[nodiscard]] float float_value(node_id id) const;
+  [[nodiscard]] double double_value(node_id id) const;
+  [[nodiscard]] char char_value(node_id id) const;
+  [[nodiscard]] bool bool_value(node_id id) const;
+  [[nodiscard]] std::string_view string_value(node_id id) const;
+
+  // converts back to a regular name (allocated in the current arena)
+  [[nodiscard]] name to_name(uint32_t index) const;
+
+  // bytes of memory in use by this tree (excluding the vectors' spare capacity)
+  [[nodiscard]] size_t memory() const;
+
+  std::vector<node_kind> kind;
+  std::vector<location> pos;
+  std::vector<node_id> subtree_end;
+  std::vector<uint32_t> payload;
+
+  std::vector<uint64_t> literals;
+  std::vector<range> strings; //!< Into string_pool
+  std::string string_pool;
+  std::vector<name_entry> names;
+  std::vector<uint32_t> name_args; //!< Indices into names
+  std::vector<arg_entry> args;
+  std::vector<template_arg_entry> template_args;
+  std::vector<function_entry> functions;
+  std::vector<type_entry> types;
+  std::vector<variable_entry> variables;
+
+  bool operator==(const flat_ast &) const = default;
+};
+
+// converts a module; node 0 is the module's (root) namespace
+flat_ast flatten(const ast &module);
+
+// visitor: `bool enter(const flat_ast &, node_id)` (return false to skip the node's subtree), and optionally
+// `void leave(const flat_ast &, node_id)` (only for nodes that weren't skipped); no recursion, so any depth is fine
+template <typename V>
+void visit(const flat_ast &tree, V &&visitor, const node_id root = 0) {
+  if(root >= tree.size()) return;
+  std::vector<node_id> open; // ancestors still waiting for leave
+  node_id at = root;
+  const node_id end = tree.subtree_end[root];
+  while(at < end) {
+    if constexpr(requires { visitor.leave(tree, at); }) {
+      while(!open.empty() && tree.subtree_end[open.back()] <= at) {
+        visitor.leave(tree, open.back());
+        open.pop_back();
+      }
+    }
+
+    if(visitor.enter(tree, at)) {
+      if constexpr(requires { visitor.leave(tree, at); }) open.push_back(at);
+      at++;
+    }
+    else at = tree.subtree_end[at];
+  }
+
+  if constexpr(requires { visitor.leave(tree, at); }) {
+    while(!open.empty()) {
+      visitor.leave(tree, open.back());
+      open.pop_back();
+    }
+  }
+}
+
+// calls f(id) on every node of the given kind, in pre-order; a straight scan over the kind array
+template <typename F>
+void for_each_of(const flat_ast &tree, const node_kind k, F &&f) {
+  for(node_id id = 0; id < tree.size(); id++) {
+    if(tree.kind[id] == k) f(id);
+  }
+}
+}
+
+#endif //FLAT_AST_HPP
@@ -0,0 +1,183 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "parallel_parser.hpp"
+#include "parser.hpp"
+
+using namespace jaydk;
+using namespace jayc;
+using namespace jayc::lexer;
+using namespace jayc::parser;
+
+namespace {
+// a declaration found by the pre-scan; namespaces are split further, everything else is parsed as a whole
+struct item {
+  size_t begin; //!< Index of the declaration's first token (its keyword)
+  size_t end; //!< Index one past its last token
+  bool is_namespace = false;
+  std::vector<item> nested{};
+};
+
+struct parsed {
+  std::optional<declaration> decl{};
+  std::vector<error_queue::message> messages{};
+  bool clean = false;
+};
+
+bool is_symbol(const token &t, const symbol s) { return is<symbol>(t) && as<symbol>(t) == s; }
+
+// a declaration ends at the first `;` outside brackets, or at the `}` closing its first outermost `{`
+std::optional<size_t> find_end(const std::vector<token> &tokens, const size_t begin) {
+  size_t depth = 0;
+  for(size_t i = begin + 1; i < tokens.size(); i++) {
+    const auto &t = tokens[i];
+    if(is<eof>(t)) return std::nullopt;
+    if(!is<symbol>(t)) continue;
+
+    switch(as<symbol>(t)) {
+      case symbol::PAREN_OPEN: case symbol::BRACKET_OPEN: case symbol::BRACE_OPEN:
+        depth++;
+        break;
+      case symbol::PAREN_CLOSE: case symbol::BRACKET_CLOSE: case symbol::BRACE_CLOSE:
+        if(depth == 0) return std::nullopt;
+        if(--depth == 0 && as<symbol>(t) == symbol::BRACE_CLOSE) return i + 1;
+        break;
+      case symbol::SEMI:
+        if(depth == 0) return i + 1;
+        break;
+      default:
+        break;
+    }
+  }
+  return std::nullopt;
+}
+
+// scans declarations up to the eof token (top level) or the closing brace of the namespace; returns its index
+std::optional<size_t> scan(const std::vector<token> &tokens, size_t at, std::vector<item> &out, const bool top_level) {
+  while(true) {
+    const auto &t = tokens[at];
+    if(is<eof>(t)) return top_level ? std::optional{at} : std::nullopt;
+    if(is_symbol(t, symbol::BRACE_CLOSE)) return top_level ? std::nullopt : std::optional{at};
+    if(!is<keyword>(t)) return std::nullopt;
+
+    if(as<keyword>(t) == keyword::NAMESPACE) {
+      // namespace <identifier> { <declarations> }
+      if(at + 2 >= tokens.size() || !is<identifier>(tokens[at + 1]) || !is_symbol(tokens[at + 2], symbol::BRACE_OPEN))
+        return std::nullopt;
+      item ns{ at, 0, true };
+      const auto close = scan(tokens, at + 3, ns.nested, false);
+      if(!close.has_value()) return std::nullopt;
+      ns.end = *close + 1;
+      at = ns.end;
+      out.push_back(std::move(ns));
+    }
+    else {
+      const auto end = find_end(tokens, at);
+      if(!end.has_value()) return std::nullopt;
+      out.push_back(item{ at, *end });
+      at = *end;
+    }
+  }
+}
+
+void collect_leaves(const std::vector<item> &items, std::vector<const item *> &out) {
+  for(const auto &i : items) {
+    if(i.is_namespace) collect_leaves(i.nested, out);
+    else out.push_back(&i);
+  }
+}
+
+// parses one declaration on its own; clean if it consumed exactly its tokens without errors
+void parse_leaf(const std::vector<token> &tokens, const item &leaf, const std::shared_ptr<arena> &nodes, parsed &out) {
+  const error_queue::capture guard{out.messages};
+  std::vector<token> slice(tokens.begin() + static_cast<ptrdiff_t>(leaf.begin),
+                           tokens.begin() + static_cast<ptrdiff_t>(leaf.end));
+  slice.push_back(token{ eof{}, tokens[leaf.end].pos });
+
+  auto it = token_it(std::move(slice), nodes);
+  out.decl = parse_decl(it);
+  out.clean = out.decl.has_value() && it.eof() &&
+    std::ranges::none_of(out.messages, [](const error_queue::message &m) { return is<error>(m); });
+}
+
+void assemble(
+  const std::vector<token> &tokens, const std::vector<item> &items, std::vector<parsed> &leaves, size_t &next,
+  arena_vector<declaration> &out
+) {
+  for(const auto &i : items) {
+    if(!i.is_namespace) {
+      out.push_back(std::move(*leaves[next++].decl));
+      continue;
+    }
+
+    namespace_decl ns{ .name = as<identifier>(tokens[i.begin + 1]).ident, .declarations = {} };
+    assemble(tokens, i.nested, leaves, next, ns.declarations);
+    out.push_back(declaration(std::move(ns), tokens[i.begin].pos));
+    trace(trace_category::PARSER, trace_event::DECLARATION_PARSED, tokens[i.begin].pos,
+      static_cast<uint32_t>(out.back().content.index()));
+  }
+}
+}
+
+ast jayc::parser::build_ast_parallel(std::vector<token> tokens, size_t threads) {
+  if(tokens.empty() || !is<eof>(tokens.back())) tokens.push_back(token{eof{}});
+  if(threads == 0) {
+    threads = tokens.size() < min_parallel_tokens ? 1 : std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<item> items;
+  if(threads <= 1 || !scan(tokens, 0, items, true).has_value()) {
+    auto it = token_it(std::move(tokens));
+    return build_ast(it);
+  }
+
+  std::vector<const item *> leaves;
+  collect_leaves(items, leaves);
+  threads = std::clamp<size_t>(leaves.size(), 1, threads);
+
+  // one arena per thread; declared before the parsed declarations, so it outlives them
+  std::vector<std::shared_ptr<arena>> arenas;
+  for(size_t i = 0; i < threads; i++) arenas.push_back(std::make_shared<arena>());
+  std::vector<parsed> results(leaves.size());
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+
+  const auto work = [&](const std::shared_ptr<arena> &nodes) {
+    try {
+      for(size_t i = next++; i < leaves.size() && !failed; i = next++) {
+        parse_leaf(tokens, *leaves[i], nodes, results[i]);
+        if(!results[i].clean) failed = true;
+      }
+    }
+    catch(...) {
+      failed = true; // the sequential parse reports (or rethrows) whatever went wrong
+    }
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+    for(size_t i = 1; i < threads; i++) workers.emplace_back([&work, &arenas, i] { work(arenas[i]); });
+    work(arenas[0]);
+  }
+
+  if(failed) {
+    results.clear();
+    auto it = token_it(std::move(tokens));
+    return build_ast(it);
+  }
+
+  for(const auto &r : results) logger.replay(r.messages);
+
+  const arena::scope nodes{*arenas[0]};
+  ast result{ ast_storage{ arenas[0], { arenas.begin() + 1, arenas.end() } }, namespace_decl{} };
+  result.name = "";
+  size_t at = 0;
+  assemble(tokens, items, results, at, result.declarations);
+  return result;
+}
@@ -0,0 +1,26 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef PARALLEL_PARSER_HPP
+#define PARALLEL_PARSER_HPP
+
+#include <vector>
+
+#include "lexer/token_stream.hpp"
+#include "ast.hpp"
+
+namespace jayc::parser {
+// below this many tokens, splitting costs more than it gains
+constexpr size_t min_parallel_tokens = 16 * 1024;
+
+// parses a module on several threads: a brace-matching pre-scan splits the tokens into top-level and namespace-level
+// declarations, which are parsed concurrently (each thread takes the next unparsed declaration) and merged in
+// source order; their diagnostics are reported in source order as well
+// if any declaration doesn't parse cleanly on its own, the module is parsed again sequentially, so the result (ast and
+// diagnostics) is always the one build_ast gives
+// threads = 0 -> one per hardware thread, but sequential below min_parallel_tokens
+ast build_ast_parallel(std::vector<lexer::token> tokens, size_t threads = 0);
+}
+
+#endif //PARALLEL_PARSER_HPP
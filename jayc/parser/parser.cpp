@@ -14,18 +14,19 @@ using namespace jayc::parser;
 // no need to check for EOF -> we use an EOF token (so any token-check will fail, return std::nullopt and bubble up)
 
 std::optional<name> jayc::parser::parse_full_name(token_it &iterator, bool allow_brackets) {
+  const arena::scope nodes{*iterator.nodes()};
   // name: identifier(<name(, name)*>)? (::name_no_brack)? ([])?
   const auto ident = *iterator;
   iterator.consume();
-  if(!is<identifier>(ident.actual)) {
+  if(!is<identifier>(ident)) {
     logger << expect_identifier(ident);
     return std::nullopt;
   }
 
-  std::vector<name> template_args;
+  arena_vector<name> template_args;
   if(
-    is<symbol>(iterator->actual) && as<symbol>(iterator->actual) == symbol::LESS_THAN && // start of template args
-    is<identifier>(iterator.peek().actual) // don't confuse with operator
+    is<symbol>(*iterator) && as<symbol>(*iterator) == symbol::LESS_THAN && // start of template args
+    is<identifier>(iterator.peek()) // don't confuse with operator
   ) {
     iterator.consume(); // consume <
     while(!iterator.eof()) {
@@ -38,12 +39,12 @@ std::optional<name> jayc::parser::parse_full_name(token_it &iterator, bool allow
 
       auto token = *iterator;
       iterator.consume(); // consume , or >
-      if(is<symbol>(token.actual)) {
-        if(as<symbol>(token.actual) == symbol::GREATER_THAN) {
+      if(is<symbol>(token)) {
+        if(as<symbol>(token) == symbol::GREATER_THAN) {
           break;
         }
 
-        if(as<symbol>(token.actual) != symbol::COMMA) {
+        if(as<symbol>(token) != symbol::COMMA) {
           logger << expect("comma (`,`) or closing bracket (`>`)", token);
           return std::nullopt;
         }
@@ -55,8 +56,8 @@ std::optional<name> jayc::parser::parse_full_name(token_it &iterator, bool allow
     }
   }
 
-  heap_opt<name> next = std::nullopt;
-  if(is<symbol>(iterator->actual) && as<symbol>(iterator->actual) == symbol::NAMESPACE) {
+  arena_opt<name> next = std::nullopt;
+  if(is<symbol>(*iterator) && as<symbol>(*iterator) == symbol::NAMESPACE) {
     iterator.consume(); // consume ::
     auto next_name = parse_full_name(iterator, allow_brackets); // pass on bracket condition to last segment
     if(!next_name.has_value()) {
@@ -69,11 +70,11 @@ std::optional<name> jayc::parser::parse_full_name(token_it &iterator, bool allow
   bool is_array = false;
   if(allow_brackets && next == std::nullopt) {
     // only allow brackets if explicitly allowed, and only if this is the last segment
-    if(is<symbol>(iterator->actual) && as<symbol>(iterator->actual) == symbol::BRACKET_OPEN) {
+    if(is<symbol>(*iterator) && as<symbol>(*iterator) == symbol::BRACKET_OPEN) {
       iterator.consume(); // consume [
       auto token = *iterator;
       iterator.consume(); // consume ]
-      if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::BRACKET_CLOSE) {
+      if(!is<symbol>(token) || as<symbol>(token) != symbol::BRACKET_CLOSE) {
         logger << expect("closing bracket (`]`)", token);
         return std::nullopt;
       }
@@ -82,7 +83,7 @@ std::optional<name> jayc::parser::parse_full_name(token_it &iterator, bool allow
   }
 
   return name{
-    .section = as<identifier>(ident.actual).ident,
+    .section = as<identifier>(ident).ident,
     .template_args = std::move(template_args),
     .next = std::move(next),
     .is_array = is_array
@@ -95,19 +96,26 @@ struct expr_pratt {
 
   template <typename T>
   std::optional<expression> lit_expr_helper(const token &t) {
-    if(is<literal<T>>(t.actual)) return expression(literal_expr<T>(as<literal<T>>(t.actual).value), t.pos);
-    return std::nullopt;
+    if(!is<literal<T>>(t)) return std::nullopt;
+    if constexpr(std::same_as<T, std::string_view>) {
+      // the token's text may not outlive the module, so the literal gets its own copy
+      return expression(literal_expr<T>{ arena::current_or_fallback().copy(as<literal<T>>(t).value) }, t.pos);
+    }
+    else return expression(literal_expr<T>{ as<literal<T>>(t).value }, t.pos);
   }
 
   std::optional<expression> literal_to_expr(const token &t) {
     return lit_expr_helper<int64_t>(t) || lit_expr_helper<uint64_t>(t) || lit_expr_helper<float>(t) ||
-           lit_expr_helper<double>(t) || lit_expr_helper<char>(t) || lit_expr_helper<std::string>(t) ||
+           lit_expr_helper<double>(t) || lit_expr_helper<char>(t) || lit_expr_helper<std::string_view>(t) ||
            lit_expr_helper<bool>(t);
   }
 
-  constexpr static uint8_t precedence_for(const token_t &t) {
-    if(!is<symbol>(t)) return 0;
-    switch(as<symbol>(t)) {
+  constexpr static uint8_t precedence_for(const token &t) {
+    return is<symbol>(t) ? precedence_for(as<symbol>(t)) : 0;
+  }
+
+  constexpr static uint8_t precedence_for(const symbol s) {
+    switch(s) {
       using enum symbol;
       case INCREMENT:
       case DECREMENT:
@@ -173,9 +181,8 @@ struct expr_pratt {
     }
   }
 
-  constexpr static uint8_t assoc_penalty(const token_t &t) {
-    if(!is<symbol>(t)) return 0;
-    switch(as<symbol>(t)) {
+  constexpr static uint8_t assoc_penalty(const symbol s) {
+    switch(s) {
       using enum symbol;
       case ASSIGN:
       case PLUS_ASSIGN:
@@ -264,26 +271,28 @@ struct expr_pratt {
       auto res = parse(0); // precedence 0 -> stop on ) or invalid token
       auto token = *iterator;
       iterator.consume();
-      if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
+      if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
         logger << expect("closing parenthesis (`)`)", token);
         return std::nullopt;
       }
       return res;
     }
 
-    return merge(parse(precedence_for(s)), un_op_for(s)) | [&loc](const std::pair<expression, unary_op> &pair) {
-      return expression(unary_expr{ .op = pair.second, .expr = alloc(pair.first) }, loc);
-    };
+    auto operand = parse(precedence_for(s));
+    const auto op = un_op_for(s);
+    if(!operand.has_value() || !op.has_value()) return std::nullopt;
+    return expression(unary_expr{ .op = *op, .expr = arena_alloc(std::move(*operand)) }, loc);
   }
 
-  std::optional<expression> parse_infix(const expression &left, const symbol s, const location &loc) {
+  // takes ownership of left; the subtree built so far is moved into the new node, never copied
+  std::optional<expression> parse_infix(expression &&left, const symbol s, const location &loc) {
     token token;
     switch(s) {
       case symbol::PAREN_OPEN: {
         // special case #1 -> functor call
-        std::vector<expression> args;
+        arena_vector<expression> args;
 
-        if(!is<symbol>(iterator->actual) || as<symbol>(iterator->actual) != symbol::PAREN_CLOSE) {
+        if(!is<symbol>(*iterator) || as<symbol>(*iterator) != symbol::PAREN_CLOSE) {
           while(!iterator.eof()) {
             auto arg = parse(0); // precedence 0 -> stop on non-operator
             if(!arg.has_value()) return std::nullopt;
@@ -291,9 +300,9 @@ struct expr_pratt {
 
             token = *iterator;
             iterator.consume();
-            if(is<symbol>(token.actual)) {
-              if(as<symbol>(token.actual) == symbol::PAREN_CLOSE) break;
-              if(as<symbol>(token.actual) != symbol::COMMA) {
+            if(is<symbol>(token)) {
+              if(as<symbol>(token) == symbol::PAREN_CLOSE) break;
+              if(as<symbol>(token) != symbol::COMMA) {
                 logger << expect("comma (`,`) or closing parenthesis (`)`)", token);
                 return std::nullopt;
               }
@@ -308,7 +317,7 @@ struct expr_pratt {
           iterator.consume();
         }
 
-        return expression(call_expr{ .call = alloc(left), .args = std::move(args) }, loc);
+        return expression(call_expr{ .call = arena_alloc(std::move(left)), .args = std::move(args) }, loc);
       }
 
       case symbol::BRACKET_OPEN: {
@@ -318,44 +327,44 @@ struct expr_pratt {
 
         token = *iterator;
         iterator.consume();
-        if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::BRACKET_CLOSE) {
+        if(!is<symbol>(token) || as<symbol>(token) != symbol::BRACKET_CLOSE) {
           logger << expect("closing bracket (`]`) after array index", token);
           return std::nullopt;
         }
 
-        return expression(index_expr{ .base = alloc(left), .index = alloc(*idx) }, loc);
+        return expression(index_expr{ .base = arena_alloc(std::move(left)), .index = arena_alloc(std::move(*idx)) }, loc);
       }
 
       case symbol::DOT: {
         // special case #3 -> member access
         token = *iterator;
         iterator.consume();
-        if(!is<identifier>(token.actual)) {
-          logger << expect_identifier({token.actual, token.pos});
+        if(!is<identifier>(token)) {
+          logger << expect_identifier(token);
           return std::nullopt;
         }
-        return expression(member_expr{ .base = alloc(left), .member = as<identifier>(token.actual).ident }, loc);
+        return expression(member_expr{ .base = arena_alloc(std::move(left)), .member = as<identifier>(token).ident }, loc);
       }
 
       case symbol::QUESTION: {
-        const auto b_true = parse(0);
+        auto b_true = parse(0);
         if(!b_true.has_value()) return std::nullopt;
         token = *iterator;
         iterator.consume();
-        if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::COLON) {
+        if(!is<symbol>(token) || as<symbol>(token) != symbol::COLON) {
           logger << expect("colon (`:`)", token);
           return std::nullopt;
         }
 
-        const auto b_false = parse(0);
+        auto b_false = parse(0);
         if(!b_false.has_value()) return std::nullopt;
-        return expression(ternary_expr{ .cond = alloc(left), .true_expr = alloc(*b_true), .false_expr = alloc(*b_false) }, loc);
+        return expression(ternary_expr{ .cond = arena_alloc(std::move(left)), .true_expr = arena_alloc(std::move(*b_true)), .false_expr = arena_alloc(std::move(*b_false)) }, loc);
       }
 
       case symbol::INCREMENT:
       case symbol::DECREMENT: {
         // special case #4 -> postfix operators
-        return expression(unary_expr{ .op = s == symbol::INCREMENT ? unary_op::POST_INCR : unary_op::POST_DECR, .expr = alloc(left) }, loc);
+        return expression(unary_expr{ .op = s == symbol::INCREMENT ? unary_op::POST_INCR : unary_op::POST_DECR, .expr = arena_alloc(std::move(left)) }, loc);
       }
 
       case symbol::MULTIPLY:
@@ -385,10 +394,10 @@ struct expr_pratt {
       case symbol::BIT_AND_ASSIGN:
       case symbol::BIT_OR_ASSIGN:
       case symbol::XOR_ASSIGN: {
-        return merge(parse(precedence_for(s) - assoc_penalty(s)), bin_op_for(s)) |
-          [&loc, &left](const std::pair<expression, binary_op> &pair) {
-            return expression(binary_expr{ .op = pair.second, .left = alloc(left), .right = alloc(pair.first) }, loc);
-          };
+        auto right = parse(precedence_for(s) - assoc_penalty(s));
+        const auto op = bin_op_for(s);
+        if(!right.has_value() || !op.has_value()) return std::nullopt;
+        return expression(binary_expr{ .op = *op, .left = arena_alloc(std::move(left)), .right = arena_alloc(std::move(*right)) }, loc);
       }
 
       default: {
@@ -406,7 +415,7 @@ struct expr_pratt {
       iterator.consume();
     }
     if(!left.has_value()) {
-      if(is<identifier>(token.actual)) {
+      if(is<identifier>(token)) {
         auto qname = parse_qualified_name(iterator); // we need a (variable) name, not a type name
         if(!qname.has_value()) {
           logger << expect("qualified name", token);
@@ -414,9 +423,9 @@ struct expr_pratt {
         }
         left = expression(name_expr{ std::move(*qname) }, token.pos);
       }
-      else if(is<symbol>(token.actual) && is_prefix(as<symbol>(token.actual))) {
+      else if(is<symbol>(token) && is_prefix(as<symbol>(token))) {
         iterator.consume();
-        left = parse_prefix(as<symbol>(token.actual), token.pos);
+        left = parse_prefix(as<symbol>(token), token.pos);
       }
     }
 
@@ -427,11 +436,11 @@ struct expr_pratt {
     }
 
     token = *iterator;
-    while(precedence_for(token.actual) > precedence) {
-      if(!is<symbol>(token.actual)) break; // TODO: check if is error?
+    while(precedence_for(token) > precedence) {
+      if(!is<symbol>(token)) break; // TODO: check if is error?
       iterator.consume();
 
-      left = parse_infix(*left, as<symbol>(token.actual), token.pos);
+      left = parse_infix(std::move(*left), as<symbol>(token), token.pos);
       if(!left.has_value()) return std::nullopt;
 
       token = *iterator;
@@ -465,20 +474,21 @@ struct expr_pratt {
 using namespace expr_parsers;
 
 std::optional<expression> jayc::parser::parse_expr(token_it &iterator) {
+  const arena::scope nodes{*iterator.nodes()};
   expr_pratt local{ iterator };
   return local.parse(0);
 }
 
 namespace stmt_parsers {
 template <typename T>
-std::optional<T> check_semi(token_it &iterator, const T &t, bool consume_first = false) {
+std::optional<T> check_semi(token_it &iterator, T &&t, bool consume_first = false) {
   if(consume_first) iterator.consume();
-  const auto [a, p] = *iterator;
+  const auto a = *iterator;
   iterator.consume();
   if(is<symbol>(a) && as<symbol>(a) == symbol::SEMI) {
-    return t;
+    return std::move(t);
   }
-  logger << expect("semicolon (`;`)", {a, p});
+  logger << expect("semicolon (`;`)", a);
   return std::nullopt;
 }
 
@@ -499,16 +509,16 @@ constexpr std::optional<binary_op> compound_assign_op_for(const symbol s) {
 
 std::optional<statement> parse_initial_expr_stmt(token_it &iterator) {
   const auto pos = iterator->pos;
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(expr == std::nullopt) return std::nullopt;
 
-  if(!is<symbol>(iterator->actual) || as<symbol>(iterator->actual) != symbol::SEMI) {
+  if(!is<symbol>(*iterator) || as<symbol>(*iterator) != symbol::SEMI) {
     logger << expect("semicolon (`;`)", *iterator);
     iterator.consume();
     return std::nullopt;
   }
   iterator.consume(); // consume ;
-  return statement(expr_stmt{ .expr = *expr }, pos);
+  return statement(expr_stmt{ .expr = std::move(*expr) }, pos);
 }
 
 std::optional<statement> parse_var_decl_stmt(token_it &iterator, bool is_mutable) {
@@ -518,15 +528,15 @@ std::optional<statement> parse_var_decl_stmt(token_it &iterator, bool is_mutable
 
   auto token = *iterator;
   iterator.consume(); // consume <ident>
-  if(!is<identifier>(token.actual)) {
+  if(!is<identifier>(token)) {
     logger << expect_identifier(token);
     return std::nullopt;
   }
-  const std::string name = as<identifier>(token.actual).ident;
+  const interned name = as<identifier>(token).ident;
 
   std::optional<::name> type = std::nullopt;
   token = *iterator;
-  if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::COLON) {
+  if(is<symbol>(token) && as<symbol>(token) == symbol::COLON) {
     iterator.consume(); // consume :
     type = parse_type_name(iterator);
     if(type == std::nullopt) return std::nullopt;
@@ -534,23 +544,23 @@ std::optional<statement> parse_var_decl_stmt(token_it &iterator, bool is_mutable
 
   token = *iterator;
   iterator.consume(); // consume =
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::ASSIGN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::ASSIGN) {
     logger << expect("assignment (`=`)", token);
     iterator.consume();
     return std::nullopt;
   }
 
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(expr == std::nullopt) return std::nullopt;
 
   token = *iterator;
   iterator.consume(); // consume ;
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::SEMI) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::SEMI) {
     logger << expect("semicolon (`;`)", token);
     return std::nullopt;
   }
   return statement(
-    var_decl_stmt{ .var_name = name, .type_name = type, .value = *expr, .is_mutable = is_mutable },
+    var_decl_stmt{ .var_name = name, .type_name = std::move(type), .value = std::move(*expr), .is_mutable = is_mutable },
     pos
   );
 }
@@ -562,36 +572,36 @@ std::optional<statement> parse_if_stmt(token_it &iterator) {
 
   auto token = *iterator;
   iterator.consume(); // consume (
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_OPEN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_OPEN) {
     logger << expect("opening parenthesis (`(`)", token);
     return std::nullopt;
   }
 
-  const auto cond = parse_expr(iterator);
+  auto cond = parse_expr(iterator);
   if(cond == std::nullopt) return std::nullopt;
 
   token = *iterator;
   iterator.consume(); // consume )
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
     logger << expect("closing parenthesis (`)`)", token);
     return std::nullopt;
   }
 
-  const auto true_stmt = parse_stmt(iterator);
+  auto true_stmt = parse_stmt(iterator);
   if(true_stmt == std::nullopt) return std::nullopt;
 
-  if_stmt res{ .condition = *cond, .true_block = alloc(*true_stmt), .false_block = std::nullopt };
+  if_stmt res{ .condition = std::move(*cond), .true_block = arena_alloc(std::move(*true_stmt)), .false_block = std::nullopt };
 
   token = *iterator;
-  if(is<keyword>(token.actual) && as<keyword>(token.actual) == keyword::ELSE) {
+  if(is<keyword>(token) && as<keyword>(token) == keyword::ELSE) {
     iterator.consume(); // consume else
 
-    const auto false_stmt = parse_stmt(iterator);
+    auto false_stmt = parse_stmt(iterator);
     if(false_stmt == std::nullopt) return std::nullopt;
-    res.false_block = alloc(*false_stmt);
+    res.false_block = arena_alloc(std::move(*false_stmt));
   }
 
-  return statement(res, pos);
+  return statement(std::move(res), pos);
 }
 
 std::optional<statement> parse_for_stmt(token_it &iterator) {
@@ -603,69 +613,69 @@ std::optional<statement> parse_for_stmt(token_it &iterator) {
 
   auto token = *iterator;
   iterator.consume(); // consume (
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_OPEN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_OPEN) {
     logger << expect("opening parenthesis (`(`)", token);
     return std::nullopt;
   }
 
-  if(const auto [actual, _] = iterator.peek(); is<symbol>(actual) && as<symbol>(actual) == symbol::COLON) {
+  if(const auto actual = iterator.peek(); is<symbol>(actual) && as<symbol>(actual) == symbol::COLON) {
     // case 2: for (<ident> : <expr>) <body>
     token = *iterator;
     iterator.consume(); // consume <ident>
-    if(!is<identifier>(token.actual)) {
+    if(!is<identifier>(token)) {
       logger << expect_identifier(token);
       return std::nullopt;
     }
 
-    const std::string name = as<identifier>(token.actual).ident;
+    const interned name = as<identifier>(token).ident;
 
     iterator.consume(); // consume : (checked)
 
-    const auto expr = parse_expr(iterator);
+    auto expr = parse_expr(iterator);
     if(expr == std::nullopt) return std::nullopt;
 
     token = *iterator;
-    if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
+    if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
       logger << expect("closing parenthesis (`)`)", token);
       return std::nullopt;
     }
     iterator.consume();
 
-    const auto body = parse_stmt(iterator);
+    auto body = parse_stmt(iterator);
     if(body == std::nullopt) return std::nullopt;
 
-    return statement(for_each_stmt{ .binding = name, .collection = *expr, .block = alloc(*body) }, pos);
+    return statement(for_each_stmt{ .binding = name, .collection = std::move(*expr), .block = arena_alloc(std::move(*body)) }, pos);
   }
 
   // case 1: for (<stmt (;) included> <expr>; <expr>) <body>
-  const auto stmt = parse_stmt(iterator);
+  auto stmt = parse_stmt(iterator);
   if(stmt == std::nullopt) return std::nullopt;
 
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(expr == std::nullopt) return std::nullopt;
 
   token = *iterator;
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::SEMI) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::SEMI) {
     logger << expect("semicolon (`;`)", token);
     return std::nullopt;
   }
 
   iterator.consume(); // consume ;
 
-  const auto upd = parse_expr(iterator);
+  auto upd = parse_expr(iterator);
   if(upd == std::nullopt) return std::nullopt;
 
   token = *iterator;
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
     logger << expect("closing parenthesis (`)`)", token);
     return std::nullopt;
   }
   iterator.consume();
 
-  const auto body = parse_stmt(iterator);
+  auto body = parse_stmt(iterator);
   if(body == std::nullopt) return std::nullopt;
 
-  return statement(for_stmt{ .init = alloc(*stmt), .condition = *expr, .update = *upd, .block = alloc(*body) }, pos);
+  return statement(for_stmt{ .init = arena_alloc(std::move(*stmt)), .condition = std::move(*expr), .update = std::move(*upd), .block = arena_alloc(std::move(*body)) }, pos);
 }
 
 std::optional<statement> parse_while_stmt(token_it &iterator) {
@@ -675,17 +685,17 @@ std::optional<statement> parse_while_stmt(token_it &iterator) {
 
   auto token = *iterator;
   iterator.consume(); // consume (
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_OPEN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_OPEN) {
     logger << expect("opening parenthesis (`(`)", token);
     return std::nullopt;
   }
 
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(expr == std::nullopt) return std::nullopt;
 
   token = *iterator;
   iterator.consume(); // consume )
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
     logger << expect("closing parenthesis (`)`)", token);
     return std::nullopt;
   }
@@ -693,7 +703,7 @@ std::optional<statement> parse_while_stmt(token_it &iterator) {
   auto body = parse_stmt(iterator);
   if(body == std::nullopt) return std::nullopt;
 
-  return statement(while_stmt{ .is_do_while = false, .condition = *expr, .block = alloc(*body) }, pos);
+  return statement(while_stmt{ .is_do_while = false, .condition = std::move(*expr), .block = arena_alloc(std::move(*body)) }, pos);
 }
 
 std::optional<statement> parse_do_while_stmt(token_it &iterator) {
@@ -708,82 +718,84 @@ std::optional<statement> parse_do_while_stmt(token_it &iterator) {
 
   token = *iterator;
   iterator.consume(); // consume while
-  if(!is<keyword>(token.actual) || as<keyword>(token.actual) != keyword::WHILE) {
+  if(!is<keyword>(token) || as<keyword>(token) != keyword::WHILE) {
     logger << expect("while", token);
     return std::nullopt;
   }
 
   token = *iterator;
   iterator.consume(); // consume (
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_OPEN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_OPEN) {
     logger << expect("opening parenthesis (`(`)", token);
     return std::nullopt;
   }
 
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(expr == std::nullopt) return std::nullopt;
 
   token = *iterator;
   iterator.consume(); // consume )
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
     logger << expect("closing parenthesis (`)`)", token);
     return std::nullopt;
   }
 
   token = *iterator;
   iterator.consume(); // consume ;
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::SEMI) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::SEMI) {
     logger << expect("semicolon (`;`)", token);
     return std::nullopt;
   }
 
-  return statement(while_stmt{ .is_do_while = true, .condition = *expr, .block = alloc(*body) }, pos);
+  return statement(while_stmt{ .is_do_while = true, .condition = std::move(*expr), .block = arena_alloc(std::move(*body)) }, pos);
 }
 
 std::optional<statement> parse_return_stmt(token_it &iterator) {
   // return <expr>?;
   const auto pos = iterator->pos;
   iterator.consume(); // consume return
-  if(is<symbol>(iterator->actual) && as<symbol>(iterator->actual) == symbol::SEMI) {
+  if(is<symbol>(*iterator) && as<symbol>(*iterator) == symbol::SEMI) {
     iterator.consume(); // consume ;
     return statement(return_stmt{ .value = std::nullopt }, pos);
   }
 
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(!expr.has_value()) {
     return std::nullopt;
   }
-  return check_semi(iterator, statement(return_stmt{ .value = expr }, pos));
+  return check_semi(iterator, statement(return_stmt{ .value = std::move(*expr) }, pos));
 }
 
 std::optional<statement> parse_block_stmt(token_it &iterator) {
   // { <body> }
-  const auto &[_, pos] = *iterator;
+  const auto pos = iterator->pos;
   iterator.consume(); // consume {
-  std::vector<statement> body;
-  while(!is<symbol>(iterator->actual) || as<symbol>(iterator->actual) != symbol::BRACE_CLOSE) {
-    const auto next = parse_stmt(iterator);
+  arena_vector<statement> body;
+  while(!is<symbol>(*iterator) || as<symbol>(*iterator) != symbol::BRACE_CLOSE) {
+    auto next = parse_stmt(iterator);
     if(!next.has_value()) {
       return std::nullopt;
     }
 
-    body.push_back(*next);
+    body.push_back(std::move(*next));
   }
 
   iterator.consume(); // consume }
-  return statement(block{ .statements = body }, pos);
+  return statement(block{ .statements = std::move(body) }, pos);
 }
 }
 
 using namespace stmt_parsers;
 
 std::optional<statement> jayc::parser::parse_stmt(token_it &iterator) {
+  const arena::scope nodes{*iterator.nodes()};
   // ignore empty statements
-  while(is<symbol>(iterator->actual) && as<symbol>(iterator->actual) == symbol::SEMI) {
+  while(is<symbol>(*iterator) && as<symbol>(*iterator) == symbol::SEMI) {
     iterator.consume();
   }
 
-  const auto [actual, pos] = *iterator;
+  const auto actual = *iterator;
+  const auto pos = actual.pos;
   if(is<symbol>(actual) && as<symbol>(actual) == symbol::BRACE_OPEN)
     return parse_block_stmt(iterator);
 
@@ -816,26 +828,26 @@ std::optional<statement> jayc::parser::parse_stmt(token_it &iterator) {
 }
 
 namespace decl_parsers {
-std::optional<std::vector<template_function_decl::template_arg>> parse_template_args(token_it &iterator) {
+std::optional<arena_vector<template_function_decl::template_arg>> parse_template_args(token_it &iterator) {
   // <identifier (: name (& name)*)?(, identifier (: name (&name)*)*)>
   iterator.consume(); // consume <
-  std::vector<template_function_decl::template_arg> template_args;
+  arena_vector<template_function_decl::template_arg> template_args;
 
   token token{};
   while(!iterator.eof()) {
     token = *iterator;
     iterator.consume();
 
-    if(!is<identifier>(token.actual)) {
+    if(!is<identifier>(token)) {
       logger << expect("identifier", token);
       return std::nullopt;
     }
-    auto name = as<identifier>(token.actual).ident;
+    const auto arg_name = as<identifier>(token).ident;
+    arena_small_vector<::name, 1> constraints;
 
     token = *iterator;
-    if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::COLON) {
+    if(is<symbol>(token) && as<symbol>(token) == symbol::COLON) {
       iterator.consume(); // consume :
-      std::vector<::name> constraints;
 
       while(!iterator.eof()) {
         auto constraint = parse_type_name(iterator); // type name
@@ -843,8 +855,8 @@ std::optional<std::vector<template_function_decl::template_arg>> parse_template_
         constraints.push_back(std::move(*constraint));
 
         token = *iterator;
-        if(is<symbol>(token.actual)) {
-          const auto sym = as<symbol>(token.actual);
+        if(is<symbol>(token)) {
+          const auto sym = as<symbol>(token);
           if(sym == symbol::COMMA) break;
           if(sym == symbol::GREATER_THAN) break;
           iterator.consume();
@@ -859,38 +871,70 @@ std::optional<std::vector<template_function_decl::template_arg>> parse_template_
           return std::nullopt;
         }
       }
+    }
 
-      token = *iterator;
-      iterator.consume();
-      if(is<symbol>(token.actual)) {
-        if(as<symbol>(token.actual) == symbol::GREATER_THAN) break;
-        if(as<symbol>(token.actual) != symbol::COMMA) {
-          logger << expect("comma (`,`) or closing angle bracket (`>`)", token);
-          return std::nullopt;
-        }
-      }
-      else {
+    template_args.push_back({ .arg_name = arg_name, .constraints = std::move(constraints) });
+
+    token = *iterator;
+    iterator.consume();
+    if(is<symbol>(token)) {
+      if(as<symbol>(token) == symbol::GREATER_THAN) break;
+      if(as<symbol>(token) != symbol::COMMA) {
         logger << expect("comma (`,`) or closing angle bracket (`>`)", token);
         return std::nullopt;
       }
     }
+    else {
+      logger << expect("comma (`,`) or closing angle bracket (`>`)", token);
+      return std::nullopt;
+    }
   }
 
   return template_args;
 }
 
+// the { is already consumed; brace-matches up to (and consumes) the closing }, keeping the tokens in between for later
+function_body::deferred *defer_body(token_it &iterator) {
+  thread_local std::vector<token> tokens;
+  tokens.clear();
+  size_t depth = 0;
+  while(true) {
+    const auto t = *iterator;
+    if(is<eof>(t)) {
+      logger << expect("closing brace (`}`)", t);
+      return nullptr;
+    }
+    iterator.consume();
+
+    if(is<symbol>(t) && as<symbol>(t) == symbol::BRACE_OPEN) depth++;
+    else if(is<symbol>(t) && as<symbol>(t) == symbol::BRACE_CLOSE) {
+      if(depth == 0) {
+        tokens.push_back(token{eof{}, t.pos});
+        break;
+      }
+      depth--;
+    }
+    tokens.push_back(t);
+  }
+
+  auto &nodes = *iterator.nodes();
+  auto *copy = static_cast<token *>(nodes.allocate(sizeof(token) * tokens.size(), alignof(token)));
+  std::ranges::copy(tokens, copy);
+  return nodes.make<function_body::deferred>(std::span<const token>{ copy, tokens.size() }, &nodes);
+}
+
 std::optional<declaration> parse_fun_decl(token_it &iterator) {
   // fun
   //    (<identifier (:name (& name)*)?(, identifier (:name (&name)*)*)>)?
   //    (name.)?identifier((identifier: name(, identifier: name)*)?) (: name|auto)?
   //    ({ statement* }| => expr;)
 
-  const auto [_, pos] = *iterator;
+  const auto pos = iterator->pos;
   iterator.consume(); // consume fun
 
-  std::vector<template_function_decl::template_arg> template_args;
+  arena_vector<template_function_decl::template_arg> template_args;
   auto token = *iterator;
-  if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::LESS_THAN) {
+  if(is<symbol>(token) && as<symbol>(token) == symbol::LESS_THAN) {
     // template arguments
     auto args = parse_template_args(iterator);
     if(args == std::nullopt) return std::nullopt;
@@ -899,7 +943,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
   std::optional<name> receiver; // is std::nullopt if no receiver, otherwise the typename of the receiver
   auto lookahead = iterator.peek();
-  if(is<symbol>(lookahead.actual) && as<symbol>(lookahead.actual) == symbol::DOT) {
+  if(is<symbol>(lookahead) && as<symbol>(lookahead) == symbol::DOT) {
     // receiver type
     receiver = parse_type_name(iterator); // type name
     if(receiver == std::nullopt) return std::nullopt;
@@ -907,23 +951,24 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
   }
 
   token = *iterator;
-  if(!is<identifier>(token.actual)) {
+  if(!is<identifier>(token)) {
     logger << expect_identifier(token);
     return std::nullopt;
   }
-  auto name = as<identifier>(token.actual).ident;
+  auto name = as<identifier>(token).ident;
+  iterator.consume(); // consume name
 
   token = *iterator;
   iterator.consume(); // consume (
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_OPEN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_OPEN) {
     logger << expect("opening parenthesis (`(`)", token);
     return std::nullopt;
   }
 
   token = *iterator;
-  std::vector<function_decl::arg> args;
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::PAREN_CLOSE) {
-    if(!is<identifier>(token.actual)) {
+  function_decl::args_t args;
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::PAREN_CLOSE) {
+    if(!is<identifier>(token)) {
       logger << expect("identifier or closing parenthesis (`)`)", token);
       return std::nullopt;
     }
@@ -932,15 +977,15 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
       token = *iterator;
       iterator.consume(); // consume identifier
       auto arg_pos = token.pos;
-      if(!is<identifier>(token.actual)) {
+      if(!is<identifier>(token)) {
         logger << expect_identifier(token);
         return std::nullopt;
       }
-      std::string arg_name = as<identifier>(token.actual).ident;
+      interned arg_name = as<identifier>(token).ident;
 
       token = *iterator;
       iterator.consume(); // consume :
-      if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::COLON) {
+      if(!is<symbol>(token) || as<symbol>(token) != symbol::COLON) {
         logger << expect("colon (`:`)", token);
         return std::nullopt;
       }
@@ -952,9 +997,9 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
       token = *iterator;
       iterator.consume(); // consume , or )
-      if(is<symbol>(token.actual)) {
-        if(as<symbol>(token.actual) == symbol::PAREN_CLOSE) break;
-        if(as<symbol>(token.actual) != symbol::COMMA) {
+      if(is<symbol>(token)) {
+        if(as<symbol>(token) == symbol::PAREN_CLOSE) break;
+        if(as<symbol>(token) != symbol::COMMA) {
           logger << expect("comma (`,`) or closing parenthesis (`)`)", token);
           return std::nullopt;
         }
@@ -971,10 +1016,10 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
   token = *iterator;
   function_decl::return_type_t ret_type = function_decl::no_return_type{};
-  if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::COLON) {
+  if(is<symbol>(token) && as<symbol>(token) == symbol::COLON) {
     iterator.consume(); // consume :
     token = *iterator;
-    if(is<keyword>(token.actual) && as<keyword>(token.actual) == keyword::AUTO) {
+    if(is<keyword>(token) && as<keyword>(token) == keyword::AUTO) {
       iterator.consume();
       ret_type = function_decl::auto_type{};
     }
@@ -987,9 +1032,10 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
   token = *iterator;
   iterator.consume(); // consume { or =>
-  std::vector<statement> body;
-  if(is<symbol>(token.actual)) {
-    if(as<symbol>(token.actual) == symbol::ARROW) {
+  arena_vector<statement> body;
+  std::optional<function_body> deferred;
+  if(is<symbol>(token)) {
+    if(as<symbol>(token) == symbol::ARROW) {
       // => expr
       token = *iterator;
       auto expr_pos = token.pos;
@@ -998,7 +1044,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
       token = *iterator;
       iterator.consume(); // consume ;
-      if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::SEMI) {
+      if(!is<symbol>(token) || as<symbol>(token) != symbol::SEMI) {
         logger << expect("semicolon (`;`)", token);
         return std::nullopt;
       }
@@ -1007,11 +1053,21 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
         .value = std::move(*expr)
       }, expr_pos));
     }
-    else if(as<symbol>(token.actual) == symbol::BRACE_OPEN) {
-      // { statement* } (same as block)
-      auto block = parse_block_stmt(iterator);
-      if(block == std::nullopt) return std::nullopt;
-      body = std::move(as<::block>(block->content).statements);
+    else if(as<symbol>(token) == symbol::BRACE_OPEN && iterator.defers_bodies()) {
+      auto lazy = defer_body(iterator);
+      if(lazy == nullptr) return std::nullopt;
+      deferred = function_body{lazy};
+    }
+    else if(as<symbol>(token) == symbol::BRACE_OPEN) {
+      // { statement* } (same as block, but the { is already consumed)
+      token = *iterator;
+      while(!is<symbol>(token) || as<symbol>(token) != symbol::BRACE_CLOSE) {
+        auto stmt = parse_stmt(iterator);
+        if(stmt == std::nullopt) return std::nullopt;
+        body.push_back(std::move(*stmt));
+        token = *iterator;
+      }
+      iterator.consume(); // consume }
     }
     else {
       logger << expect("opening brace (`{`) or arrow (`=>`)", token);
@@ -1023,6 +1079,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
     return std::nullopt;
   }
 
+  auto fn_body = deferred.has_value() ? std::move(*deferred) : function_body{std::move(body)};
   if(receiver.has_value()) {
     if(!template_args.empty()) {
       return declaration(
@@ -1030,7 +1087,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
           .base = {
             .receiver = std::move(*receiver), .ext_func_name = std::move(name),
             .args = std::move(args), .return_type = std::move(ret_type),
-            .body = std::move(body)
+            .body = std::move(fn_body)
           },
           .template_args = std::move(template_args)
         },
@@ -1042,7 +1099,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
       ext_function_decl {
         .receiver = std::move(*receiver), .ext_func_name = std::move(name),
         .args = std::move(args), .return_type = std::move(ret_type),
-        .body = std::move(body)
+        .body = std::move(fn_body)
       },
       pos
     );
@@ -1053,7 +1110,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
       template_function_decl{
         .base = {
           .function_name = std::move(name), .args = std::move(args), .return_type = std::move(ret_type),
-          .body = std::move(body)
+          .body = std::move(fn_body)
         },
         .template_args = std::move(template_args)
       },
@@ -1064,18 +1121,18 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
   return declaration(
     function_decl{
       .function_name = std::move(name), .args = std::move(args), .return_type = std::move(ret_type),
-      .body = std::move(body)
+      .body = std::move(fn_body)
     },
     pos
   );
 
   /*{
-    const auto [_, fun_pos] = *iterator;
+    const auto fun_pos = iterator->pos;
     iterator.consume(); // consume fun
 
     auto token = iterator.peek();
     std::optional<name> receiver; // is null if normal, otherwise typename if receiver
-    if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::PAREN_OPEN) {
+    if(is<symbol>(token) && as<symbol>(token) == symbol::PAREN_OPEN) {
       receiver = std::nullopt;
     }
     else {
@@ -1084,7 +1141,7 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
       receiver = *tname;
 
       const auto next = *iterator;
-      if(!is<symbol>(next.actual) || as<symbol>(next.actual) != symbol::DOT) {
+      if(!is<symbol>(next) || as<symbol>(next) != symbol::DOT) {
         logger << expect("opening dot (`.`) after function receiver", next);
       }
       iterator.consume(); // consume .
@@ -1092,35 +1149,35 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
     token = *iterator;
     iterator.consume(); // consume <name>
-    if(!is<identifier>(token.actual)) {
-      logger << expect_identifier({token.actual, token.pos});
+    if(!is<identifier>(token)) {
+      logger << expect_identifier(token);
       return std::nullopt;
     }
-    const std::string name = as<identifier>(token.actual).ident;
+    const interned name = as<identifier>(token).ident;
 
     iterator.consume(); // consume ( (already checked)
 
-    std::vector<function_decl::arg> args;
+    function_decl::args_t args;
     while(!iterator.eof()) {
       const auto p = iterator->pos;
       auto tname = parse_full_name(iterator);
       if(tname == std::nullopt) return std::nullopt;
       auto a_name = *iterator;
       iterator.consume(); // consume arg name
-      if(!is<identifier>(a_name.actual)) {
+      if(!is<identifier>(a_name)) {
         logger << expect_identifier(a_name);
         return std::nullopt;
       }
 
-      args.push_back({ .type = *tname, .name = as<identifier>(a_name.actual).ident, .pos = p });
+      args.push_back({ .type = *tname, .name = as<identifier>(a_name).ident, .pos = p });
 
       token = *iterator;
       iterator.consume(); // consume , or )
-      if(is<symbol>(token.actual)) {
-        if(as<symbol>(token.actual) == symbol::PAREN_CLOSE) {
+      if(is<symbol>(token)) {
+        if(as<symbol>(token) == symbol::PAREN_CLOSE) {
           break;
         }
-        if(as<symbol>(token.actual) != symbol::COMMA) {
+        if(as<symbol>(token) != symbol::COMMA) {
           logger << expect("comma (`,`) or closing parenthesis (`)`)", token);
           return std::nullopt;
         }
@@ -1133,13 +1190,13 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
     token = *iterator;
     function_decl::return_type_t ret_type = function_decl::no_return_type{};
-    if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::COLON) {
+    if(is<symbol>(token) && as<symbol>(token) == symbol::COLON) {
       iterator.consume(); // consume :
 
       token = *iterator;
-      if(is<keyword>(token.actual)) {
+      if(is<keyword>(token)) {
         iterator.consume(); // consume auto
-        if(as<keyword>(token.actual) != keyword::AUTO) {
+        if(as<keyword>(token) != keyword::AUTO) {
           logger << expect("qualified type name or auto", token);
           return std::nullopt;
         }
@@ -1155,17 +1212,17 @@ std::optional<declaration> parse_fun_decl(token_it &iterator) {
 
     token = *iterator;
     iterator.consume();
-    if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::BRACE_OPEN) {
+    if(!is<symbol>(token) || as<symbol>(token) != symbol::BRACE_OPEN) {
       logger << expect("opening brace (`{`)", token);
       return std::nullopt;
     }
 
-    std::vector<statement> body;
+    arena_vector<statement> body;
     token = *iterator;
-    while(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::BRACE_CLOSE) {
+    while(!is<symbol>(token) || as<symbol>(token) != symbol::BRACE_CLOSE) {
       auto stmt = parse_stmt(iterator);
       if(stmt == std::nullopt) return std::nullopt;
-      body.push_back(*stmt);
+      body.push_back(std::move(*stmt));
       token = *iterator;
     }
 
@@ -1190,26 +1247,26 @@ std::optional<declaration> parse_type_decl(token_it &iterator) {
   //    (<identifier (: name (& name)*)?(, identifier (: name (&name)*)*)>)?
   //    (: name(, name)*)
   //    { body }
-  const auto [_, pos] = *iterator;
+  const auto pos = iterator->pos;
   iterator.consume(); // consume struct
 
   auto token = *iterator;
   iterator.consume(); // consume identifier
-  if(!is<identifier>(token.actual)) {
+  if(!is<identifier>(token)) {
     logger << expect_identifier(token);
     return std::nullopt;
   }
-  auto name = as<identifier>(token.actual).ident;
+  auto name = as<identifier>(token).ident;
 
   token = *iterator;
-  if(!is<symbol>(token.actual)) {
+  if(!is<symbol>(token)) {
     iterator.consume();
     logger << expect("opening angle bracket (`<`), colon (`:`), or opening brace (`{`)", token);
     return std::nullopt;
   }
 
-  std::vector<template_type_decl::template_arg> template_args{};
-  if(as<symbol>(token.actual) == symbol::LESS_THAN) {
+  arena_vector<template_type_decl::template_arg> template_args{};
+  if(as<symbol>(token) == symbol::LESS_THAN) {
     // template arguments
     auto args = parse_template_args(iterator);
     if(args == std::nullopt) return std::nullopt;
@@ -1217,15 +1274,15 @@ std::optional<declaration> parse_type_decl(token_it &iterator) {
   }
 
   token = *iterator;
-  if(!is<symbol>(token.actual)) {
+  if(!is<symbol>(token)) {
     iterator.consume();
     logger << expect("colon (`:`) or opening brace (`{`)", token);
     return std::nullopt;
   }
 
 
-  std::vector<::name> bases{};
-  if(as<symbol>(token.actual) == symbol::COLON) {
+  arena_vector<::name> bases{};
+  if(as<symbol>(token) == symbol::COLON) {
     // base types, explicitly implemented interfaces
     iterator.consume(); // consume :
     while (!iterator.eof()) {
@@ -1234,10 +1291,10 @@ std::optional<declaration> parse_type_decl(token_it &iterator) {
       bases.push_back(std::move(*tname));
 
       token = *iterator;
-      if(is<symbol>(token.actual)) {
-        if(as<symbol>(token.actual) == symbol::BRACE_OPEN) break;
+      if(is<symbol>(token)) {
+        if(as<symbol>(token) == symbol::BRACE_OPEN) break;
         iterator.consume();
-        if(as<symbol>(token.actual) != symbol::COMMA) {
+        if(as<symbol>(token) != symbol::COMMA) {
           logger << expect("comma (`,`) or opening brace (`{`)", token);
           return std::nullopt;
         }
@@ -1251,17 +1308,17 @@ std::optional<declaration> parse_type_decl(token_it &iterator) {
 
   token = *iterator;
   iterator.consume(); // consume {
-  if(!is<symbol>(token.actual) || as<symbol>(token.actual) != symbol::BRACE_OPEN) {
+  if(!is<symbol>(token) || as<symbol>(token) != symbol::BRACE_OPEN) {
     logger << expect("opening brace (`{`)", token);
     return std::nullopt;
   }
 
-  std::vector<std::pair<global_decl, location>> fields;
-  std::vector<std::pair<function_decl, location>> members;
-  std::vector<std::pair<template_function_decl, location>> template_members;
-  std::vector<std::pair<type_decl, location>> nested;
-  std::vector<std::pair<template_type_decl, location>> nested_templates;
-  while(!is<symbol>(iterator->actual) || as<symbol>(iterator->actual) != symbol::BRACE_CLOSE) {
+  arena_vector<std::pair<global_decl, location>> fields;
+  arena_vector<std::pair<function_decl, location>> members;
+  arena_vector<std::pair<template_function_decl, location>> template_members;
+  arena_vector<std::pair<type_decl, location>> nested;
+  arena_vector<std::pair<template_type_decl, location>> nested_templates;
+  while(!is<symbol>(*iterator) || as<symbol>(*iterator) != symbol::BRACE_CLOSE) {
     auto decl = parse_decl(iterator);
     if(decl == std::nullopt) return std::nullopt;
 
@@ -1290,6 +1347,7 @@ std::optional<declaration> parse_type_decl(token_it &iterator) {
       nested_templates.emplace_back(std::move(as<template_type_decl>(decl->content)), decl->pos);
     }
   }
+  iterator.consume(); // consume }
 
   type_decl base {
     .type_name = std::move(name), .bases = std::move(bases), .fields = std::move(fields),
@@ -1309,28 +1367,72 @@ std::optional<declaration> parse_type_decl(token_it &iterator) {
   return declaration(base, pos);
 }
 
+// after a failed declaration: goes back to where it started and skips past its end (a `;` or matching `}` outside of
+// brackets), stopping early at the `}` that closes the enclosing namespace (or at eof); a stray closing bracket at
+// the start is skipped on its own
+void skip_declaration(token_it &iterator, const size_t start) {
+  iterator.seek(start);
+  size_t depth = 0;
+  while(!iterator.eof()) {
+    const auto t = *iterator;
+    if(!is<symbol>(t)) {
+      iterator.consume();
+      continue;
+    }
+
+    switch(as<symbol>(t)) {
+      case symbol::PAREN_OPEN: case symbol::BRACKET_OPEN: case symbol::BRACE_OPEN:
+        depth++;
+        break;
+      case symbol::PAREN_CLOSE: case symbol::BRACKET_CLOSE: case symbol::BRACE_CLOSE:
+        if(depth == 0) {
+          if(iterator.position() == start) iterator.consume();
+          return;
+        }
+        iterator.consume();
+        if(--depth == 0 && as<symbol>(t) == symbol::BRACE_CLOSE) return;
+        continue;
+      case symbol::SEMI:
+        if(depth == 0) {
+          iterator.consume();
+          return;
+        }
+        break;
+      default:
+        break;
+    }
+    iterator.consume();
+  }
+}
+
 std::optional<declaration> parse_ns_decl(token_it &iterator) {
   // namespace <name> { <body> }
-  const auto [_, ns_pos] = *iterator;
+  const auto ns_pos = iterator->pos;
   iterator.consume(); // consume namespace
-  const auto [actual, pos] = *iterator;
+  const auto actual = *iterator;
   iterator.consume(); // consume <name>
   if(!is<identifier>(actual)) {
-    logger << expect_identifier({actual, pos});
+    logger << expect_identifier(actual);
     return std::nullopt;
   }
 
   const auto open_tok = *iterator;
   iterator.consume(); // consume {
-  if(!is<symbol>(open_tok.actual) || as<symbol>(open_tok.actual) != symbol::BRACE_OPEN) {
+  if(!is<symbol>(open_tok) || as<symbol>(open_tok) != symbol::BRACE_OPEN) {
     logger << expect("opening brace (`{`)", open_tok);
     return std::nullopt;
   }
 
   auto maybe_close = *iterator;
-  std::vector<declaration> body;
-  while(!is<symbol>(maybe_close.actual) || as<symbol>(maybe_close.actual) != symbol::BRACE_CLOSE) {
-    if(const auto next = parse_decl(iterator); next.has_value()) body.push_back(next.value());
+  arena_vector<declaration> body;
+  while(!is<symbol>(maybe_close) || as<symbol>(maybe_close) != symbol::BRACE_CLOSE) {
+    if(iterator.eof()) {
+      logger << expect("closing brace (`}`)", maybe_close);
+      return std::nullopt;
+    }
+    const auto start = iterator.position();
+    if(auto next = parse_decl(iterator); next.has_value()) body.push_back(std::move(*next));
+    else skip_declaration(iterator, start); // the error is logged; keep the rest of the namespace
     maybe_close = *iterator;
   }
 
@@ -1348,14 +1450,14 @@ std::optional<declaration> parse_glob_decl(token_it &iterator, bool is_mutable)
   iterator.consume(); // consume VAR
   const auto name_tok = *iterator;
   iterator.consume(); // consume <name>
-  if(!is<identifier>(name_tok.actual)) {
-    logger << expect_identifier({name_tok.actual, name_tok.pos});
+  if(!is<identifier>(name_tok)) {
+    logger << expect_identifier(name_tok);
     return std::nullopt;
   }
 
   auto token = *iterator;
   std::optional<::name> type{};
-  if(is<symbol>(token.actual) && as<symbol>(token.actual) == symbol::COLON) {
+  if(is<symbol>(token) && as<symbol>(token) == symbol::COLON) {
     iterator.consume(); // consume :
     type = parse_type_name(iterator); // type name
     if(type == std::nullopt) return std::nullopt;
@@ -1363,25 +1465,25 @@ std::optional<declaration> parse_glob_decl(token_it &iterator, bool is_mutable)
 
   const auto eq_tok = *iterator;
   iterator.consume(); // consume =
-  if(!is<symbol>(eq_tok.actual) || as<symbol>(eq_tok.actual) != symbol::EQUALS) {
+  if(!is<symbol>(eq_tok) || as<symbol>(eq_tok) != symbol::ASSIGN) {
     logger << expect("assignment (`=`)", eq_tok);
     return std::nullopt;
   }
 
-  const auto expr = parse_expr(iterator);
+  auto expr = parse_expr(iterator);
   if(expr == std::nullopt) return std::nullopt;
 
   const auto semi_tok = *iterator;
   iterator.consume(); // consume ;
-  if(!is<symbol>(semi_tok.actual) || as<symbol>(semi_tok.actual) != symbol::SEMI) {
+  if(!is<symbol>(semi_tok) || as<symbol>(semi_tok) != symbol::SEMI) {
     logger << expect("semicolon (`;`)", semi_tok);
     return std::nullopt;
   }
 
   return declaration(
     global_decl{
-      .glob_name = as<identifier>(name_tok.actual).ident, .type = type,
-      .value = *expr, .is_mutable = is_mutable
+      .glob_name = as<identifier>(name_tok).ident, .type = type,
+      .value = std::move(*expr), .is_mutable = is_mutable
     },
     var_tok.pos
   ) | maybe{};
@@ -1391,39 +1493,84 @@ std::optional<declaration> parse_glob_decl(token_it &iterator, bool is_mutable)
 using namespace decl_parsers;
 
 std::optional<declaration> jayc::parser::parse_decl(token_it &iterator) {
-  const auto &[actual, pos] = *iterator;
+  const arena::scope nodes{*iterator.nodes()};
+  const auto &actual = *iterator;
+  const auto &pos = actual.pos;
 
   if(!is<keyword>(actual)) {
-    logger << expect_decl({actual, pos});
+    logger << expect_decl(actual);
     return std::nullopt;
   }
 
+  // pos refers into the iterator's buffer, which a pipe may refill while parsing
+  const auto traced = [start = pos](std::optional<declaration> &&d) {
+    if(d.has_value())
+      trace(trace_category::PARSER, trace_event::DECLARATION_PARSED, start, static_cast<uint32_t>(d->content.index()));
+    return std::move(d);
+  };
+
   switch(as<keyword>(actual)) {
     case keyword::FUN:
-      return parse_fun_decl(iterator);
+      return traced(parse_fun_decl(iterator));
 
     case keyword::STRUCT:
-      return parse_type_decl(iterator);
+      return traced(parse_type_decl(iterator));
 
     case keyword::NAMESPACE:
-      return parse_ns_decl(iterator);
+      return traced(parse_ns_decl(iterator));
 
     case keyword::VAR:
     case keyword::VAL:
-      return parse_glob_decl(iterator, as<keyword>(actual) == keyword::VAR);
+      return traced(parse_glob_decl(iterator, as<keyword>(actual) == keyword::VAR));
 
     default:
-      logger << expect_decl({actual, pos});
+      logger << expect_decl(actual);
     return std::nullopt;
   }
 }
 
 ast jayc::parser::build_ast(token_it &iterator) {
-  ast result{};
+  const arena::scope nodes{*iterator.nodes()};
+  ast result{ ast_storage{ iterator.nodes() }, namespace_decl{} }; // the module shares the iterator's arena
   result.name = "";
   while(!iterator.eof()) {
-    if(auto next = parse_decl(iterator); next.has_value())
-      result.declarations.push_back(*next);
+    const auto start = iterator.position();
+    if(auto next = parse_decl(iterator); next.has_value()) result.declarations.push_back(std::move(*next));
+    else skip_declaration(iterator, start);
   }
   return result;
 }
+
+const arena_vector<statement> &function_body::statements() const {
+  if(lazy == nullptr) return eager;
+
+  if(lazy->materialised.load(std::memory_order_acquire)) return lazy->statements;
+
+  // parsing allocates into the module's arena, which other bodies may be materialised into at the same time
+  const std::lock_guard guard{lazy->nodes->writers()};
+  if(lazy->materialised.load(std::memory_order_relaxed)) return lazy->statements; // another thread got here first
+
+  const arena::scope nodes{*lazy->nodes};
+  // the module owns the arena (and the tokens in it); the iterator only borrows them
+  auto it = token_it(lazy->tokens, std::shared_ptr<arena>{ std::shared_ptr<arena>{}, lazy->nodes });
+  arena_vector<statement> statements;
+  while(!it.eof()) {
+    auto stmt = parse_stmt(it);
+    if(!stmt.has_value()) {
+      // an eager parse drops the whole declaration; don't leave a silently shortened body either
+      lazy->failed = true;
+      statements.clear();
+      break;
+    }
+    statements.push_back(std::move(*stmt));
+  }
+  lazy->statements = std::move(statements);
+  lazy->materialised.store(true, std::memory_order_release);
+  return lazy->statements;
+}
+
+bool function_body::failed() const {
+  if(lazy == nullptr) return false;
+  (void)statements();
+  return lazy->failed;
+}
@@ -5,11 +5,17 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
-#include <functional>
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <vector>
 
 #include "lexer/token_stream.hpp"
 #include "lexer/lexer.hpp"
+#include "lexer/token_pipe.hpp"
 #include "ast.hpp"
+#include "parallel_parser.hpp"
+#include "trace.hpp"
 
 #include "lexer/token_output.hpp"
 
@@ -19,40 +25,104 @@ concept token_getter = requires(F f) {
   { f() } -> std::convertible_to<lexer::token>;
 };
 
+// a cursor over a contiguous, eof-terminated token buffer; token access and lookahead are inlined pointer reads
+// when fed by a token_pipe, the buffer grows chunk by chunk as the parser consumes tokens
+// the nodes parsed from an iterator live in its arena, which the resulting ast (if any) shares
 class token_it {
 public:
+  // the most tokens the parser looks ahead (through peek) past the current one
+  constexpr static size_t max_lookahead = 4;
+
+  explicit token_it(std::vector<lexer::token> buffer) : token_it{std::move(buffer), std::make_shared<jaydk::arena>()} {}
+
+  // parses into an existing arena (e.g. one shared by several iterators on the same thread)
+  token_it(std::vector<lexer::token> buffer, std::shared_ptr<jaydk::arena> nodes)
+    : tokens{std::move(buffer)}, arena{std::move(nodes)} {
+    if(tokens.empty() || !lexer::is<lexer::eof>(tokens.back())) tokens.push_back(lexer::token{lexer::eof{}});
+    rebase(0);
+  }
+
+  // parses a borrowed buffer in place (e.g. a deferred body's tokens, already in the module's arena); it must be
+  // eof-terminated and outlive the iterator
+  token_it(const std::span<const lexer::token> borrowed, std::shared_ptr<jaydk::arena> nodes)
+    : first{borrowed.data()}, cur{borrowed.data()}, last{borrowed.data() + borrowed.size() - 1},
+      arena{std::move(nodes)} {}
+
+  // adapter for arbitrary token getters (mostly tests): drains the getter up to (and including) its eof token once,
+  // so parsing itself never calls through it
   template <token_getter F>
-  explicit token_it(F f) : get{std::move(f)} { current.actual = lexer::invalid_ignored{}; consume(); }
-
-  const lexer::token &operator*() const { return current; }
-  const lexer::token *operator->() const { return &current; }
-  const lexer::token &peek() {
-    if(!lookahead.has_value()) {
-      if(jaydk::is<lexer::eof>(current.actual)) lookahead = current;
-      else lookahead = get();
-    }
-    return lookahead.value();
+  explicit token_it(F f) : token_it{drain(f)} {}
+
+  explicit token_it(lexer::token_pipe &pipe) : pipe{&pipe} {
+    refill();
+    if(tokens.empty()) tokens.push_back(lexer::token{lexer::eof{}});
+    rebase(0);
   }
 
-  void consume() {
-    logger << info{ current.pos, "Consume: " + lexer::token_type(current) };
+  // cur and last point into tokens (or the borrowed buffer), whose heap buffer moves along with it
+  token_it(const token_it &) = delete;
+  token_it(token_it &&) noexcept = default;
+  token_it &operator=(const token_it &) = delete;
+  token_it &operator=(token_it &&) noexcept = default;
+
+  const lexer::token &operator*() const { return *cur; }
+  const lexer::token *operator->() const { return cur; }
+  // lookahead past the end yields the eof token
+  const lexer::token &peek(const size_t n = 1) const {
+    return n < static_cast<size_t>(last - cur) ? cur[n] : *last;
+  }
 
-    if(lookahead.has_value()) {
-      current = lookahead.value();
-      lookahead = std::nullopt;
-    }
-    else {
-      current = get();
+  void consume() {
+    trace(trace_category::PARSER, trace_event::TOKEN_CONSUMED, cur->pos, cur->payload,
+      static_cast<uint16_t>(static_cast<uint8_t>(cur->kind) | cur->sub << 8));
+    if(cur != last) ++cur;
+    // a buffer-fed iterator only gets here near its eof token
+    if(last - cur < static_cast<ptrdiff_t>(max_lookahead) && pipe != nullptr) {
+      const auto at = static_cast<size_t>(cur - tokens.data());
+      refill(at);
+      rebase(at);
     }
   }
 
-  [[nodiscard]] constexpr bool eof() const { return jaydk::is<lexer::eof>(current.actual); }
+  [[nodiscard]] constexpr bool eof() const { return lexer::is<lexer::eof>(*cur); }
+  // index of the current token in the buffer; seek only goes back to positions the iterator has already been at
+  [[nodiscard]] size_t position() const { return static_cast<size_t>(cur - first); }
+  void seek(const size_t at) { cur = first + at; }
+  [[nodiscard]] const std::shared_ptr<jaydk::arena> &nodes() const { return arena; }
+
+  // with deferred bodies, function bodies are only brace-matched and parsed when first needed (see function_body)
+  void defer_bodies(const bool lazy = true) { lazy_bodies = lazy; }
+  [[nodiscard]] bool defers_bodies() const { return lazy_bodies; }
 
+  ~token_it() = default;
 private:
-  std::function<lexer::token()> get;
+  template <token_getter F>
+  static std::vector<lexer::token> drain(F &f) {
+    std::vector<lexer::token> res;
+    do {
+      res.push_back(f());
+    } while(!lexer::is<lexer::eof>(res.back()));
+    return res;
+  }
+
+  // only grows the buffer from consume(), so references from operator* stay valid until the next consume
+  void refill(const size_t at = 0) {
+    while(tokens.size() - at <= max_lookahead && pipe->next(tokens)) {}
+  }
 
-  lexer::token current{};
-  std::optional<lexer::token> lookahead = std::nullopt;
+  void rebase(const size_t at) {
+    first = tokens.data();
+    cur = tokens.data() + at;
+    last = tokens.data() + tokens.size() - 1;
+  }
+
+  std::vector<lexer::token> tokens;
+  const lexer::token *first = nullptr;
+  const lexer::token *cur = nullptr;
+  const lexer::token *last = nullptr; //!< The last buffered token (eof, unless a pipe has more to deliver)
+  lexer::token_pipe *pipe = nullptr;
+  bool lazy_bodies = false;
+  std::shared_ptr<jaydk::arena> arena = std::make_shared<jaydk::arena>();
 };
 
 ast build_ast(token_it &iterator);
@@ -65,22 +135,37 @@ std::optional<expression> parse_expr(token_it &iterator);
 std::optional<statement> parse_stmt(token_it &iterator);
 std::optional<declaration> parse_decl(token_it &iterator);
 
-template <typename Stream> requires(std::derived_from<Stream, std::istream>)
+template <typename YS> requires(lexer::token_source<YS>)
 class parser {
 public:
-  explicit parser(lexer::token_stream<lexer::lexer<Stream>> &&stream) : stream{std::move(stream)} {}
+  explicit parser(lexer::token_stream<YS> &&stream) : stream{std::move(stream)} {}
 
   inline ast parse() {
-    auto it = token_it(extractor(*this));
+    auto it = token_it(stream.drain());
     return build_ast(it);
   }
 
-private:
-  lexer::token_stream<lexer::lexer<Stream>> stream;
+  // only brace-matches function bodies; each is parsed the first time its statements are asked for
+  inline ast parse_signatures() {
+    auto it = token_it(stream.drain());
+    it.defer_bodies();
+    return build_ast(it);
+  }
+
+  // parses declarations on several threads; only worthwhile for large modules on multi-core hosts
+  inline ast parse_parallel(const size_t threads = 0) {
+    return build_ast_parallel(stream.drain(), threads);
+  }
 
-  static auto extractor(parser &p) {
-    return [&p] { lexer::token t; p.stream >> t; return t; };
+  // lexes on a separate thread while parsing; only worthwhile for large inputs on multi-core hosts
+  inline ast parse_pipelined() requires(std::same_as<YS, lexer::lexer>) {
+    lexer::token_pipe pipe{std::move(stream)};
+    auto it = token_it(pipe);
+    return build_ast(it);
   }
+
+private:
+  lexer::token_stream<YS> stream;
 };
 }
 
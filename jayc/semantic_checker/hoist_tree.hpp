@@ -14,42 +14,43 @@ class hoist_tree;
 #include <unordered_map>
 #include "sem_ast.hpp"
 #include "parser/ast.hpp"
+#include "util/interner.hpp"
 #include "util/ref_helpers.hpp"
-#include "util/managed.hpp"
+#include "util/cow.hpp"
 
 namespace jayc::sem {
 // TODO: figure out generics/templates
 
 class hoist_tree {
 public:
-  template <typename T> using map_t = std::unordered_map<std::string, jaydk::managed<T>>;
+  template <typename T> using map_t = std::unordered_map<jaydk::interned, jaydk::cow<T>>;
 
   class node {
   public:
-    node &operator[](const std::string &name);
-    std::string register_function(const std::string &name, const location &at);
-    std::string register_contract(const std::string &name, const location &at);
-    std::string register_type(const std::string &name, const location &at);
-    std::string register_global(const std::string &name, const location &at);
-    jaydk::opt_ref<const node> operator[](const std::string &ns) const;
-    std::optional<std::string> get_local(const std::string &name) const;
-    std::optional<std::string> lookup(const std::vector<std::string> &name) const;
+    node &operator[](const jaydk::interned &name);
+    jaydk::interned register_function(const jaydk::interned &name, const location &at);
+    jaydk::interned register_contract(const jaydk::interned &name, const location &at);
+    jaydk::interned register_type(const jaydk::interned &name, const location &at);
+    jaydk::interned register_global(const jaydk::interned &name, const location &at);
+    jaydk::opt_ref<const node> operator[](const jaydk::interned &ns) const;
+    std::optional<jaydk::interned> get_local(const jaydk::interned &name) const;
+    std::optional<jaydk::interned> lookup(const std::vector<jaydk::interned> &name) const;
 
   private:
     explicit node(hoist_tree &tree) : tree{&tree}, parent{nullptr} {}
-    node(hoist_tree &tree, node &parent, std::string path_name) :
+    node(hoist_tree &tree, node &parent, jaydk::interned path_name) :
       tree{&tree}, parent{&parent}, path_name{std::move(path_name)} {}
 
-    void avoid_duplicate(const std::string &name, const location &at) const;
+    void avoid_duplicate(const jaydk::interned &name, const location &at) const;
 
     hoist_tree *tree;
     node *parent;
-    std::string path_name{};
-    std::unordered_map<std::string, node> children{};
-    std::unordered_map<std::string, std::string> functions{};
-    std::unordered_map<std::string, std::string> contracts{};
-    std::unordered_map<std::string, std::string> types{};
-    std::unordered_map<std::string, std::string> globals{};
+    jaydk::interned path_name{};
+    std::unordered_map<jaydk::interned, node> children{};
+    std::unordered_map<jaydk::interned, jaydk::interned> functions{};
+    std::unordered_map<jaydk::interned, jaydk::interned> contracts{};
+    std::unordered_map<jaydk::interned, jaydk::interned> types{};
+    std::unordered_map<jaydk::interned, jaydk::interned> globals{};
 
     friend hoist_tree;
   };
@@ -57,16 +58,19 @@ public:
   constexpr node &root_node() { return root; }
   [[nodiscard]] constexpr const node &root_node() const { return root; }
 
-  function &lookup_function(const std::string &name);
-  jaydk::opt_ref<const function> lookup_function(const std::string &name) const;
-  contract &lookup_contract(const std::string &name);
-  jaydk::opt_ref<const contract> lookup_contract(const std::string &name) const;
-  type &lookup_type(const std::string &name);
-  jaydk::opt_ref<const type> lookup_type(const std::string &name) const;
-  global &lookup_global(const std::string &name);
-  jaydk::opt_ref<const global> lookup_global(const std::string &name) const;
+  function &lookup_function(const jaydk::interned &name);
+  jaydk::opt_ref<const function> lookup_function(const jaydk::interned &name) const;
+  contract &lookup_contract(const jaydk::interned &name);
+  jaydk::opt_ref<const contract> lookup_contract(const jaydk::interned &name) const;
+  type &lookup_type(const jaydk::interned &name);
+  jaydk::opt_ref<const type> lookup_type(const jaydk::interned &name) const;
+  global &lookup_global(const jaydk::interned &name);
+  jaydk::opt_ref<const global> lookup_global(const jaydk::interned &name) const;
 
-  std::string register_nested_type(const std::string &mangled_outer_name, const std::string &name, const type &t);
+  // fills in the placeholder created when the (mangled) name was registered
+  type &define_type(const jaydk::interned &name, const type &t);
+
+  jaydk::interned register_nested_type(const jaydk::interned &mangled_outer_name, const jaydk::interned &name, const type &t);
 
 private:
   node root{*this};
@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "util/interner.hpp"
 #include "util/string_helpers.hpp"
 
 namespace jayc::sem {
@@ -22,31 +23,31 @@ struct mangler {
    * -> global: ns$ns$...$ns&global
    */
 
-  static std::string mangle_ns(const std::string &base, const std::string &append) {
+  static jaydk::interned mangle_ns(const jaydk::interned &base, const jaydk::interned &append) {
     return base + "$" + append;
   }
 
-  static std::string un_mangle_ns(const std::string &ns) {
-    return jaydk::replace_each(ns, "$", "::");
+  static std::string un_mangle_ns(const jaydk::interned &ns) {
+    return jaydk::replace_each(ns.str(), "$", "::");
   }
 
-  static std::string mangle_initial_type(const std::string &base, const std::string &append) {
+  static jaydk::interned mangle_initial_type(const jaydk::interned &base, const jaydk::interned &append) {
     return base + "%" + append;
   }
 
-  static std::string mangle_nested_type(const std::string &base, const std::string &append) {
+  static jaydk::interned mangle_nested_type(const jaydk::interned &base, const jaydk::interned &append) {
     return base + "#" + append;
   }
 
-  static std::string mangle_contract(const std::string &base, const std::string &append) {
+  static jaydk::interned mangle_contract(const jaydk::interned &base, const jaydk::interned &append) {
     return base + "/" + append;
   }
 
-  static std::string mangle_function(const std::string &base, const std::string &append) {
+  static jaydk::interned mangle_function(const jaydk::interned &base, const jaydk::interned &append) {
     return append + "@" + base;
   }
 
-  static std::string mangle_global(const std::string &base, const std::string &append) {
+  static jaydk::interned mangle_global(const jaydk::interned &base, const jaydk::interned &append) {
     return base + "&" + append;
   }
 };
@@ -18,7 +18,7 @@ class global;
 
 #include "parser/ast.hpp"
 #include "hoist_tree.hpp"
-#include "util/managed.hpp"
+#include "util/cow.hpp"
 #include "util/variant_helpers.hpp"
 #include "util/ref_helpers.hpp"
 
@@ -34,26 +34,26 @@ template <typename T>
 struct literal_expr { T value; };
 
 struct ref_expr {
-  std::string ref;
+  jaydk::interned ref;
 };
 
 struct unary_expr {
   unary_op op;
-  jaydk::managed<expression> expr;
+  jaydk::cow<expression> expr;
   type *e_type;
 };
 
 struct binary_expr {
   binary_op op;
-  jaydk::managed<expression> left;
-  jaydk::managed<expression> right;
+  jaydk::cow<expression> left;
+  jaydk::cow<expression> right;
   type *e_type;
 };
 
 struct ternary_expr {
-  jaydk::managed<expression> condition;
-  jaydk::managed<expression> true_expr;
-  jaydk::managed<expression> false_expr;
+  jaydk::cow<expression> condition;
+  jaydk::cow<expression> true_expr;
+  jaydk::cow<expression> false_expr;
   type *e_type;
 };
 
@@ -62,14 +62,14 @@ struct call_expr {
   // <op> T -> T.op()
   // T <op> -> T.op(int)
   // T[T] -> T.op(T)
-  jaydk::managed<expression> call;
+  jaydk::cow<expression> call;
   std::vector<expression> args;
   type *e_type;
 };
 
 struct member_expr {
-  jaydk::managed<expression> base;
-  std::string member;
+  jaydk::cow<expression> base;
+  jaydk::interned member;
 };
 }
 using namespace expressions_;
@@ -96,7 +96,7 @@ namespace statements_ {
 struct block { std::vector<statement> statements; };
 struct expr_stmt { expression expr; };
 struct var_decl_stmt {
-  std::string name;
+  jaydk::interned name;
   jaydk::opt_ref<type> e_type;
   expression value;
   bool is_mutable;
@@ -104,14 +104,14 @@ struct var_decl_stmt {
 
 struct if_stmt {
   expression condition;
-  jaydk::managed<statement> true_block;
-  std::optional<jaydk::managed<statement>> false_block;
+  jaydk::cow<statement> true_block;
+  jaydk::cow<statement> false_block;
 };
 
 struct loop_stmt {
-  std::optional<jaydk::managed<statement>> init;
+  jaydk::cow<statement> init;
   expression condition;
-  jaydk::managed<statement> block;
+  jaydk::cow<statement> block;
   std::optional<expression> update;
 };
 
@@ -135,17 +135,17 @@ struct statement : node {
 class global : node {
 public:
   global();
-  global(std::string name, type &e_type, expression initial, bool is_mutable, location decl) :
+  global(jaydk::interned name, type &e_type, expression initial, bool is_mutable, location decl) :
     node{std::move(decl)}, name{std::move(name)}, e_type{&e_type}, initial{std::move(initial)}, is_mutable{is_mutable} {}
 
-  [[nodiscard]] constexpr const std::string &get_name() const { return name; }
+  [[nodiscard]] constexpr const jaydk::interned &get_name() const { return name; }
   [[nodiscard]] constexpr const type &get_type() const { return *e_type; }
   [[nodiscard]] constexpr const expression &get_initial() const { return initial; }
   [[nodiscard]] constexpr bool is_var() const { return is_mutable; }
   [[nodiscard]] constexpr location &declared_at() { return pos; }
 
 private:
-  std::string name;
+  jaydk::interned name;
   type *e_type;
   expression initial;
   bool is_mutable;
@@ -154,18 +154,18 @@ private:
 class function : node {
 public:
   function();
-  function(std::string name, std::vector<std::pair<std::string, type *>> params, type *ret_type, statement body, location decl) :
+  function(jaydk::interned name, std::vector<std::pair<jaydk::interned, type *>> params, type *ret_type, statement body, location decl) :
     node{std::move(decl)}, name{std::move(name)}, params{std::move(params)}, ret_type{ret_type}, body{std::move(body)} {}
 
-  [[nodiscard]] constexpr const std::string &get_name() const { return name; }
-  [[nodiscard]] constexpr const std::vector<std::pair<std::string, type *>> &get_params() const { return params; }
+  [[nodiscard]] constexpr const jaydk::interned &get_name() const { return name; }
+  [[nodiscard]] constexpr const std::vector<std::pair<jaydk::interned, type *>> &get_params() const { return params; }
   [[nodiscard]] constexpr const type &get_ret_type() const { return *ret_type; }
   [[nodiscard]] constexpr const statement &get_body() const { return body; }
   [[nodiscard]] constexpr location &declared_at() { return pos; }
 
 private:
-  std::string name;
-  std::vector<std::pair<std::string, type *>> params;
+  jaydk::interned name;
+  std::vector<std::pair<jaydk::interned, type *>> params;
   type *ret_type;
   statement body;
 };
@@ -173,16 +173,16 @@ private:
 class contract : node {
 public:
   contract();
-  contract(std::string name, std::vector<std::pair<std::string, type *>> requirements, location decl) :
+  contract(jaydk::interned name, std::vector<std::pair<jaydk::interned, type *>> requirements, location decl) :
     node{std::move(decl)}, name{std::move(name)}, requirements{std::move(requirements)} {}
 
-  [[nodiscard]] constexpr const std::string &get_name() const { return name; }
-  [[nodiscard]] constexpr const std::vector<std::pair<std::string, type *>> &get_requirements() const { return requirements; }
+  [[nodiscard]] constexpr const jaydk::interned &get_name() const { return name; }
+  [[nodiscard]] constexpr const std::vector<std::pair<jaydk::interned, type *>> &get_requirements() const { return requirements; }
   [[nodiscard]] constexpr location &declared_at() { return pos; }
 
 private:
-  std::string name;
-  std::vector<std::pair<std::string, type *>> requirements;
+  jaydk::interned name;
+  std::vector<std::pair<jaydk::interned, type *>> requirements;
 };
 
 namespace types_ {
@@ -208,12 +208,12 @@ public:
   using field = global;
 
   record_type();
-  record_type(std::string name, std::vector<field> fields, const std::optional<type *> base,
+  record_type(jaydk::interned name, std::vector<field> fields, const std::optional<type *> base,
               std::vector<contract *> explicitly_implemented, std::vector<function> member_functions, location decl) :
     node{std::move(decl)}, name{std::move(name)}, fields{std::move(fields)}, base{base},
     explicitly_implemented{std::move(explicitly_implemented)}, member_functions{std::move(member_functions)} {}
 
-  [[nodiscard]] constexpr const std::string &get_name() const { return name; }
+  [[nodiscard]] constexpr const jaydk::interned &get_name() const { return name; }
   [[nodiscard]] constexpr const std::vector<field> &get_fields() const { return fields; }
   [[nodiscard]] constexpr const std::optional<type *> &get_base() const { return base; }
   [[nodiscard]] constexpr const std::vector<contract *> &get_explicitly_implemented() const { return explicitly_implemented; }
@@ -221,12 +221,12 @@ public:
   [[nodiscard]] constexpr location &declared_at() { return pos; }
 
 private:
-  std::string name;
+  jaydk::interned name;
   std::vector<field> fields;
   std::optional<type *> base;
   std::vector<contract *> explicitly_implemented;
   std::vector<function> member_functions;
-  std::unordered_map<std::string, std::string> nested_types;
+  std::unordered_map<jaydk::interned, jaydk::interned> nested_types;
 };
 }
 using namespace types_;
@@ -238,14 +238,14 @@ public:
   >;
 
   type();
-  type(std::string name, actual_t t, const location &pos) : node{pos}, name{std::move(name)}, content{std::move(t)} {}
+  type(jaydk::interned name, actual_t t, const location &pos) : node{pos}, name{std::move(name)}, content{std::move(t)} {}
 
-  [[nodiscard]] constexpr const std::string &get_name() const { return name; }
+  [[nodiscard]] constexpr const jaydk::interned &get_name() const { return name; }
   [[nodiscard]] constexpr const actual_t &get_actual() const { return content; }
   [[nodiscard]] constexpr const location &declared_at() const { return pos; }
 
 private:
-  std::string name;
+  jaydk::interned name;
   actual_t content;
 };
 
@@ -7,18 +7,15 @@
 #include "hoist_tree.hpp"
 #include "sem_ast.hpp"
 #include "semantic_checker.hpp"
+#include "trace.hpp"
 
 using namespace jaydk;
 using namespace jayc::parser;
 using namespace jayc::sem;
 
 bool build_initial(hoist_tree &out, const ast &ast) {
-  static auto ns_only = [](const std::vector<declaration> &decls) {
-    return filter_is_as<namespace_decl>(decls | std::views::transform([](const declaration &x) { return x.content; }));
-  };
-
   // step 0: register builtin types etc
-  jayc::location builtin_loc{ "(builtin)", 0, 0 };
+  jayc::location builtin_loc{ jayc::sources.add_file("(builtin)"), 0 };
   std::vector<std::pair<type, std::vector<std::string>>> builtins {
     {type("void", void_type{}, builtin_loc), {}},
     {type("int", primitive::INT64, builtin_loc), {"int64"}},
@@ -31,11 +28,10 @@ bool build_initial(hoist_tree &out, const ast &ast) {
 
   for(const auto &[t, alias] : builtins) {
     auto name = out.root_node().register_type(t.get_name(), t.declared_at());
-    out.lookup_type(name) = t;
-    auto *type_ptr = &out.lookup_type(name);
+    auto *type_ptr = &out.define_type(name, t);
     for(const auto &a : alias) {
-      out.root_node().register_type(a, t.declared_at());
-      out.lookup_type(a) = {a, type_alias{type_ptr}, builtin_loc};
+      const auto alias_name = out.root_node().register_type(a, t.declared_at());
+      out.define_type(alias_name, {a, type_alias{type_ptr}, builtin_loc});
     }
   }
 
@@ -46,8 +42,11 @@ bool build_initial(hoist_tree &out, const ast &ast) {
   while(!ns_stack.empty()) {
     auto [node, d] = ns_stack.back();
     ns_stack.pop_back();
-    for(const auto &sub : ns_only(d.declarations)) {
-      ns_stack.emplace_back(node[sub.name], sub);
+    for(const auto &sub : d.declarations) {
+      if(const auto *ns = std::get_if<namespace_decl>(&sub.content)) {
+        ns_stack.emplace_back(node[ns->name], *ns);
+        trace(jayc::trace_category::SEMA, jayc::trace_event::NAMESPACE_REGISTERED, sub.pos, ns->name.id());
+      }
     }
   }
 
@@ -56,8 +55,12 @@ bool build_initial(hoist_tree &out, const ast &ast) {
   while(!ns_stack.empty()) {
     auto [node, d] = ns_stack.back();
     ns_stack.pop_back();
-    for(const auto &sub : filter_is_as<type_decl>(d.declarations)) {
-      node.register_type(sub.name, sub.location);
+    for(const auto &sub : d.declarations) {
+      if(const auto *ns = std::get_if<namespace_decl>(&sub.content)) ns_stack.emplace_back(node[ns->name], *ns);
+      else if(is<type_decl>(sub.content)) {
+        const auto name = node.register_type(as<type_decl>(sub.content).type_name, sub.pos);
+        trace(jayc::trace_category::SEMA, jayc::trace_event::TYPE_REGISTERED, sub.pos, name.id());
+      }
     }
 
     // TODO: type registration
@@ -27,14 +27,14 @@ public:
 
   [[nodiscard]] const location &at() const { return loc; }
 
-  static semantic_error redefine_ns(const std::string &path, const std::string &name, const location &at) {
+  static semantic_error redefine_ns(const jaydk::interned &path, const jaydk::interned &name, const location &at) {
     return {
       "Redefinition of namespace " + mangler::un_mangle_ns(path) + "::" + name + " ) as a different kind of symbol",
       at
     };
   }
 
-  static semantic_error redefine_X(const std::string &path, const std::string &orig, const std::string &name, const location &orig_decl, const location &at) {
+  static semantic_error redefine_X(const jaydk::interned &path, const std::string &orig, const jaydk::interned &name, const location &orig_decl, const location &at) {
     return {
       "Redefinition of " + orig + " " + mangler::un_mangle_ns(path) + "::" + name + " (declared at " + to_string(orig_decl) +
       ") as a different kind of symbol",
@@ -0,0 +1,79 @@
+//
+// Created by jay on 9/17/24.
+//
+
+#include <algorithm>
+
+#include "source_manager.hpp"
+#include "lexer/scan.hpp"
+
+using namespace jayc;
+
+source_manager &source_manager::get() {
+  static source_manager manager;
+  return manager;
+}
+
+source_manager::source_manager() {
+  files.emplace_back("", nullptr);
+  payload_tables.push_back(&detached);
+}
+
+file_id source_manager::add_file(std::string name, std::shared_ptr<const lexer::source_buffer> buffer) {
+  std::lock_guard guard{lock};
+  files.emplace_back(std::move(name), std::move(buffer));
+  payload_tables.push_back(&files.back().payloads);
+  return static_cast<file_id>(files.size() - 1);
+}
+
+void source_manager::replace_buffer(const file_id file, std::shared_ptr<const lexer::source_buffer> buffer) {
+  std::lock_guard guard{lock};
+  if(file == 0 || file >= files.size()) return;
+
+  auto &entry = files[file];
+  if(entry.buffer != nullptr) entry.retired.push_back(std::move(entry.buffer));
+  entry.buffer = std::move(buffer);
+  entry.line_starts.clear();
+}
+
+std::string_view source_manager::file_name(const file_id file) {
+  std::lock_guard guard{lock};
+  if(file >= files.size()) return files[0].name;
+  return files[file].name;
+}
+
+std::shared_ptr<const lexer::source_buffer> source_manager::buffer(const file_id file) {
+  std::lock_guard guard{lock};
+  if(file >= files.size()) return nullptr;
+  return files[file].buffer;
+}
+
+resolved_location source_manager::resolve(const location &loc) {
+  std::lock_guard guard{lock};
+  if(loc.file >= files.size()) return { files[0].name, 0, 0 };
+
+  auto &entry = files[loc.file];
+  if(entry.buffer == nullptr) return { entry.name, 0, 0 };
+
+  if(entry.line_starts.empty()) {
+    const char *begin = entry.buffer->begin();
+    const char *end = entry.buffer->end();
+    entry.line_starts.reserve(lexer::scan::count_newlines(begin, end) + 1);
+    entry.line_starts.push_back(0);
+    for(const char *nl = lexer::scan::find_newline(begin, end); nl != end; nl = lexer::scan::find_newline(nl + 1, end)) {
+      entry.line_starts.push_back(static_cast<uint32_t>(nl - begin + 1));
+    }
+  }
+
+  const auto it = std::ranges::upper_bound(entry.line_starts, loc.offset) - 1;
+  return {
+    entry.name,
+    static_cast<int>(it - entry.line_starts.begin()) + 1,
+    static_cast<int>(loc.offset - *it) + 1
+  };
+}
+
+lexer::token_payloads &source_manager::payloads(const file_id file) {
+  auto *table = payload_tables[file];
+  return table != nullptr ? *table : detached;
+}
@@ -0,0 +1,81 @@
+//
+// Created by jay on 9/17/24.
+//
+
+#ifndef SOURCE_MANAGER_HPP
+#define SOURCE_MANAGER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lexer/source_buffer.hpp"
+#include "lexer/token_payloads.hpp"
+#include "util/append_only.hpp"
+
+namespace jayc {
+using file_id = uint32_t;
+
+// compact source location: line and column are only computed (by the source manager) when they are needed
+struct location {
+  file_id file = 0; //!< ID of the file in the source manager (0 = unknown)
+  uint32_t offset = 0; //!< Byte offset in that file
+
+  constexpr bool operator==(const location &) const = default;
+};
+
+struct resolved_location {
+  std::string_view file;
+  int line;
+  int col;
+};
+
+class source_manager {
+public:
+  source_manager(const source_manager&) = delete;
+  source_manager(source_manager&&) = delete;
+  source_manager& operator=(const source_manager&) = delete;
+  source_manager& operator=(source_manager&&) = delete;
+
+  static source_manager& get();
+
+  // registers a file; files without a buffer (e.g. builtins, unreadable files) resolve to line/column 0
+  file_id add_file(std::string name, std::shared_ptr<const lexer::source_buffer> buffer = nullptr);
+  // swaps in the edited contents of a file (see lexer::relex); the old buffer is kept alive, since tokens that
+  // survive the edit may still view into it (string literals)
+  void replace_buffer(file_id file, std::shared_ptr<const lexer::source_buffer> buffer);
+  [[nodiscard]] std::string_view file_name(file_id file);
+  [[nodiscard]] std::shared_ptr<const lexer::source_buffer> buffer(file_id file);
+  resolved_location resolve(const location &loc);
+  // side tables for the tokens lexed from this file; the reference stays valid for the program's lifetime
+  // lock-free, since every decoded literal goes through here; file 0 (and unknown files) share a deduplicating table
+  lexer::token_payloads &payloads(file_id file);
+
+  ~source_manager() = default;
+private:
+  source_manager();
+
+  struct file_entry {
+    std::string name;
+    std::shared_ptr<const lexer::source_buffer> buffer;
+    std::vector<uint32_t> line_starts{}; //!< Offsets at which each line starts (built on first resolve)
+    std::vector<std::shared_ptr<const lexer::source_buffer>> retired{}; //!< Buffers replaced by edits
+    lexer::token_payloads payloads{};
+  };
+
+  std::mutex lock;
+  std::deque<file_entry> files;
+  lexer::token_payloads detached{true}; //!< Payloads of tokens not lexed from a file (file 0)
+  jaydk::append_only<lexer::token_payloads *> payload_tables; //!< Per file ID, readable without taking the lock
+};
+
+inline static source_manager &sources = source_manager::get();
+
+inline resolved_location resolve(const location &loc) { return sources.resolve(loc); }
+}
+
+#endif //SOURCE_MANAGER_HPP
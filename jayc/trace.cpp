@@ -0,0 +1,143 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <bit>
+
+#include "trace.hpp"
+#include "error_queue.hpp"
+#include "lexer/token_output.hpp"
+#include "util/interner.hpp"
+
+using namespace jayc;
+
+namespace {
+std::string_view category_name(const trace_category c) {
+  switch(c) {
+    case trace_category::LEXER: return "lexer";
+    case trace_category::PARSER: return "parser";
+    case trace_category::SEMA: return "sema";
+  }
+  return "?";
+}
+
+void describe(std::ostream &out, const trace_record &r) {
+  switch(r.event) {
+    case trace_event::TOKENS_LEXED: out << "lexed " << r.detail << " token(s)"; break;
+    case trace_event::TOKEN_CONSUMED: {
+      lexer::token t;
+      t.pos = r.pos;
+      t.kind = static_cast<lexer::token_kind>(r.extra & 0xff);
+      t.sub = static_cast<uint8_t>(r.extra >> 8);
+      t.payload = r.detail;
+      out << "consume " << lexer::token_type(t);
+      break;
+    }
+    case trace_event::DECLARATION_PARSED: out << "parsed declaration (kind " << r.detail << ")"; break;
+    case trace_event::NAMESPACE_REGISTERED:
+      out << "registered namespace `" << jaydk::interned::from_id(r.detail) << "`"; break;
+    case trace_event::TYPE_REGISTERED: out << "registered type `" << jaydk::interned::from_id(r.detail) << "`"; break;
+  }
+}
+}
+
+tracer &tracer::get() {
+  static tracer t;
+  return t;
+}
+
+void tracer::enable(const trace_category c, const size_t capacity) { enable_mask(bit(c), capacity); }
+
+void tracer::enable_all(const size_t capacity) {
+  enable_mask(bit(trace_category::LEXER) | bit(trace_category::PARSER) | bit(trace_category::SEMA), capacity);
+}
+
+void tracer::enable_mask(const uint8_t categories, const size_t capacity) {
+  if(ring == nullptr) {
+    this->capacity = std::bit_ceil(std::max<size_t>(capacity, 1));
+    ring = std::make_unique<slot[]>(this->capacity);
+  }
+  mask.fetch_or(categories);
+}
+
+void tracer::disable(const trace_category c) { mask.fetch_and(static_cast<uint8_t>(~bit(c))); }
+void tracer::disable_all() { mask.store(0); }
+
+void tracer::record(
+  const trace_category c, const trace_event e, const location &pos, const uint32_t detail, const uint16_t extra
+) {
+  const auto seq = next.fetch_add(1, std::memory_order_relaxed);
+  auto &s = ring[seq & (capacity - 1)];
+
+  // claim the slot; it's only busy if a writer a whole ring ahead (or behind) got there at the same time
+  auto stamp = s.stamp.load(std::memory_order_relaxed);
+  do {
+    if(stamp >= 2 * seq + 2) return; // a newer record is already there
+    if(stamp % 2 == 1) stamp = s.stamp.load(std::memory_order_relaxed);
+  } while(stamp % 2 == 1 || !s.stamp.compare_exchange_weak(stamp, 2 * seq + 1, std::memory_order_acquire));
+
+  s.where.store(static_cast<uint64_t>(pos.file) << 32 | pos.offset, std::memory_order_relaxed);
+  s.what.store(
+    detail | static_cast<uint64_t>(extra) << 32 | static_cast<uint64_t>(c) << 48 | static_cast<uint64_t>(e) << 56,
+    std::memory_order_relaxed
+  );
+  s.stamp.store(2 * seq + 2, std::memory_order_release);
+}
+
+size_t tracer::size() const { return std::min<uint64_t>(next.load(), capacity); }
+
+trace_record tracer::at(const size_t i) const {
+  const auto total = next.load();
+  const auto &s = ring[(total - size() + i) & (capacity - 1)];
+
+  // retry until the slot reads the same before and after (no writer in between)
+  while(true) {
+    const auto stamp = s.stamp.load(std::memory_order_acquire);
+    if(stamp % 2 == 1) continue;
+    const auto where = s.where.load(std::memory_order_relaxed);
+    const auto what = s.what.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(s.stamp.load(std::memory_order_relaxed) != stamp) continue;
+
+    return trace_record{
+      .sequence = stamp == 0 ? 0 : stamp / 2 - 1,
+      .pos = location{ static_cast<file_id>(where >> 32), static_cast<uint32_t>(where) },
+      .detail = static_cast<uint32_t>(what),
+      .extra = static_cast<uint16_t>(what >> 32),
+      .category = static_cast<trace_category>(what >> 48 & 0xff),
+      .event = static_cast<trace_event>(what >> 56)
+    };
+  }
+}
+
+void tracer::dump(std::ostream &out) const {
+  const auto total = next.load();
+  if(total > capacity) out << "(" << total - capacity << " older trace record(s) dropped)\n";
+  for(size_t i = 0; i < size(); i++) {
+    const auto r = at(i);
+    out << "#" << r.sequence << " [" << category_name(r.category) << "] " << r.pos << ": ";
+    describe(out, r);
+    out << "\n";
+  }
+}
+
+void tracer::clear() {
+  for(size_t i = 0; i < capacity; i++) ring[i].stamp.store(0);
+  next.store(0);
+}
+
+std::optional<uint8_t> tracer::parse_categories(const std::string_view list) {
+  uint8_t res = 0;
+  size_t start = 0;
+  while(start <= list.size()) {
+    const auto comma = std::min(list.find(',', start), list.size());
+    const auto item = list.substr(start, comma - start);
+    if(item == "lexer") res |= bit(trace_category::LEXER);
+    else if(item == "parser") res |= bit(trace_category::PARSER);
+    else if(item == "sema") res |= bit(trace_category::SEMA);
+    else if(item == "all") res |= bit(trace_category::LEXER) | bit(trace_category::PARSER) | bit(trace_category::SEMA);
+    else return std::nullopt;
+    start = comma + 1;
+  }
+  return res;
+}
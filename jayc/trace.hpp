@@ -0,0 +1,112 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+
+#include "source_manager.hpp"
+
+// tracing can be compiled out entirely (-DJAYC_TRACE=0, or the JAYC_TRACE CMake option); when compiled in, it is off
+// until enabled at runtime, and each trace point costs a single relaxed load
+#ifndef JAYC_TRACE
+#define JAYC_TRACE 1
+#endif
+
+namespace jayc {
+constexpr bool trace_compiled = JAYC_TRACE != 0;
+
+enum struct trace_category : uint8_t { LEXER, PARSER, SEMA };
+
+enum struct trace_event : uint8_t {
+  TOKENS_LEXED, //!< detail: number of tokens (one batch or chunk)
+  TOKEN_CONSUMED, //!< detail: token payload; extra: token kind | sub << 8
+  DECLARATION_PARSED, //!< detail: index of the declaration kind in declaration::actual_t
+  NAMESPACE_REGISTERED, //!< detail: interned name
+  TYPE_REGISTERED, //!< detail: interned name
+};
+
+// one structured trace event; formatted only when dumped
+struct trace_record {
+  uint64_t sequence;
+  location pos;
+  uint32_t detail;
+  uint16_t extra;
+  trace_category category;
+  trace_event event;
+};
+
+// a fixed-size ring of the most recent trace records, shared by all threads (the parallel lexer and parser trace too)
+// each slot is guarded by a sequence stamp, so concurrent writers never interleave within a slot and readers never see
+// a half-written record; a writer that finds its slot already holding a newer record drops its own
+class tracer {
+public:
+  constexpr static size_t default_capacity = 1 << 16;
+
+  tracer(const tracer &) = delete;
+  tracer(tracer &&) = delete;
+  tracer &operator=(const tracer &) = delete;
+  tracer &operator=(tracer &&) = delete;
+
+  static tracer &get();
+
+  // enabling allocates the ring (once); capacity is rounded up to a power of two
+  void enable(trace_category c, size_t capacity = default_capacity);
+  void enable_all(size_t capacity = default_capacity);
+  void disable(trace_category c);
+  void disable_all();
+  [[nodiscard]] inline bool enabled(const trace_category c) const {
+    return (mask.load(std::memory_order_relaxed) & bit(c)) != 0;
+  }
+
+  void record(trace_category c, trace_event e, const location &pos, uint32_t detail, uint16_t extra);
+
+  // number of records currently held (at most the capacity)
+  [[nodiscard]] size_t size() const;
+  // the i-th oldest record still held
+  [[nodiscard]] trace_record at(size_t i) const;
+  // writes the held records, oldest first; don't call while other threads are still tracing
+  void dump(std::ostream &out) const;
+  void clear();
+
+  // parses a comma-separated list of categories (lexer, parser, sema, all)
+  static std::optional<uint8_t> parse_categories(std::string_view list);
+  void enable_mask(uint8_t categories, size_t capacity = default_capacity);
+
+  ~tracer() = default;
+private:
+  tracer() = default;
+  constexpr static uint8_t bit(const trace_category c) { return static_cast<uint8_t>(1u << static_cast<uint8_t>(c)); }
+
+  struct slot {
+    std::atomic<uint64_t> stamp{0}; //!< 0: empty, 2 * sequence + 1: being written, 2 * sequence + 2: holds that record
+    std::atomic<uint64_t> where{0}; //!< file << 32 | offset
+    std::atomic<uint64_t> what{0}; //!< detail | extra << 32 | category << 48 | event << 56
+  };
+
+  std::atomic<uint8_t> mask{0};
+  std::atomic<uint64_t> next{0};
+  std::unique_ptr<slot[]> ring;
+  size_t capacity = 0;
+};
+
+inline static tracer &traces = tracer::get();
+
+// records a trace event if its category is enabled; compiles to nothing when tracing is compiled out
+inline void trace(
+  const trace_category c, const trace_event e, const location &pos, const uint32_t detail = 0, const uint16_t extra = 0
+) {
+  if constexpr(trace_compiled) {
+    if(traces.enabled(c)) traces.record(c, e, pos, detail, extra);
+  }
+}
+}
+
+#endif //TRACE_HPP
@@ -0,0 +1,133 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <string>
+#include <doctest/doctest.h>
+
+#include "util/append_only.hpp"
+#include "util/arena.hpp"
+#include "util/cow.hpp"
+#include "util/small_vector.hpp"
+
+using namespace jaydk;
+
+namespace {
+struct counted {
+  inline static int alive = 0;
+  inline static int copies = 0;
+  std::string value;
+
+  explicit counted(std::string value) : value{std::move(value)} { alive++; }
+  counted(const counted &other) : value{other.value} { alive++; copies++; }
+  counted(counted &&other) noexcept : value{std::move(other.value)} { alive++; }
+  ~counted() { alive--; }
+};
+}
+
+TEST_SUITE("jaydk::util") {
+  TEST_CASE("cow shares until written to") {
+    counted::alive = counted::copies = 0;
+    {
+      cow<counted> a{ counted{"a"} };
+      const cow<counted> b = a;
+      CHECK(counted::alive == 1);
+      CHECK(a.shares_with(b));
+      CHECK(a.use_count() == 2);
+      CHECK(b->value == "a"); // const access doesn't copy
+      CHECK(counted::copies == 0);
+
+      a->value = "changed";
+      CHECK_FALSE(a.shares_with(b));
+      CHECK(counted::copies == 1);
+      CHECK(a.unique());
+      CHECK(b.unique());
+      CHECK(b->value == "a");
+      CHECK(a->value == "changed");
+
+      a = b;
+      CHECK(counted::alive == 1); // the changed copy is released
+      a = std::nullopt;
+      CHECK_FALSE(a.has_value());
+      CHECK(b.use_count() == 1);
+    }
+    CHECK(counted::alive == 0);
+  }
+
+  TEST_CASE("atomic cow") {
+    cow<std::string, true> a{ std::string{"x"} };
+    auto b = a;
+    CHECK(b.use_count() == 2);
+    *b += "y";
+    CHECK(*std::as_const(a) == "x");
+    CHECK(*std::as_const(b) == "xy");
+    CHECK(make_cow<std::string>("zzz") == cow<std::string>{ std::string{"zzz"} });
+  }
+
+  TEST_CASE("small_vector stays inline up to N elements") {
+    small_vector<std::string, 2> v;
+    v.push_back("a");
+    v.emplace_back("b");
+    CHECK(v.is_inline());
+    CHECK(v.capacity() == 2);
+
+    v.push_back(v[0]); // refers to an element while growing
+    CHECK_FALSE(v.is_inline());
+    REQUIRE(v.size() == 3);
+    CHECK(v[2] == "a");
+
+    const auto copy = v;
+    CHECK(copy == v);
+
+    auto moved = std::move(v); // spilled: steals the buffer
+    CHECK(v.empty());
+    CHECK(v.is_inline());
+    CHECK(moved == copy);
+
+    small_vector<std::string, 2> small{ "x" };
+    auto moved_small = std::move(small); // inline: moves the elements
+    CHECK(moved_small.is_inline());
+    REQUIRE(moved_small.size() == 1);
+    CHECK(moved_small.back() == "x");
+
+    moved = std::move(moved_small);
+    CHECK(moved.size() == 1);
+    moved.pop_back();
+    CHECK(moved.empty());
+  }
+
+  TEST_CASE("small_vector assignment follows the allocator's propagation traits") {
+    arena first, second;
+    using list = arena_small_vector<std::string, 1>;
+    list a{ arena_allocator<std::string>{&first} };
+    a.push_back("x");
+    a.push_back("y"); // spilled into first
+    list b{ arena_allocator<std::string>{&second} };
+    b.push_back("p");
+    b.push_back("q"); // spilled into second
+
+    b = a; // arena_allocator propagates on copy assignment
+    CHECK(b.get_allocator().source() == &first);
+    CHECK(b == a);
+    const auto used = first.bytes_used();
+    b.push_back("z"); // grows in its new arena
+    CHECK(first.bytes_used() > used);
+
+    list c{ arena_allocator<std::string>{&second} };
+    c = std::move(a); // ... and on move assignment, so the buffer is stolen
+    CHECK(c.get_allocator().source() == &first);
+    CHECK_FALSE(c.is_inline());
+    CHECK(c.size() == 2);
+  }
+
+  TEST_CASE("append_only keeps indices stable across segments") {
+    append_only<uint32_t> table;
+    for(uint32_t i = 0; i < 5000; i++) REQUIRE(table.push_back(i * 3) == i);
+    CHECK(table.size() == 5000);
+    CHECK(table[0] == 0);
+    CHECK(table[255] == 765); // last of the first segment
+    CHECK(table[256] == 768);
+    CHECK(table[4999] == 14997);
+    CHECK(table[5000] == 0); // not pushed yet
+  }
+}
@@ -6,8 +6,14 @@
 #include <sstream>
 #include <doctest/doctest.h>
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
 
 #include "lexer/lexer.hpp"
+#include "lexer/parallel_lexer.hpp"
+#include "lexer/incremental.hpp"
+#include "lexer/token_cache.hpp"
+#include "lexer/scan.hpp"
 #include "lexer/token_stream.hpp"
 #include "lexer/token_output.hpp"
 
@@ -20,6 +26,7 @@ inline static std::string id_keyword_source = "__ignored fun test var _name cont
 inline static std::string bool_literal_source = "true false";
 inline static std::string i64_literal_source = "-10 123 -589 +12";
 inline static std::string ui64_literal_source = "0x123 0xABC 0x123456abcDEF";
+inline static std::string unsigned_literal_source = "0u 42U 18446744073709551615u 0xFFu 0.5";
 inline static std::string f32_literal_source = "123.0f -456.58f";
 inline static std::string f64_literal_source = "123.0 -456.58";
 inline static std::string char_literal_source = R"('a' 'c' '\n' '\'' '"')";
@@ -51,6 +58,11 @@ keyword operator++(keyword &k) {
   return k;
 }
 
+struct expected_token {
+  token_t actual;
+  jayc::resolved_location pos;
+};
+
 TEST_SUITE("jayc - lexer (lexing okay)") {
   TEST_CASE("empty stream = eof") {
     auto lex = lex_source("");
@@ -58,7 +70,7 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
 
     REQUIRE_FALSE(lex.is_eof());
     lex >> t;
-    REQUIRE(is<eof>(t.actual));
+    REQUIRE(is<eof>(t));
     REQUIRE(lex.is_eof());
   }
 
@@ -104,16 +116,16 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
       REQUIRE_FALSE(lex.is_eof());
       lex >> t;
       CAPTURE(t);
-      REQUIRE(is<symbol>(t.actual));
-      CAPTURE(std::get<symbol>(t.actual));
-      CHECK(std::get<symbol>(t.actual) == s);
-      CHECK(t.pos.line == symbol_positions[static_cast<int>(s)].first);
-      CHECK(t.pos.col == symbol_positions[static_cast<int>(s)].second);
+      REQUIRE(is<symbol>(t));
+      CAPTURE(as<symbol>(t));
+      CHECK(as<symbol>(t) == s);
+      CHECK(resolve(t.pos).line == symbol_positions[static_cast<int>(s)].first);
+      CHECK(resolve(t.pos).col == symbol_positions[static_cast<int>(s)].second);
     }
     CHECK_FALSE(lex.is_eof());
     CAPTURE(t);
     lex >> t;
-    CHECK(is<eof>(t.actual));
+    CHECK(is<eof>(t));
     CHECK(lex.is_eof());
     REQUIRE(jayc::logger.phase_error() == 0);
   }
@@ -144,14 +156,14 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
       REQUIRE_FALSE(lex.is_eof());
       lex >> t;
       CAPTURE(t);
-      REQUIRE(is<keyword>(t.actual));
-      CAPTURE(std::get<keyword>(t.actual));
-      CHECK(std::get<keyword>(t.actual) == k);
-      CHECK(t.pos.line == keyword_positions[static_cast<int>(k)].first);
-      CHECK(t.pos.col == keyword_positions[static_cast<int>(k)].second);
+      REQUIRE(is<keyword>(t));
+      CAPTURE(as<keyword>(t));
+      CHECK(as<keyword>(t) == k);
+      CHECK(resolve(t.pos).line == keyword_positions[static_cast<int>(k)].first);
+      CHECK(resolve(t.pos).col == keyword_positions[static_cast<int>(k)].second);
     }
     lex >> t;
-    CHECK(is<eof>(t.actual));
+    CHECK(is<eof>(t));
     CHECK(lex.is_eof());
     REQUIRE(jayc::logger.phase_error() == 0);
   }
@@ -163,151 +175,190 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
       //          1         2         3         4         5
       // 12345678901234567890123456789012345678901234567890123456
       // __ignored fun test var _name continue with2numbers3 ____
-      token{ .actual = identifier{"__ignored"}, .pos = {"", 1, 1} },
-      token{ .actual = keyword::FUN, .pos = {"", 1, 11} },
-      token{ .actual = identifier{"test"}, .pos = {"", 1, 15} },
-      token{ .actual = keyword::VAR, .pos = {"", 1, 20} },
-      token{ .actual = identifier{"_name"}, .pos = {"", 1, 24} },
-      token{ .actual = keyword::CONTINUE, .pos = {"", 1, 30} },
-      token{ .actual = identifier{"with2numbers3"}, .pos = {"", 1, 39} },
-      token{ .actual = identifier{"____"}, .pos = {"", 1, 53} }
+      expected_token{ .actual = identifier{"__ignored"}, .pos = {"", 1, 1} },
+      expected_token{ .actual = keyword::FUN, .pos = {"", 1, 11} },
+      expected_token{ .actual = identifier{"test"}, .pos = {"", 1, 15} },
+      expected_token{ .actual = keyword::VAR, .pos = {"", 1, 20} },
+      expected_token{ .actual = identifier{"_name"}, .pos = {"", 1, 24} },
+      expected_token{ .actual = keyword::CONTINUE, .pos = {"", 1, 30} },
+      expected_token{ .actual = identifier{"with2numbers3"}, .pos = {"", 1, 39} },
+      expected_token{ .actual = identifier{"____"}, .pos = {"", 1, 53} }
     };
 
     for(const auto &[actual, at] : tokens) {
       REQUIRE_FALSE(lex.is_eof());
       lex >> t;
       CAPTURE(t);
-      REQUIRE(t.actual.index() == actual.index());
-      if(is<identifier>(t.actual)) {
-        CHECK(std::get<identifier>(t.actual).ident == std::get<identifier>(actual).ident);
+      REQUIRE(t.value().index() == actual.index());
+      if(is<identifier>(t)) {
+        CHECK(as<identifier>(t).ident == std::get<identifier>(actual).ident);
       }
-      else if(is<keyword>(t.actual)) {
-        CHECK(std::get<keyword>(t.actual) == std::get<keyword>(actual));
+      else if(is<keyword>(t)) {
+        CHECK(as<keyword>(t) == std::get<keyword>(actual));
       }
-      CHECK(t.pos.line == at.line);
-      CHECK(t.pos.col == at.col);
+      CHECK(resolve(t.pos).line == at.line);
+      CHECK(resolve(t.pos).col == at.col);
     }
     lex >> t;
-    CHECK(is<eof>(t.actual));
+    CHECK(is<eof>(t));
     CHECK(lex.is_eof());
     REQUIRE(jayc::logger.phase_error() == 0);
   }
 
+  TEST_CASE("identifiers are interned") {
+    auto lex = lex_source("abc def abc");
+    token a, b, c;
+    lex >> a >> b >> c;
+    REQUIRE(is<identifier>(a));
+    REQUIRE(is<identifier>(b));
+    REQUIRE(is<identifier>(c));
+    CHECK(as<identifier>(a).ident.id() == as<identifier>(c).ident.id());
+    CHECK(as<identifier>(a).ident.id() != as<identifier>(b).ident.id());
+    CHECK(as<identifier>(c).ident.view() == "abc");
+    REQUIRE(jayc::logger.phase_error() == 0);
+  }
+
+  TEST_CASE("compact tokens round-trip") {
+    const std::vector<token_t> values = {
+      symbol::ARROW, keyword::VAL, identifier{"name"}, literal<int64_t>{-7}, literal<int64_t>{-(1ll << 40)},
+      literal<uint64_t>{7}, literal<uint64_t>{1ull << 63}, literal{1.5f}, literal{-2.25}, literal{'x'},
+      literal<std::string_view>{"text"}, literal{true}, eof{}
+    };
+
+    for(const auto &v : values) {
+      const token t{v, jayc::location{0, 3}};
+      CAPTURE(t);
+      CHECK(t.value() == v);
+      CHECK(t.pos.offset == 3);
+    }
+  }
+
   TEST_CASE("literals") {
     token t;
 
     auto lex1 = lex_source(bool_literal_source);
     REQUIRE_FALSE(lex1.is_eof());
     lex1 >> t;
-    REQUIRE(is<literal<bool>>(t.actual));
-    CHECK(std::get<literal<bool>>(t.actual).value);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<bool>>(t));
+    CHECK(as<literal<bool>>(t).value);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex1 >> t;
-    REQUIRE(is<literal<bool>>(t.actual));
-    CHECK_FALSE(std::get<literal<bool>>(t.actual).value);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 6);
+    REQUIRE(is<literal<bool>>(t));
+    CHECK_FALSE(as<literal<bool>>(t).value);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 6);
     REQUIRE(jayc::logger.phase_error() == 0);
 
     auto lex2 = lex_source(i64_literal_source);
     REQUIRE_FALSE(lex2.is_eof());
     lex2 >> t;
-    REQUIRE(is<literal<int64_t>>(t.actual));
-    CHECK(std::get<literal<int64_t>>(t.actual).value == -10);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<int64_t>>(t));
+    CHECK(as<literal<int64_t>>(t).value == -10);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex2 >> t;
-    REQUIRE(is<literal<int64_t>>(t.actual));
-    CHECK(std::get<literal<int64_t>>(t.actual).value == 123);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 5);
+    REQUIRE(is<literal<int64_t>>(t));
+    CHECK(as<literal<int64_t>>(t).value == 123);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 5);
     lex2 >> t;
-    REQUIRE(is<literal<int64_t>>(t.actual));
-    CHECK(std::get<literal<int64_t>>(t.actual).value == -589);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 9);
+    REQUIRE(is<literal<int64_t>>(t));
+    CHECK(as<literal<int64_t>>(t).value == -589);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 9);
     lex2 >> t;
-    REQUIRE(is<literal<int64_t>>(t.actual));
-    CHECK(std::get<literal<int64_t>>(t.actual).value == 12);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 14);
+    REQUIRE(is<literal<int64_t>>(t));
+    CHECK(as<literal<int64_t>>(t).value == 12);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 14);
     REQUIRE(jayc::logger.phase_error() == 0);
 
     auto lex3 = lex_source(ui64_literal_source);
     REQUIRE_FALSE(lex3.is_eof());
     lex3 >> t;
-    REQUIRE(is<literal<uint64_t>>(t.actual));
-    CHECK(std::get<literal<uint64_t>>(t.actual).value == 0x123);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<uint64_t>>(t));
+    CHECK(as<literal<uint64_t>>(t).value == 0x123);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex3 >> t;
-    REQUIRE(is<literal<uint64_t>>(t.actual));
-    CHECK(std::get<literal<uint64_t>>(t.actual).value == 0xabc);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 7);
+    REQUIRE(is<literal<uint64_t>>(t));
+    CHECK(as<literal<uint64_t>>(t).value == 0xabc);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 7);
     lex3 >> t;
-    REQUIRE(is<literal<uint64_t>>(t.actual));
-    CHECK(std::get<literal<uint64_t>>(t.actual).value == 0x123456abcDEF);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 13);
+    REQUIRE(is<literal<uint64_t>>(t));
+    CHECK(as<literal<uint64_t>>(t).value == 0x123456abcDEF);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 13);
     REQUIRE(jayc::logger.phase_error() == 0);
 
     auto lex4 = lex_source(f32_literal_source);
     REQUIRE_FALSE(lex4.is_eof());
     lex4 >> t;
-    REQUIRE(is<literal<float>>(t.actual));
-    CHECK(std::get<literal<float>>(t.actual).value == 123.0f);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<float>>(t));
+    CHECK(as<literal<float>>(t).value == 123.0f);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex4 >> t;
-    REQUIRE(is<literal<float>>(t.actual));
-    CHECK(std::get<literal<float>>(t.actual).value == -456.58f);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 8);
+    REQUIRE(is<literal<float>>(t));
+    CHECK(as<literal<float>>(t).value == -456.58f);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 8);
     REQUIRE(jayc::logger.phase_error() == 0);
 
     auto lex5 = lex_source(f64_literal_source);
     REQUIRE_FALSE(lex5.is_eof());
     lex5 >> t;
-    REQUIRE(is<literal<double>>(t.actual));
-    CHECK(std::get<literal<double>>(t.actual).value == 123.0);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<double>>(t));
+    CHECK(as<literal<double>>(t).value == 123.0);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex5 >> t;
-    REQUIRE(is<literal<double>>(t.actual));
-    CHECK(std::get<literal<double>>(t.actual).value == -456.58);
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 7);
+    REQUIRE(is<literal<double>>(t));
+    CHECK(as<literal<double>>(t).value == -456.58);
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 7);
+    REQUIRE(jayc::logger.phase_error() == 0);
+
+    auto lex_u = lex_source(unsigned_literal_source);
+    for(const uint64_t expected : { 0ull, 42ull, 18446744073709551615ull, 0xffull }) {
+      lex_u >> t;
+      REQUIRE(is<literal<uint64_t>>(t));
+      CHECK(as<literal<uint64_t>>(t).value == expected);
+    }
+    lex_u >> t;
+    REQUIRE(is<literal<double>>(t));
+    CHECK(as<literal<double>>(t).value == 0.5);
     REQUIRE(jayc::logger.phase_error() == 0);
 
     auto lex6 = lex_source(char_literal_source);
     REQUIRE_FALSE(lex6.is_eof());
     lex6 >> t;
-    REQUIRE(is<literal<char>>(t.actual));
-    CHECK(std::get<literal<char>>(t.actual).value == 'a');
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<char>>(t));
+    CHECK(as<literal<char>>(t).value == 'a');
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex6 >> t;
-    REQUIRE(is<literal<char>>(t.actual));
-    CHECK(std::get<literal<char>>(t.actual).value == 'c');
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 5);
+    REQUIRE(is<literal<char>>(t));
+    CHECK(as<literal<char>>(t).value == 'c');
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 5);
     lex6 >> t;
-    REQUIRE(is<literal<char>>(t.actual));
-    CHECK(std::get<literal<char>>(t.actual).value == '\n');
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 9);
+    REQUIRE(is<literal<char>>(t));
+    CHECK(as<literal<char>>(t).value == '\n');
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 9);
     lex6 >> t;
-    REQUIRE(is<literal<char>>(t.actual));
-    CHECK(std::get<literal<char>>(t.actual).value == '\'');
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 14);
+    REQUIRE(is<literal<char>>(t));
+    CHECK(as<literal<char>>(t).value == '\'');
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 14);
     lex6 >> t;
-    REQUIRE(is<literal<char>>(t.actual));
-    CHECK(std::get<literal<char>>(t.actual).value == '"');
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 19);
+    REQUIRE(is<literal<char>>(t));
+    CHECK(as<literal<char>>(t).value == '"');
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 19);
     REQUIRE(jayc::logger.phase_error() == 0);
 
     //          1         2
@@ -316,20 +367,20 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
     auto lex7 = lex_source(string_literal_source);
     REQUIRE_FALSE(lex7.is_eof());
     lex7 >> t;
-    REQUIRE(is<literal<std::string>>(t.actual));
-    CHECK(std::get<literal<std::string>>(t.actual).value == "abcd\n");
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 1);
+    REQUIRE(is<literal<std::string_view>>(t));
+    CHECK(as<literal<std::string_view>>(t).value == "abcd\n");
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 1);
     lex7 >> t;
-    REQUIRE(is<literal<std::string>>(t.actual));
-    CHECK(std::get<literal<std::string>>(t.actual).value == "this is a test");
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 10);
+    REQUIRE(is<literal<std::string_view>>(t));
+    CHECK(as<literal<std::string_view>>(t).value == "this is a test");
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 10);
     lex7 >> t;
-    REQUIRE(is<literal<std::string>>(t.actual));
-    CHECK(std::get<literal<std::string>>(t.actual).value == "");
-    CHECK(t.pos.line == 1);
-    CHECK(t.pos.col == 27);
+    REQUIRE(is<literal<std::string_view>>(t));
+    CHECK(as<literal<std::string_view>>(t).value == "");
+    CHECK(resolve(t.pos).line == 1);
+    CHECK(resolve(t.pos).col == 27);
     REQUIRE(jayc::logger.phase_error() == 0);
   }
 
@@ -340,35 +391,35 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
 
     std::string src = "<inline script>";
     std::vector expected = {
-      token{ .actual = identifier{"test"}, .pos = {src, 2, 1} },
-      token{ .actual = identifier{"something"}, .pos = {src, 2, 6} },
-      token{ .actual = identifier{"other"}, .pos = {src, 2, 16} },
-      token{ .actual = literal<int64_t>{123}, .pos = {src, 4, 1} },
-      token{ .actual = identifier{"_abcd"}, .pos = {src, 5, 1} },
-      token{ .actual = keyword::FUN, .pos = {src, 7, 1} },
-      token{ .actual = symbol::DIVIDE, .pos = {src, 7, 5} },
-      token{ .actual = symbol::DIVIDE, .pos = {src, 7, 7} },
-      token{ .actual = eof{}, .pos = {src, 8, 1} }
+      expected_token{ .actual = identifier{"test"}, .pos = {src, 2, 1} },
+      expected_token{ .actual = identifier{"something"}, .pos = {src, 2, 6} },
+      expected_token{ .actual = identifier{"other"}, .pos = {src, 2, 16} },
+      expected_token{ .actual = literal<int64_t>{123}, .pos = {src, 4, 1} },
+      expected_token{ .actual = identifier{"_abcd"}, .pos = {src, 5, 1} },
+      expected_token{ .actual = keyword::FUN, .pos = {src, 7, 1} },
+      expected_token{ .actual = symbol::DIVIDE, .pos = {src, 7, 5} },
+      expected_token{ .actual = symbol::DIVIDE, .pos = {src, 7, 7} },
+      expected_token{ .actual = eof{}, .pos = {src, 8, 1} }
     };
 
     for(const auto &[actual, pos]: expected) {
       lex >> t;
-      REQUIRE(t.actual.index() == actual.index());
+      REQUIRE(t.value().index() == actual.index());
       if(is<identifier>(actual)) {
-        CHECK(std::get<identifier>(t.actual).ident == std::get<identifier>(actual).ident);
+        CHECK(as<identifier>(t).ident == std::get<identifier>(actual).ident);
       }
       else if(is<literal<int64_t>>(actual)) {
-        CHECK(std::get<literal<int64_t>>(t.actual).value == std::get<literal<int64_t>>(actual).value);
+        CHECK(as<literal<int64_t>>(t).value == std::get<literal<int64_t>>(actual).value);
       }
       else if(is<keyword>(actual)) {
-        CHECK(std::get<keyword>(t.actual) == std::get<keyword>(actual));
+        CHECK(as<keyword>(t) == std::get<keyword>(actual));
       }
       else if(is<symbol>(actual)) {
-        CHECK(std::get<symbol>(t.actual) == std::get<symbol>(actual));
+        CHECK(as<symbol>(t) == std::get<symbol>(actual));
       }
-      CHECK(t.pos.file == pos.file);
-      CHECK(t.pos.line == pos.line);
-      CHECK(t.pos.col == pos.col);
+      CHECK(resolve(t.pos).file == pos.file);
+      CHECK(resolve(t.pos).line == pos.line);
+      CHECK(resolve(t.pos).col == pos.col);
     }
 
     CHECK(lex.is_eof());
@@ -381,43 +432,173 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
 
     const std::string src = "<inline script>";
     std::vector expected = {
-      token{ .actual = keyword::FUN, .pos = {src, 1, 7} },
-      token{ .actual = symbol::DIVIDE, .pos = {src, 1, 11} },
-      token{ .actual = symbol::MULTIPLY, .pos = {src, 1, 13} },
-      token{ .actual = symbol::MULTIPLY, .pos = {src, 1, 14} },
-      token{ .actual = symbol::DIVIDE, .pos = {src, 1, 15} },
-      token{ .actual = identifier{"something"}, .pos = {src, 3, 26} },
-      token{ .actual = symbol::PAREN_OPEN, .pos = {src, 7, 32} },
-      token{ .actual = symbol::PAREN_CLOSE, .pos = {src, 7, 33} },
-      token{ .actual = eof{}, .pos = {src, 8, 1} }
+      expected_token{ .actual = keyword::FUN, .pos = {src, 1, 7} },
+      expected_token{ .actual = symbol::DIVIDE, .pos = {src, 1, 11} },
+      expected_token{ .actual = symbol::MULTIPLY, .pos = {src, 1, 13} },
+      expected_token{ .actual = symbol::MULTIPLY, .pos = {src, 1, 14} },
+      expected_token{ .actual = symbol::DIVIDE, .pos = {src, 1, 15} },
+      expected_token{ .actual = identifier{"something"}, .pos = {src, 3, 26} },
+      expected_token{ .actual = symbol::PAREN_OPEN, .pos = {src, 7, 32} },
+      expected_token{ .actual = symbol::PAREN_CLOSE, .pos = {src, 7, 33} },
+      expected_token{ .actual = eof{}, .pos = {src, 8, 1} }
     };
 
     for(const auto &[actual, pos]: expected) {
       lex >> t;
-      REQUIRE(t.actual.index() == actual.index());
+      REQUIRE(t.value().index() == actual.index());
       if(is<identifier>(actual)) {
-        CHECK(std::get<identifier>(t.actual).ident == std::get<identifier>(actual).ident);
+        CHECK(as<identifier>(t).ident == std::get<identifier>(actual).ident);
       }
       else if(is<keyword>(actual)) {
-        CHECK(std::get<keyword>(t.actual) == std::get<keyword>(actual));
+        CHECK(as<keyword>(t) == std::get<keyword>(actual));
       }
       else if(is<symbol>(actual)) {
-        CHECK(std::get<symbol>(t.actual) == std::get<symbol>(actual));
+        CHECK(as<symbol>(t) == std::get<symbol>(actual));
       }
-      CHECK(t.pos.file == pos.file);
-      CHECK(t.pos.line == pos.line);
-      CHECK(t.pos.col == pos.col);
+      CHECK(resolve(t.pos).file == pos.file);
+      CHECK(resolve(t.pos).line == pos.line);
+      CHECK(resolve(t.pos).col == pos.col);
     }
 
     CHECK(lex.is_eof());
   }
 
+  TEST_CASE("scan kernels agree on every level") {
+    const std::string input = line_comment_source + block_comment_source + string_literal_source + "   \t\v\n  x";
+    const char *end = input.data() + input.size();
+    const auto original = scan::active_level();
+
+    std::vector<std::vector<const char *>> expected(4);
+    scan::force_level(scan::level::SCALAR);
+    for(const char *p = input.data(); p <= end; ++p) {
+      expected[0].push_back(scan::skip_whitespace(p, end));
+      expected[1].push_back(scan::find_newline(p, end));
+      expected[2].push_back(scan::find_comment_delim(p, end));
+      expected[3].push_back(scan::find_string_stop(p, end));
+    }
+    const size_t expected_newlines = scan::count_newlines(input.data(), end);
+
+    for(const auto l : { scan::level::SSE2, scan::level::AVX2 }) {
+      if(!scan::supported(l)) continue;
+      scan::force_level(l);
+      CAPTURE(static_cast<int>(l));
+      for(const char *p = input.data(); p <= end; ++p) {
+        const auto i = static_cast<size_t>(p - input.data());
+        CHECK(scan::skip_whitespace(p, end) == expected[0][i]);
+        CHECK(scan::find_newline(p, end) == expected[1][i]);
+        CHECK(scan::find_comment_delim(p, end) == expected[2][i]);
+        CHECK(scan::find_string_stop(p, end) == expected[3][i]);
+      }
+      CHECK(scan::count_newlines(input.data(), end) == expected_newlines);
+    }
+
+    scan::force_level(original);
+  }
+
+  TEST_CASE("batched fill matches streaming") {
+    const std::string script = TEST_SOURCE "/inputs/factorial.jay";
+    auto streaming = jayc::lexer::lex(script);
+    const auto batch = jayc::lexer::lex(script).drain();
+
+    REQUIRE_FALSE(batch.empty());
+    CHECK(is<eof>(batch.back()));
+    for(const auto &expected : batch) {
+      token t;
+      streaming >> t;
+      CHECK(t.value() == expected.value());
+      CHECK(t.pos.offset == expected.pos.offset);
+    }
+    CHECK(streaming.is_eof());
+  }
+
+  TEST_CASE("parallel lexing matches sequential") {
+    std::string source;
+    for(int i = 0; i < 40; i++) {
+      source += "var x" + std::to_string(i) + " = 0x" + std::to_string(i) + "u + 1.5 * 'c'; // it's a comment\n";
+      source += "/* a block comment\n  /* nested, with a 'quote\n and \"string */\n still inside */ fun\n";
+      source += "  \"a string\\n\" => -12 + " + std::to_string(i * 99) + ";\n\n";
+    }
+
+    const auto expected = lex_source(source).drain();
+    for(size_t chunks = 1; chunks <= 24; chunks++) {
+      CAPTURE(chunks);
+      const auto actual = lex_source_parallel(source, chunks);
+      REQUIRE(actual.size() == expected.size());
+      for(size_t i = 0; i < actual.size(); i++) {
+        CHECK(actual[i].value() == expected[i].value());
+        CHECK(actual[i].pos.offset == expected[i].pos.offset);
+      }
+    }
+    CHECK(jayc::logger.phase_error() == 0);
+  }
+
+  TEST_CASE("incremental re-lexing matches a full lex") {
+    const std::string base = "var abc = 12 + foo(\"str\", 'c');\n// comment\nfun bar() { return 1.5 * abc; }\nval z = 0x10u;\n";
+
+    const auto check = [&base](const std::vector<text_edit> &edits, const std::string &edited, const size_t max_changed) {
+      CAPTURE(edited);
+      auto strm = lex_source(base);
+      const auto previous = strm.drain();
+      const auto res = relex(previous.back().pos.file, previous, edits);
+      const auto expected = lex_source(edited).drain();
+
+      REQUIRE(res.tokens.size() == expected.size());
+      for(size_t i = 0; i < expected.size(); i++) {
+        CAPTURE(i);
+        CHECK(res.tokens[i].value() == expected[i].value());
+        CHECK(res.tokens[i].pos.offset == expected[i].pos.offset);
+      }
+      CHECK(res.new_end - res.first <= max_changed);
+      CHECK(res.tokens.size() - res.new_end == previous.size() - res.old_end);
+    };
+
+    // one character inside an identifier: only that token is re-lexed
+    check({ text_edit{ .offset = 5, .removed = 1, .inserted = "x" } }, "var axc = 12 + foo(\"str\", 'c');\n// comment\nfun bar() { return 1.5 * abc; }\nval z = 0x10u;\n", 2);
+    // growing a literal and inserting a token; the tokens in between are part of the reported range
+    check({ text_edit{ .offset = 10, .removed = 0, .inserted = "3" }, text_edit{ .offset = 62, .removed = 0, .inserted = "- " } },
+          "var abc = 312 + foo(\"str\", 'c');\n// comment\nfun bar() { return - 1.5 * abc; }\nval z = 0x10u;\n", 20);
+    // opening a block comment swallows everything up to the end
+    check({ text_edit{ .offset = 31, .removed = 0, .inserted = "/*" } },
+          "var abc = 12 + foo(\"str\", 'c');/*\n// comment\nfun bar() { return 1.5 * abc; }\nval z = 0x10u;\n", 2);
+    // removing the line comment marker turns the comment into tokens
+    check({ text_edit{ .offset = 32, .removed = 3 } },
+          "var abc = 12 + foo(\"str\", 'c');\ncomment\nfun bar() { return 1.5 * abc; }\nval z = 0x10u;\n", 2);
+    jayc::logger.next_phase();
+  }
+
+  TEST_CASE("token cache round-trip") {
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto source = (dir / "jayc_token_cache_test.jay").string();
+    const auto cache = (dir / "jayc_token_cache_test.jtok").string();
+    std::ofstream{source} << "val big = 0x123456789ABCDEFu + -5000000000 * 2.5 - 1.5f;\nfun f() { return \"text\\n\" + 'c' + big; }\n";
+
+    const auto expected = lex(source).drain();
+    REQUIRE(write_token_cache(cache, expected.back().pos.file, expected));
+
+    auto loaded = lex_cached(cache, source);
+    REQUIRE(loaded.has_value());
+    const auto actual = loaded->drain();
+    REQUIRE(actual.size() == expected.size());
+    for(size_t i = 0; i < actual.size(); i++) {
+      CHECK(actual[i].value() == expected[i].value());
+      CHECK(actual[i].pos.offset == expected[i].pos.offset);
+      CHECK(resolve(actual[i].pos).line == resolve(expected[i].pos).line);
+    }
+
+    // a changed source invalidates the cache
+    std::ofstream{source, std::ios::app} << "// edited\n";
+    CHECK_FALSE(lex_cached(cache, source).has_value());
+
+    std::filesystem::remove(source);
+    std::filesystem::remove(cache);
+  }
+
   TEST_CASE("factorial script") {
     const std::string script = TEST_SOURCE "/inputs/factorial.jay";
     auto lex = jayc::lexer::lex(script);
     token t;
 
-    std::vector<token> expected = {
+    std::vector<expected_token> expected = {
       //          1         2
       // 123456789012345678901234567
       // fun factorial(int x): int {
@@ -525,18 +706,18 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
     for(const auto &e : expected) {
       lex >> t;
       const auto &[actual, pos] = e;
-      SUBCASE(("Token at " + pos.file + "; line " + std::to_string(pos.line) + ":" + std::to_string(pos.col)).data()) {
+      SUBCASE(("Token at " + std::string{pos.file} + "; line " + std::to_string(pos.line) + ":" + std::to_string(pos.col)).data()) {
         CAPTURE(t);
         CAPTURE(e);
-        REQUIRE(t.actual.index() == actual.index());
-        if(is<keyword>(t.actual)) CHECK(as<keyword>(t.actual) == as<keyword>(actual));
-        else if(is<identifier>(t.actual)) CHECK(as<identifier>(t.actual).ident == as<identifier>(actual).ident);
-        else if(is<symbol>(t.actual)) CHECK(as<symbol>(t.actual) == as<symbol>(actual));
-        else if(is<literal<int64_t>>(t.actual)) CHECK(as<literal<int64_t>>(t.actual).value == as<literal<int64_t>>(actual).value);
-
-        CHECK(t.pos.file == pos.file);
-        CHECK(t.pos.line == pos.line);
-        CHECK(t.pos.col == pos.col);
+        REQUIRE(t.value().index() == actual.index());
+        if(is<keyword>(t)) CHECK(as<keyword>(t) == as<keyword>(actual));
+        else if(is<identifier>(t)) CHECK(as<identifier>(t).ident == as<identifier>(actual).ident);
+        else if(is<symbol>(t)) CHECK(as<symbol>(t) == as<symbol>(actual));
+        else if(is<literal<int64_t>>(t)) CHECK(as<literal<int64_t>>(t).value == as<literal<int64_t>>(actual).value);
+
+        CHECK(resolve(t.pos).file == pos.file);
+        CHECK(resolve(t.pos).line == pos.line);
+        CHECK(resolve(t.pos).col == pos.col);
       }
     }
     CHECK(lex.is_eof());
@@ -544,6 +725,18 @@ TEST_SUITE("jayc - lexer (lexing okay)") {
 }
 
 TEST_SUITE("jayc - lexer (lexing fails)") {
+  TEST_CASE("numeric literal out of range") {
+    for(const auto *src : { "9223372036854775808", "18446744073709551616u", "0x10000000000000000", "-1u" }) {
+      CAPTURE(src);
+      auto lex = lex_source(src);
+      token t;
+      lex >> t; // the invalid literal is skipped by the stream
+      CHECK(is<eof>(t));
+      CHECK(jayc::logger.phase_error() == 1);
+      jayc::logger.next_phase();
+    }
+  }
+
   // TODO: tests with invalid input:
   //  -> unterminated string literal
   //  -> unterminated character literal
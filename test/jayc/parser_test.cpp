@@ -6,9 +6,16 @@
 #include <sstream>
 #include <algorithm>
 #include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 #include <doctest/doctest.h>
 
 #include "parser/parser.hpp"
+#include "parser/ast_output.hpp"
+#include "parser/flat_ast.hpp"
+#include "parser/ast_cache.hpp"
+#include "parser/ast_hash.hpp"
 #include "parser/ast.hpp"
 #include "parser/parse_error.hpp"
 
@@ -107,7 +114,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
         token{literal{158.9}, {}},
         token{literal{true}, {}},
         token{literal{'@'}, {}},
-        token{literal<std::string>{"hello!"}, {}},
+        token{literal<std::string_view>{"hello!"}, {}},
       };
       const vec_source source(tokens);
       auto it = token_it(source);
@@ -144,19 +151,19 @@ TEST_SUITE("jayc - parser (parsing okay)") {
 
       res = parse_expr(it);
       REQUIRE(res.has_value());
-      CHECK(is<literal_expr<std::string>>(res->content));
-      CHECK(as<literal_expr<std::string>>(res->content).value == "hello!");
+      CHECK(is<literal_expr<std::string_view>>(res->content));
+      CHECK(as<literal_expr<std::string_view>>(res->content).value == "hello!");
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("(qualified) identifier expression") {
       const vec_source source({
-        {identifier{"a"}, {"", 1, 1}},
-        {symbol{symbol::NAMESPACE}, {"", 1, 2}},
-        {identifier{"b"}, {"", 1, 3}},
-        {symbol{symbol::NAMESPACE}, {"", 1, 3}},
-        {identifier{"c"}, {"", 1, 4}},
+        {identifier{"a"}, {0, 1}},
+        {symbol{symbol::NAMESPACE}, {0, 2}},
+        {identifier{"b"}, {0, 3}},
+        {symbol{symbol::NAMESPACE}, {0, 3}},
+        {identifier{"c"}, {0, 4}},
       });
 
       auto it = token_it(source);
@@ -174,7 +181,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
         }, .is_array = false
       });
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("trivial unary prefix expressions") {
@@ -189,7 +196,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
 
       for(const auto &[op, tok] : ops) {
         const vec_source source({
-          {tok, {"", 1, 1}},
+          {tok, {0, 1}},
           {literal<int64_t>{12}}
         });
 
@@ -202,7 +209,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
         CHECK(is<literal_expr<int64_t>>(arg.content));
         CHECK(as<literal_expr<int64_t>>(arg.content).value == 12);
 
-        CHECK(is<eof>(it->actual));
+        CHECK(is<eof>(*it));
       }
     }
 
@@ -215,7 +222,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       for(const auto &[op, tok] : ops) {
         const vec_source source({
           {literal<int64_t>{12}},
-          {tok, {"", 1, 1}},
+          {tok, {0, 1}},
         });
 
         auto it = token_it(source);
@@ -227,7 +234,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
         CHECK(is<literal_expr<int64_t>>(arg.content));
         CHECK(as<literal_expr<int64_t>>(arg.content).value == 12);
 
-        CHECK(is<eof>(it->actual));
+        CHECK(is<eof>(*it));
       }
     }
 
@@ -264,9 +271,9 @@ TEST_SUITE("jayc - parser (parsing okay)") {
 
       for(const auto &[op, tok] : ops) {
         const vec_source source({
-          {literal<int64_t>{12}, {"", 1, 0}},
-          {tok, {"", 1, 1}},
-          {identifier{"x"}, {"", 1, 2}}
+          {literal<int64_t>{12}, {0, 0}},
+          {tok, {0, 1}},
+          {identifier{"x"}, {0, 2}}
         });
 
         auto it = token_it(source);
@@ -282,17 +289,17 @@ TEST_SUITE("jayc - parser (parsing okay)") {
         CHECK(is<name_expr>(right.content));
         CHECK(as<name_expr>(right.content).actual == single_name("x"));
 
-        CHECK(is<eof>(it->actual));
+        CHECK(is<eof>(*it));
       }
     }
 
     SUBCASE("trivial ternary expression") {
       const vec_source source({
-        {literal<int64_t>{12}, {"", 1, 0}},
-        {symbol{symbol::QUESTION}, {"", 1, 1}},
-        {identifier{"x"}, {"", 1, 2}},
-        {symbol{symbol::COLON}, {"", 1, 3}},
-        {identifier{"y"}, {"", 1, 4}}
+        {literal<int64_t>{12}, {0, 0}},
+        {symbol{symbol::QUESTION}, {0, 1}},
+        {identifier{"x"}, {0, 2}},
+        {symbol{symbol::COLON}, {0, 3}},
+        {identifier{"y"}, {0, 4}}
       });
       auto it = token_it(source);
       auto res = parse_expr(it);
@@ -311,14 +318,14 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(is<name_expr>(false_expr.content));
       CHECK(as<name_expr>(false_expr.content).actual == single_name("y"));
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("trivial parenthesized expressions") {
       const vec_source source1({
-        {symbol{symbol::PAREN_OPEN}, {"", 1, 0}},
-        {literal<int64_t>{12}, {"", 1, 1}},
-        {symbol{symbol::PAREN_CLOSE}, {"", 1, 2}}
+        {symbol{symbol::PAREN_OPEN}, {0, 0}},
+        {literal<int64_t>{12}, {0, 1}},
+        {symbol{symbol::PAREN_CLOSE}, {0, 2}}
       });
       auto it = token_it(source1);
       auto res = parse_expr(it);
@@ -326,14 +333,14 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(is<literal_expr<int64_t>>(res->content));
       CHECK(as<literal_expr<int64_t>>(res->content).value == 12);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
 
       const vec_source source2({
-        {symbol{symbol::PAREN_OPEN}, {"", 1, 0}},
-        {identifier{"x"}, {"", 1, 1}},
-        {symbol{symbol::PLUS}, {"", 1, 2}},
-        {identifier{"y"}, {"", 1, 3}},
-        {symbol{symbol::PAREN_CLOSE}, {"", 1, 4}}
+        {symbol{symbol::PAREN_OPEN}, {0, 0}},
+        {identifier{"x"}, {0, 1}},
+        {symbol{symbol::PLUS}, {0, 2}},
+        {identifier{"y"}, {0, 3}},
+        {symbol{symbol::PAREN_CLOSE}, {0, 4}}
       });
       it = token_it(source2);
       res = parse_expr(it);
@@ -349,7 +356,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(is<name_expr>(right.content));
       CHECK(as<name_expr>(right.content).actual == single_name("y"));
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("priority 1: RTL tree (increasing priorities)") {
@@ -409,7 +416,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(is<literal_expr<int64_t>>(curr->content));
       CHECK(as<literal_expr<int64_t>>(curr->content).value == 11);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("priority 2: LTR tree (decreasing priorities)") {
@@ -449,14 +456,14 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(is<literal_expr<int64_t>>(curr->content));
       CHECK(as<literal_expr<int64_t>>(curr->content).value == 1);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("no-args call expression") {
       const vec_source source({
-        {identifier{"a"}, {"", 1, 1}},
-        {symbol{symbol::PAREN_OPEN}, {"", 1, 2}},
-        {symbol{symbol::PAREN_CLOSE}, {"", 1, 3}}
+        {identifier{"a"}, {0, 1}},
+        {symbol{symbol::PAREN_OPEN}, {0, 2}},
+        {symbol{symbol::PAREN_CLOSE}, {0, 3}}
       });
 
       auto it = token_it(source);
@@ -470,15 +477,15 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(name.actual == single_name("a"));
       CHECK(args.empty());
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("single-arg call expression") {
       const vec_source source({
-        {identifier{"a"}, {"", 1, 1}},
-        {symbol{symbol::PAREN_OPEN}, {"", 1, 2}},
-        {identifier{"b"}, {"", 1, 3}},
-        {symbol{symbol::PAREN_CLOSE}, {"", 1, 4}}
+        {identifier{"a"}, {0, 1}},
+        {symbol{symbol::PAREN_OPEN}, {0, 2}},
+        {identifier{"b"}, {0, 3}},
+        {symbol{symbol::PAREN_CLOSE}, {0, 4}}
       });
 
       auto it = token_it(source);
@@ -496,26 +503,26 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       const auto &arg = as<name_expr>(args[0].content);
       CHECK(arg.actual == single_name("b"));
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("multi-arg call expression") {
       // method(arg::no1, 1 + 2 * 4, "test")
       const vec_source source({
-        {identifier{"method"}, {"", 1, 1}},
-        {symbol{symbol::PAREN_OPEN}, {"", 1, 7}},
-        {identifier{"arg"}, {"", 1, 8}},
-        {symbol{symbol::NAMESPACE}, {"", 1, 9}},
-        {identifier{"no1"}, {"", 1, 10}},
-        {symbol{symbol::COMMA}, {"", 1, 11}},
-        {literal<int64_t>{1}, {"", 1, 13}},
-        {symbol{symbol::PLUS}, {"", 1, 14}},
-        {literal<int64_t>{2}, {"", 1, 15}},
-        {symbol{symbol::MULTIPLY}, {"", 1, 16}},
-        {literal<int64_t>{4}, {"", 1, 18}},
-        {symbol{symbol::COMMA}, {"", 1, 19}},
-        {literal<std::string>{"test"}, {"", 1, 21}},
-        {symbol{symbol::PAREN_CLOSE}, {"", 1, 28}}
+        {identifier{"method"}, {0, 1}},
+        {symbol{symbol::PAREN_OPEN}, {0, 7}},
+        {identifier{"arg"}, {0, 8}},
+        {symbol{symbol::NAMESPACE}, {0, 9}},
+        {identifier{"no1"}, {0, 10}},
+        {symbol{symbol::COMMA}, {0, 11}},
+        {literal<int64_t>{1}, {0, 13}},
+        {symbol{symbol::PLUS}, {0, 14}},
+        {literal<int64_t>{2}, {0, 15}},
+        {symbol{symbol::MULTIPLY}, {0, 16}},
+        {literal<int64_t>{4}, {0, 18}},
+        {symbol{symbol::COMMA}, {0, 19}},
+        {literal<std::string_view>{"test"}, {0, 21}},
+        {symbol{symbol::PAREN_CLOSE}, {0, 28}}
       });
 
       auto it = token_it(source);
@@ -559,12 +566,12 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       const auto &arg2_right_right = as<literal_expr<int64_t>>(arg2_right.right->content);
       CHECK(arg2_right_right.value == 4);
 
-      REQUIRE(is<literal_expr<std::string>>(args[2].content));
+      REQUIRE(is<literal_expr<std::string_view>>(args[2].content));
       // ReSharper disable once CppUseStructuredBinding
-      const auto &arg3 = as<literal_expr<std::string>>(args[2].content);
+      const auto &arg3 = as<literal_expr<std::string_view>>(args[2].content);
       CHECK(arg3.value == "test");
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("index expression (nested)") {
@@ -578,7 +585,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
         {symbol::BRACKET_OPEN, {}},
         {identifier{"get_int_arr"}, {}},
         {symbol::PAREN_OPEN, {}},
-        {literal<std::string>{"test"}, {}},
+        {literal<std::string_view>{"test"}, {}},
         {symbol::PAREN_CLOSE, {}},
         {symbol::BRACKET_OPEN, {}},
         {literal<int64_t>{3}, {}},
@@ -620,8 +627,8 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(as<call_expr>(get_int_arr_call->content).args.size() == 1);
       const auto &get_int_arr_args = as<call_expr>(get_int_arr_call->content).args;
 
-      REQUIRE(is<literal_expr<std::string>>(get_int_arr_args[0].content));
-      CHECK(as<literal_expr<std::string>>(get_int_arr_args[0].content).value == "test");
+      REQUIRE(is<literal_expr<std::string_view>>(get_int_arr_args[0].content));
+      CHECK(as<literal_expr<std::string_view>>(get_int_arr_args[0].content).value == "test");
 
       const auto &three = as<index_expr>(idx_expr->content).index;
       REQUIRE(is<literal_expr<int64_t>>(three->content));
@@ -631,7 +638,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(is<literal_expr<int64_t>>(zero->content));
       CHECK(as<literal_expr<int64_t>>(zero->content).value == 0);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("member-call-member") {
@@ -756,7 +763,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
 
       CHECK(bool_shift_expr.op == binary_op::SHIFT_LEFT);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("Bernouilli") {
@@ -870,6 +877,425 @@ TEST_SUITE("jayc - parser (parsing okay)") {
     }
   }
 
+  TEST_CASE("pipelined lexer feeds the same tokens") {
+    std::string source = "{\n";
+    for(size_t i = 0; i < token_pipe::chunk_size; i++) source += "  x" + std::to_string(i) + " += 1;\n";
+    source += "}\n";
+
+    const auto expected = lex_source(source).drain();
+    token_pipe pipe{lex_source(source)};
+    auto it = token_it(pipe);
+    for(const auto &t : expected) {
+      REQUIRE(it->value() == t.value());
+      CHECK(it->pos.offset == t.pos.offset);
+      it.consume();
+    }
+    CHECK(it.eof());
+
+    token_pipe reparse{lex_source(source)};
+    auto it2 = token_it(reparse);
+    const auto res = parse_stmt(it2);
+    REQUIRE(res.has_value());
+    CHECK(it2.eof());
+  }
+
+  TEST_CASE("long left-associative chains") {
+    constexpr size_t length = 5000;
+    std::string source = "a0";
+    for(size_t i = 1; i < length; i++) source += " - a" + std::to_string(i);
+    auto it = token_it(lex_source(source).drain());
+    const auto res = parse_expr(it);
+    REQUIRE(res.has_value());
+    CHECK(it.eof());
+
+    // ((a0 - a1) - a2) - ...: walk down the left spine
+    const expression *current = &*res;
+    for(size_t i = length - 1; i > 0; i--) {
+      REQUIRE(is<binary_expr>(current->content));
+      const auto &sub = as<binary_expr>(current->content);
+      CHECK(sub.op == binary_op::SUBTRACT);
+      REQUIRE(is<name_expr>(sub.right->content));
+      CHECK(as<name_expr>(sub.right->content).actual == single_name("a" + std::to_string(i)));
+      current = &*sub.left;
+    }
+    REQUIRE(is<name_expr>(current->content));
+    CHECK(as<name_expr>(current->content).actual == single_name("a0"));
+  }
+
+  TEST_CASE("modules own their nodes") {
+    const auto module = [] {
+      auto it = token_it(lex_source("val answer = f(\"a rather long string literal\", 42);").drain());
+      return build_ast(it);
+    }(); // the iterator is gone, but its arena lives on in the module
+
+    CHECK(module.nodes->bytes_used() > 0);
+    REQUIRE(module.declarations.size() == 1);
+    REQUIRE(is<global_decl>(module.declarations[0].content));
+    const auto &value = as<global_decl>(module.declarations[0].content).value;
+    REQUIRE(is<call_expr>(value.content));
+    const auto &call = as<call_expr>(value.content);
+    REQUIRE(is<name_expr>(call.call->content));
+    CHECK(as<name_expr>(call.call->content).actual == single_name("f"));
+    REQUIRE(call.args.size() == 2);
+    REQUIRE(is<literal_expr<std::string_view>>(call.args[0].content));
+    CHECK(as<literal_expr<std::string_view>>(call.args[0].content).value == "a rather long string literal");
+    CHECK(call.args.get_allocator().source() == module.nodes.get());
+  }
+
+  TEST_CASE("template arguments") {
+    auto it = token_it(lex_source("fun <T: a & b::c, U> f(x: T): U => x;").drain());
+    const auto module = build_ast(it);
+    REQUIRE(logger.phase_error() == 0);
+    REQUIRE(module.declarations.size() == 1);
+    REQUIRE(is<template_function_decl>(module.declarations[0].content));
+    const auto &args = as<template_function_decl>(module.declarations[0].content).template_args;
+    REQUIRE(args.size() == 2);
+    CHECK(args[0].arg_name == jaydk::interned{"T"});
+    REQUIRE(args[0].constraints.size() == 2);
+    CHECK(args[0].constraints[0] == single_name("a"));
+    CHECK(args[0].constraints[1] == linear_name({"b", "c"}));
+    CHECK(args[1].arg_name == jaydk::interned{"U"});
+    CHECK(args[1].constraints.empty());
+  }
+
+  TEST_CASE("function with a block body") {
+    auto it = token_it(lex_source("fun f(x: int) { var y = x; return y; }").drain());
+    const auto module = build_ast(it);
+    REQUIRE(logger.phase_error() == 0);
+    REQUIRE(module.declarations.size() == 1);
+    REQUIRE(is<function_decl>(module.declarations[0].content));
+    const auto &fn = as<function_decl>(module.declarations[0].content);
+    CHECK(fn.function_name == jaydk::interned{"f"});
+    REQUIRE(fn.args.size() == 1);
+    CHECK(fn.args[0].arg_name == jaydk::interned{"x"});
+    REQUIRE(fn.body.size() == 2); // the first statement keeps its first token
+    REQUIRE(is<var_decl_stmt>(fn.body.statements()[0].content));
+    CHECK(as<var_decl_stmt>(fn.body.statements()[0].content).var_name == jaydk::interned{"y"});
+    CHECK(is<return_stmt>(fn.body.statements()[1].content));
+  }
+
+  TEST_CASE("global declarations") {
+    auto it = token_it(lex_source("var x = 1; val y: int = x;").drain());
+    const auto module = build_ast(it);
+    REQUIRE(logger.phase_error() == 0);
+    REQUIRE(module.declarations.size() == 2);
+    REQUIRE(is<global_decl>(module.declarations[0].content));
+    const auto &x = as<global_decl>(module.declarations[0].content);
+    CHECK(x.glob_name == jaydk::interned{"x"});
+    CHECK(x.is_mutable);
+    CHECK(!x.type.has_value());
+    REQUIRE(is<literal_expr<int64_t>>(x.value.content));
+    CHECK(as<literal_expr<int64_t>>(x.value.content).value == 1);
+    REQUIRE(is<global_decl>(module.declarations[1].content));
+    const auto &y = as<global_decl>(module.declarations[1].content);
+    CHECK(y.glob_name == jaydk::interned{"y"});
+    CHECK(!y.is_mutable);
+    REQUIRE(y.type.has_value());
+    CHECK(*y.type == single_name("int"));
+  }
+
+  TEST_CASE("recovery from a bad declaration") {
+    auto it = token_it(lex_source(
+      "namespace a { fun f() { return 1; } var = 3; fun g() { return 2; } } fun h() { return 3; }"
+    ).drain());
+    std::vector<error_queue::message> messages;
+    const error_queue::capture guard{messages};
+    const auto module = build_ast(it);
+    CHECK(messages.size() == 1);
+    REQUIRE(module.declarations.size() == 2);
+    REQUIRE(is<namespace_decl>(module.declarations[0].content));
+    const auto &ns = as<namespace_decl>(module.declarations[0].content);
+    CHECK(ns.name == jaydk::interned{"a"});
+    REQUIRE(ns.declarations.size() == 2);
+    REQUIRE(is<function_decl>(ns.declarations[0].content));
+    CHECK(as<function_decl>(ns.declarations[0].content).function_name == jaydk::interned{"f"});
+    REQUIRE(is<function_decl>(ns.declarations[1].content));
+    CHECK(as<function_decl>(ns.declarations[1].content).function_name == jaydk::interned{"g"});
+    REQUIRE(is<function_decl>(module.declarations[1].content));
+    CHECK(as<function_decl>(module.declarations[1].content).function_name == jaydk::interned{"h"});
+  }
+
+  TEST_CASE("flattened modules") {
+    using namespace jayc::parser::flat;
+    auto it = token_it(lex_source(
+      "namespace a { val x = 1 + f(2, \"s\"); }\n"
+      "fun g(y: int): int { if(y) return y; else return; }"
+    ).drain());
+    const auto module = build_ast(it);
+    const auto tree = flatten(module);
+
+    using enum node_kind;
+    const std::vector<node_kind> expected{
+      NAMESPACE, // (root)
+        NAMESPACE, GLOBAL, BINARY, INT_LITERAL, CALL, NAME, INT_LITERAL, STRING_LITERAL,
+        FUNCTION, IF, NAME, RETURN, NAME, RETURN
+    };
+    REQUIRE(tree.kind == expected);
+    CHECK(tree.subtree_end[0] == tree.size());
+    CHECK(tree.child_count(0) == 2);
+    CHECK(tree.child(0, 1) == 9);
+
+    CHECK(tree.ident(1) == jaydk::interned{"a"});
+    const auto &global = tree.variables[tree.payload[2]];
+    CHECK(global.var_name == jaydk::interned{"x"});
+    CHECK_FALSE(global.is_mutable);
+    CHECK(tree.binary(3) == binary_op::ADD);
+    CHECK(tree.int_value(4) == 1);
+    CHECK(tree.child_count(5) == 3);
+    CHECK(tree.to_name(tree.payload[6]) == single_name("f"));
+    CHECK(tree.string_value(8) == "s");
+
+    const auto &fn = tree.functions[tree.payload[9]];
+    CHECK(fn.function_name == jaydk::interned{"g"});
+    REQUIRE(fn.args.size() == 1);
+    CHECK(tree.to_name(tree.args[fn.args.begin].type) == single_name("int"));
+    CHECK(tree.to_name(fn.return_type) == single_name("int"));
+    CHECK(tree.child_count(10) == 3); // condition, then, else
+    CHECK(tree.child_count(14) == 0); // bare return
+
+    struct recorder {
+      std::vector<node_id> entered;
+      std::vector<node_id> left;
+      bool enter(const flat_ast &t, const node_id id) { entered.push_back(id); return t.kind[id] != GLOBAL; }
+      void leave(const flat_ast &, const node_id id) { left.push_back(id); }
+    } rec;
+    visit(tree, rec);
+    CHECK(rec.entered == std::vector<node_id>{ 0, 1, 2, 9, 10, 11, 12, 13, 14 });
+    CHECK(rec.left == std::vector<node_id>{ 1, 11, 13, 12, 14, 10, 9, 0 }); // no leave for skipped nodes
+  }
+
+  TEST_CASE("binary AST round-trip") {
+    using namespace jayc::parser::flat;
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto source = (dir / "jayc_ast_cache_test.jay").string();
+    const auto cache = (dir / "jayc_ast_cache_test.jast").string();
+    std::ofstream{source} <<
+      "namespace a { val x = 1 + f(2, \"s\"); fun <T: b::c> m(y: T[]): T => y; }\n"
+      "fun <U: any> int.g(y: int, z: a::t<U>[]): int { for(q : y) { return q.w; } return 2.5 * 'c'; }\n";
+
+    auto it = token_it(lex(source).drain());
+    const auto module = build_ast(it);
+    REQUIRE(logger.phase_error() == 0);
+    auto expected = flatten(module);
+    REQUIRE(write_ast_cache(cache, source, expected));
+
+    const auto loaded = mapped_ast::load(cache, source);
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->size() == expected.size());
+    CHECK(loaded->kind(0) == node_kind::NAMESPACE);
+    CHECK(loaded->ident(1) == jaydk::interned{"a"});
+    CHECK(resolve(loaded->pos(1)).line == resolve(expected.pos[1]).line);
+
+    // the source is registered again on load, so only the file IDs may differ
+    const auto file = loaded->pos(1).file; // (the root has no location)
+    for(auto &p : expected.pos) if(p.file != 0) p.file = file;
+    for(auto &a : expected.args) if(a.pos.file != 0) a.pos.file = file;
+    CHECK(loaded->to_flat() == expected);
+
+    // a changed source invalidates the binary AST
+    std::ofstream{source, std::ios::app} << "// edited\n";
+    CHECK_FALSE(mapped_ast::load(cache, source).has_value());
+
+    std::filesystem::remove(source);
+    std::filesystem::remove(cache);
+  }
+
+  TEST_CASE("structural hashes") {
+    const auto parse = [](const std::string &source, const bool lazy = false) {
+      auto it = token_it(lex_source(source).drain());
+      it.defer_bodies(lazy);
+      return build_ast(it);
+    };
+    const std::string source =
+      "namespace a { val x = 1 + f(2, \"s\"); fun g(y: int): int { return y * 2; } }\n"
+      "fun h() { var z = 3; }\n"
+      "fun int.k() => 1;\n";
+    const std::string moved =
+      "\n// same code, laid out differently\n"
+      "namespace a {\n  val x = 1+f(2,\"s\");\n  fun g(y: int): int {\n    return y*2;\n  }\n}\n"
+      "fun h() { var z = 3; } fun int.k() => 1;\n";
+
+    const auto original = parse(source);
+    const auto same = parse(moved);
+    CHECK(hash_of(original) == hash_of(same));
+    CHECK(diff_declarations(original, same).empty());
+    CHECK(parse("val p = 1 + 2;").declarations[0].hash != parse("val p = 2 + 1;").declarations[0].hash);
+
+    const auto edited = parse(
+      "namespace a { val x = 1 + f(2, \"s\"); fun g(y: int): int { return y * 3; } }\n"
+      "fun int.k() => 1;\n"
+      "fun n() {}\n"
+    );
+    CHECK(hash_of(edited) != hash_of(original));
+    const auto changes = diff_declarations(original, edited);
+    REQUIRE(changes.size() == 3);
+    CHECK(changes[0].kind == decl_change_kind::CHANGED);
+    CHECK(changes[0].path == "a::g");
+    CHECK(changes[1].kind == decl_change_kind::ADDED);
+    CHECK(changes[1].path == "n");
+    CHECK(changes[2].kind == decl_change_kind::REMOVED);
+    CHECK(changes[2].path == "h");
+
+    // deferred bodies hash their tokens, so materialising one doesn't change its hash
+    const auto lazy = parse(source, true);
+    const auto &body = as<function_decl>(lazy.declarations[1].content).body;
+    const auto before = body.hash();
+    CHECK(body.size() == 1);
+    CHECK(body.hash() == before);
+    CHECK(hash_of(lazy) == hash_of(parse(moved, true)));
+  }
+
+  TEST_CASE("parallel parsing matches sequential parsing") {
+    std::string source;
+    for(size_t i = 0; i < 40; i++) {
+      const auto n = std::to_string(i);
+      source += "namespace a" + n + " { namespace b { val x = 1 + f(2, \"s\"); } fun h() => x" + n + "; }\n";
+      source += "fun g" + n + "(y: int): int { if(y) { return y; } else return; }\n";
+    }
+    const auto tokens = lex_source(source).drain();
+
+    const auto print = [](const ast &module) { std::stringstream out; out << module; return out.str(); };
+    auto it = token_it(tokens);
+    const auto sequential = build_ast(it);
+    const auto parallel = build_ast_parallel(tokens, 4);
+    CHECK(parallel.declarations.size() == 80);
+    CHECK(parallel.shards.size() == 3);
+    CHECK(print(parallel) == print(sequential));
+
+    // a broken declaration sends the whole module through the sequential parser, with the same diagnostics
+    const auto broken = lex_source(source + "val = ;\n" + source).drain();
+    std::vector<error_queue::message> expected, actual;
+    {
+      const error_queue::capture guard{expected};
+      auto broken_it = token_it(broken);
+      (void)build_ast(broken_it);
+    }
+    {
+      const error_queue::capture guard{actual};
+      (void)build_ast_parallel(broken, 4);
+    }
+    REQUIRE(!expected.empty());
+    REQUIRE(actual.size() == expected.size());
+    for(size_t i = 0; i < actual.size(); i++) {
+      CHECK(as<error>(actual[i]).loc == as<error>(expected[i]).loc);
+      CHECK(as<error>(actual[i]).message == as<error>(expected[i]).message);
+    }
+  }
+
+  TEST_CASE("lazy function bodies") {
+    const std::string source =
+      "namespace a { fun f(x: int): int { if(x) { return x + 1; } else { return f(x - 1); } } }\n"
+      "fun g(y: int): int => y * 2;\n"
+      "fun h() { var z = g(3); { z += 1; } }\n";
+    const auto tokens = lex_source(source).drain();
+    const auto print = [](const ast &module) { std::stringstream out; out << module; return out.str(); };
+
+    auto eager_it = token_it(tokens);
+    const auto eager = build_ast(eager_it);
+    auto lazy_it = token_it(tokens);
+    lazy_it.defer_bodies();
+    const auto lazy = build_ast(lazy_it);
+
+    REQUIRE(lazy.declarations.size() == 3);
+    const auto &f = as<function_decl>(as<namespace_decl>(lazy.declarations[0].content).declarations[0].content);
+    const auto &g = as<function_decl>(lazy.declarations[1].content);
+    CHECK(!f.body.is_materialised());
+    CHECK(g.body.is_materialised()); // `=>` bodies are always parsed
+    CHECK(lazy.nodes->bytes_used() < eager.nodes->bytes_used());
+
+    CHECK(print(lazy) == print(eager));
+    CHECK(f.body.is_materialised());
+    CHECK(f.body.size() == 1);
+
+    // different bodies of one module materialised from several threads at once
+    std::string many;
+    for(size_t i = 0; i < 64; i++) many += "fun f" + std::to_string(i) + "(x: int) { var y = x * 2; { y += x; } }\n";
+    const auto many_tokens = lex_source(many).drain();
+    auto many_eager_it = token_it(many_tokens);
+    const auto many_eager = build_ast(many_eager_it);
+    auto many_lazy_it = token_it(many_tokens);
+    many_lazy_it.defer_bodies();
+    const auto many_lazy = build_ast(many_lazy_it);
+    std::vector<std::thread> workers;
+    for(size_t t = 0; t < 4; t++) {
+      workers.emplace_back([&many_lazy, t] {
+        const auto &decls = many_lazy.declarations;
+        for(size_t i = 0; i < decls.size(); i++) {
+          (void)as<function_decl>(decls[(i * 7 + t * 16) % decls.size()].content).body.statements();
+        }
+      });
+    }
+    for(auto &w : workers) w.join();
+    CHECK(print(many_lazy) == print(many_eager));
+
+    // errors in a deferred body only surface once it's parsed
+    auto broken_it = token_it(lex_source("fun k() { val a = 1; return 1 }").drain());
+    broken_it.defer_bodies();
+    std::vector<error_queue::message> messages;
+    const error_queue::capture guard{messages};
+    const auto broken = build_ast(broken_it);
+    REQUIRE(broken.declarations.size() == 1);
+    CHECK(messages.empty());
+    const auto &broken_body = as<function_decl>(broken.declarations[0].content).body;
+    CHECK(broken_body.failed());
+    CHECK(!messages.empty());
+    CHECK(broken_body.empty()); // not just the statements before the error
+  }
+
+  TEST_CASE("tracing records structured parser events") {
+    if(!trace_compiled) return;
+    auto it = token_it(lex_source("val x = 1;").drain()); // lexed before tracing is on
+    traces.clear();
+    traces.enable(trace_category::PARSER);
+    const auto module = build_ast(it);
+    traces.disable_all();
+
+    REQUIRE(module.declarations.size() == 1);
+    REQUIRE(traces.size() == 6); // val x = 1 ; + the declaration
+    for(size_t i = 0; i < traces.size(); i++) {
+      CHECK(traces.at(i).category == trace_category::PARSER);
+      CHECK(traces.at(i).sequence == i);
+    }
+    CHECK(traces.at(0).event == trace_event::TOKEN_CONSUMED);
+    CHECK(traces.at(0).extra == (static_cast<uint8_t>(token_kind::KEYWORD) | static_cast<uint8_t>(keyword::VAL) << 8));
+    CHECK(traces.at(5).event == trace_event::DECLARATION_PARSED);
+    CHECK(traces.at(5).pos == traces.at(0).pos);
+
+    std::stringstream out;
+    traces.dump(out);
+    CHECK(out.str().find("consume") != std::string::npos);
+    traces.clear();
+
+    auto quiet = token_it(lex_source("val y = 2;").drain());
+    (void)build_ast(quiet);
+    CHECK(traces.size() == 0);
+  }
+
+  TEST_CASE("tracing from several threads keeps records whole") {
+    if(!trace_compiled) return;
+    traces.clear();
+    traces.enable(trace_category::LEXER);
+    std::vector<std::thread> writers;
+    for(uint32_t t = 1; t <= 4; t++) {
+      writers.emplace_back([t] { // wraps the ring a few times
+        for(uint32_t i = 0; i < tracer::default_capacity; i++) {
+          trace(trace_category::LEXER, trace_event::TOKENS_LEXED, location{ t, i }, i, static_cast<uint16_t>(t));
+        }
+      });
+    }
+    for(auto &w : writers) w.join();
+    traces.disable_all();
+
+    REQUIRE(traces.size() == tracer::default_capacity);
+    size_t torn = 0;
+    for(size_t i = 0; i < traces.size(); i++) {
+      const auto r = traces.at(i);
+      if(r.detail != r.pos.offset || r.extra != r.pos.file) torn++;
+    }
+    CHECK(torn == 0);
+    traces.clear();
+  }
+
   TEST_CASE("valid statements") {
     logger.enable_throw_on_error();
     SUBCASE("trivial statements") {
@@ -885,23 +1311,23 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       auto res = parse_stmt(it);
       REQUIRE(res.has_value());
       CHECK(is<break_stmt>(res->content));
-      CHECK(is<keyword>(it->actual));
-      CHECK(as<keyword>(it->actual) == keyword::CONTINUE);
+      CHECK(is<keyword>(*it));
+      CHECK(as<keyword>(*it) == keyword::CONTINUE);
 
       // #2 -> continue;
       res = parse_stmt(it);
       REQUIRE(res.has_value());
       CHECK(is<continue_stmt>(res->content));
-      CHECK(is<keyword>(it->actual));
-      CHECK(as<keyword>(it->actual) == keyword::RETURN);
+      CHECK(is<keyword>(*it));
+      CHECK(as<keyword>(*it) == keyword::RETURN);
 
       // #3 -> return;
       res = parse_stmt(it);
       REQUIRE(res.has_value());
       REQUIRE(is<return_stmt>(res->content));
       CHECK_FALSE(as<return_stmt>(res->content).value.has_value());
-      CHECK(is<keyword>(it->actual));
-      CHECK(as<keyword>(it->actual) == keyword::RETURN);
+      CHECK(is<keyword>(*it));
+      CHECK(as<keyword>(*it) == keyword::RETURN);
 
       // #4 -> return x;
       res = parse_stmt(it);
@@ -911,7 +1337,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       const auto &ret_val = *as<return_stmt>(res->content).value;
       REQUIRE(is<name_expr>(ret_val.content));
       CHECK(as<name_expr>(ret_val.content).actual == single_name("x"));
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("statement block") {
@@ -927,8 +1353,8 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(res.has_value());
       REQUIRE(is<block>(res->content));
       CHECK(as<block>(res->content).statements.empty());
-      REQUIRE(is<symbol>(it->actual));
-      CHECK(as<symbol>(it->actual) == symbol::BRACE_OPEN);
+      REQUIRE(is<symbol>(*it));
+      CHECK(as<symbol>(*it) == symbol::BRACE_OPEN);
 
       // #2 -> { break; }
       res = parse_stmt(it);
@@ -937,7 +1363,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(as<block>(res->content).statements.size() == 1);
       const auto &first = as<block>(res->content).statements[0];
       CHECK(is<break_stmt>(first.content));
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("expression statements") {
@@ -986,7 +1412,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(is<literal_expr<int64_t>>(div.right->content));
       CHECK(as<literal_expr<int64_t>>(div.right->content).value == 2);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     // TODO: add typed variables, var vs val
@@ -1044,18 +1470,17 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(as<literal_expr<int64_t>>(expr2.right->content).value == 0);
       CHECK(expr2.op == binary_op::MUL_ASSIGN);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("if-else statements") {
-      location last = {"", 0, 0};
+      location last = {0, 0};
       static auto pos = [&last] {
-        last.col++;
+        last.offset++;
         return last;
       };
       static auto line = [&last] {
-        last.line++;
-        last.col = 0;
+        last.offset++; // skip the newline
         return last;
       };
 
@@ -1254,7 +1679,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(call8.args.empty());
       CHECK(!if7.false_block.has_value());
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("for vs for-each statements") {
@@ -1371,7 +1796,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       REQUIRE(call3.args.size() == 1);
       REQUIRE(is<name_expr>(call3.args[0].content));
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
 
     SUBCASE("while and do-while statements") {
@@ -1428,7 +1853,7 @@ TEST_SUITE("jayc - parser (parsing okay)") {
       CHECK(as<literal_expr<bool>>(while3.condition.content).value == false);
       CHECK(while3.is_do_while);
 
-      CHECK(is<eof>(it->actual));
+      CHECK(is<eof>(*it));
     }
   }
 
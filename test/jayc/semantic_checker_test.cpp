@@ -0,0 +1,58 @@
+//
+// Created by jay on 9/20/24.
+//
+
+#include <doctest/doctest.h>
+
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "semantic_checker/semantic_checker.hpp"
+
+using namespace jaydk;
+using namespace jayc;
+using namespace jayc::lexer;
+using namespace jayc::parser;
+using namespace jayc::sem;
+
+TEST_SUITE("jayc - semantic checker") {
+  TEST_CASE("hoisting namespaces and types") {
+    auto it = token_it(lex_source(
+      "namespace a { struct p { } namespace b { struct q { } } }\n"
+      "struct r { }\n"
+      "namespace a { fun f() => 1; }\n"
+    ).drain());
+    const auto module = build_ast(it);
+    REQUIRE(logger.phase_error() == 0);
+
+    const auto checked = check_semantics(module);
+    REQUIRE(checked.has_value());
+    const auto &root = checked->root_node();
+
+    const auto a = root[interned{"a"}];
+    REQUIRE(a.has_value());
+    CHECK(a->get()[interned{"b"}].has_value());
+
+    const auto p = root.lookup({ interned{"a"}, interned{"p"} });
+    const auto q = root.lookup({ interned{"a"}, interned{"b"}, interned{"q"} });
+    const auto r = root.lookup({ interned{"r"} });
+    CHECK(p.has_value());
+    CHECK(q.has_value());
+    CHECK(r.has_value());
+    CHECK(p != q);
+    CHECK(!root.lookup({ interned{"q"} }).has_value()); // only visible through b
+
+    // builtins and their aliases are defined, not just registered
+    const auto int_name = root.lookup({ interned{"int"} });
+    REQUIRE(int_name.has_value());
+    const auto int_type = checked->lookup_type(*int_name);
+    REQUIRE(int_type.has_value());
+    CHECK(int_type->get().get_name() == interned{"int"});
+    CHECK(is<primitive>(int_type->get().get_actual()));
+
+    const auto alias_name = root.lookup({ interned{"int64"} });
+    REQUIRE(alias_name.has_value());
+    const auto alias = checked->lookup_type(*alias_name);
+    REQUIRE(alias.has_value());
+    REQUIRE(is<type_alias>(alias->get().get_actual()));
+  }
+}